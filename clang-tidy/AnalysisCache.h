@@ -0,0 +1,66 @@
+//===--- AnalysisCache.h - clang-tidy ---------------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_TOOLS_EXTRA_CLANG_TIDY_ANALYSISCACHE_H
+#define LLVM_CLANG_TOOLS_EXTRA_CLANG_TIDY_ANALYSISCACHE_H
+
+#include "llvm/ADT/DenseMap.h"
+#include <memory>
+#include <utility>
+
+namespace clang {
+namespace tidy {
+
+/// \brief Stores the results of analyses of AST nodes, e.g. the CFG of a
+/// function, so that checks and matches that need the same analysis of the
+/// same node compute it only once.
+///
+/// The cache is owned by the \c ClangTidyContext and cleared at the end of
+/// each translation unit, as the results usually point into the AST.
+class AnalysisCache {
+public:
+  /// \brief Base class of the cached results.
+  ///
+  /// Each result type needs a unique address to identify it, by convention
+  /// the address of a \c static \c char \c ID member, like LLVM passes use.
+  class Result {
+  public:
+    virtual ~Result() {}
+  };
+
+  /// \brief Returns the result of type \p T for \p Node. If there is none yet,
+  /// stores and returns the result of \p Compute(), which must return a
+  /// \c std::unique_ptr<T>.
+  template <typename T, typename ComputeFn>
+  T &get(const void *Node, ComputeFn Compute) {
+    Key K(&T::ID, Node);
+    auto It = Results.find(K);
+    if (It != Results.end())
+      return static_cast<T &>(*It->second);
+    // Compute() may use the cache itself, only insert its result afterwards.
+    std::unique_ptr<T> Computed = Compute();
+    T &ComputedResult = *Computed;
+    Results[K] = std::move(Computed);
+    return ComputedResult;
+  }
+
+  /// \brief Drops all results.
+  void clear() { Results.clear(); }
+
+private:
+  /// \brief The ID of the result type and the node.
+  typedef std::pair<const void *, const void *> Key;
+
+  llvm::DenseMap<Key, std::unique_ptr<Result>> Results;
+};
+
+} // end namespace tidy
+} // end namespace clang
+
+#endif // LLVM_CLANG_TOOLS_EXTRA_CLANG_TIDY_ANALYSISCACHE_H
@@ -0,0 +1,87 @@
+//===--- CallMatcherIndex.cpp - clang-tidy --------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "CallMatcherIndex.h"
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/Expr.h"
+#include "clang/ASTMatchers/ASTMatchers.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+
+using namespace clang::ast_matchers;
+
+namespace clang {
+namespace tidy {
+
+CallMatcherIndex::CallMatcherIndex(MatchFinder &Finder) : Finder(Finder) {}
+
+void CallMatcherIndex::addMatcher(ArrayRef<StringRef> Names,
+                                  const StatementMatcher &Matcher,
+                                  MatchFinder::MatchCallback *Callback) {
+  // Only look at calls if anything is interested in them.
+  if (FindersByName.empty())
+    Finder.addMatcher(callExpr().bind("call"), this);
+  for (auto I = Names.begin(), E = Names.end(); I != E; ++I) {
+    // Don't run the matcher twice for a name that is given twice.
+    if (std::find(Names.begin(), I, *I) != I)
+      continue;
+    assert(I->startswith("::") && "names must be fully qualified");
+    StringRef Name = I->drop_front(2);
+    std::unique_ptr<MatchFinder> &NameFinder = FindersByName[Name];
+    if (!NameFinder) {
+      MatchFinder::MatchFinderOptions Options;
+      if (Profiling)
+        Options.CheckProfiling =
+            MatchFinder::MatchFinderOptions::Profiling(FinderRecords);
+      NameFinder = llvm::make_unique<MatchFinder>(std::move(Options));
+      size_t Qualifier = Name.rfind("::");
+      UnqualifiedNames.insert(Qualifier == StringRef::npos
+                                  ? Name
+                                  : Name.substr(Qualifier + 2));
+    }
+    NameFinder->addMatcher(Matcher, Callback);
+  }
+}
+
+void CallMatcherIndex::collectProfile(
+    llvm::StringMap<llvm::TimeRecord> &Records) {
+  Records.erase(getID());
+  for (const auto &Record : CallbackRecords)
+    Records[Record.getKey()] += Record.getValue();
+  CallbackRecords.clear();
+}
+
+void CallMatcherIndex::run(const MatchFinder::MatchResult &Result) {
+  const auto *Call = Result.Nodes.getNodeAs<CallExpr>("call");
+  const FunctionDecl *Callee = Call->getDirectCallee();
+  if (!Callee || !Callee->getIdentifier() ||
+      !UnqualifiedNames.count(Callee->getName()))
+    return;
+
+  // Print the name like hasName() does, without inline and anonymous
+  // namespaces.
+  SmallString<128> Name;
+  llvm::raw_svector_ostream OS(Name);
+  PrintingPolicy Policy(Result.Context->getLangOpts());
+  Policy.SuppressUnwrittenScope = true;
+  Callee->printQualifiedName(OS, Policy);
+  auto It = FindersByName.find(OS.str());
+  if (It == FindersByName.end())
+    return;
+
+  It->second->match(*Call, *Result.Context);
+  // The finder replaces its records on each run, keep the sum.
+  for (const auto &Record : FinderRecords)
+    CallbackRecords[Record.getKey()] += Record.getValue();
+  FinderRecords.clear();
+}
+
+} // end namespace tidy
+} // end namespace clang
@@ -0,0 +1,80 @@
+//===--- CallMatcherIndex.h - clang-tidy ------------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_TOOLS_EXTRA_CLANG_TIDY_CALLMATCHERINDEX_H
+#define LLVM_CLANG_TOOLS_EXTRA_CLANG_TIDY_CALLMATCHERINDEX_H
+
+#include "clang/ASTMatchers/ASTMatchFinder.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringSet.h"
+#include "llvm/Support/Timer.h"
+#include <memory>
+
+namespace clang {
+namespace tidy {
+
+/// \brief Runs matchers of calls only on calls to functions with the names they
+/// are registered for.
+///
+/// A \c MatchFinder runs every matcher whose root is a call on every call in
+/// the translation unit, so the cost of the checks looking for calls of
+/// particular functions grows with the number of such checks. The index adds a
+/// single call matcher to the \c MatchFinder, looks up the qualified name of
+/// the called function and runs only the matchers registered for that name.
+class CallMatcherIndex : public ast_matchers::MatchFinder::MatchCallback {
+public:
+  CallMatcherIndex(ast_matchers::MatchFinder &Finder);
+
+  /// \brief Runs \p Matcher with \p Callback on calls of functions named one of
+  /// \p Names, like \c MatchFinder::addMatcher().
+  ///
+  /// \p Names are the fully qualified names of the functions, starting with
+  /// "::" like in \c hasName(). The index only runs \p Matcher on calls of
+  /// these functions, so it only needs to match the rest of the call.
+  void addMatcher(ArrayRef<StringRef> Names,
+                  const ast_matchers::StatementMatcher &Matcher,
+                  ast_matchers::MatchFinder::MatchCallback *Callback);
+
+  /// \brief Records the time spent matching and running each callback, like
+  /// the check profiling of \c MatchFinder. Must be called before any matcher
+  /// is added.
+  void enableProfiling() {
+    assert(FindersByName.empty() && "matchers were added without profiling");
+    Profiling = true;
+  }
+
+  /// \brief Adds the time spent in each callback since the last call to
+  /// \p Records, keyed by the ID of the callback.
+  ///
+  /// \p Records are the records of the \c MatchFinder, whose record of the
+  /// index itself includes the time of the callbacks. It's removed, so that the
+  /// time is only reported for the checks.
+  void collectProfile(llvm::StringMap<llvm::TimeRecord> &Records);
+
+  void run(const ast_matchers::MatchFinder::MatchResult &Result) override;
+  StringRef getID() const override { return "<call-matcher-index>"; }
+
+private:
+  ast_matchers::MatchFinder &Finder;
+  /// \brief The matchers registered for each qualified name, without the
+  /// leading "::".
+  llvm::StringMap<std::unique_ptr<ast_matchers::MatchFinder>> FindersByName;
+  /// \brief The unqualified names of \c FindersByName, which rule out most
+  /// calls without printing the qualified name of the callee.
+  llvm::StringSet<> UnqualifiedNames;
+  bool Profiling = false;
+  /// \brief The records of the last run of one of \c FindersByName.
+  llvm::StringMap<llvm::TimeRecord> FinderRecords;
+  llvm::StringMap<llvm::TimeRecord> CallbackRecords;
+};
+
+} // end namespace tidy
+} // end namespace clang
+
+#endif // LLVM_CLANG_TOOLS_EXTRA_CLANG_TIDY_CALLMATCHERINDEX_H
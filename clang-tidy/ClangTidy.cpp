@@ -16,11 +16,13 @@
 //===----------------------------------------------------------------------===//
 
 #include "ClangTidy.h"
+#include "ClangTidyCache.h"
 #include "ClangTidyDiagnosticConsumer.h"
 #include "ClangTidyModuleRegistry.h"
 #include "clang/AST/ASTConsumer.h"
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/Decl.h"
+#include "clang/AST/RecursiveASTVisitor.h"
 #include "clang/ASTMatchers/ASTMatchFinder.h"
 #include "clang/Format/Format.h"
 #include "clang/Frontend/ASTConsumers.h"
@@ -39,9 +41,13 @@
 #include "clang/Tooling/Refactoring.h"
 #include "clang/Tooling/ReplacementsYaml.h"
 #include "clang/Tooling/Tooling.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Process.h"
 #include "llvm/Support/Signals.h"
 #include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
 #include <utility>
 
 using namespace clang::ast_matchers;
@@ -54,6 +60,14 @@ LLVM_INSTANTIATE_REGISTRY(clang::tidy::ClangTidyModuleRegistry)
 namespace clang {
 namespace tidy {
 
+/// \brief Returns the size of the heap in bytes if \p Profile tracks memory,
+/// and 0 otherwise.
+static int64_t getHeapSize(const ProfileData *Profile) {
+  if (!Profile || !Profile->TrackMemory)
+    return 0;
+  return llvm::sys::Process::GetMallocUsage();
+}
+
 namespace {
 static const char *AnalyzerCheckNamePrefix = "clang-analyzer-";
 
@@ -263,17 +277,394 @@ private:
   unsigned WarningsAsErrors;
 };
 
+/// \brief Returns true if the lines \p BeginLine to \p EndLine of \p FileName
+/// overlap \p LineFilter, or if the filter is empty.
+bool overlapsLineFilter(ArrayRef<FileFilter> LineFilter, StringRef FileName,
+                        unsigned BeginLine, unsigned EndLine) {
+  if (LineFilter.empty())
+    return true;
+  for (const FileFilter &Filter : LineFilter) {
+    if (FileName.endswith(Filter.Name)) {
+      if (Filter.LineRanges.empty())
+        return true;
+      for (const FileFilter::LineRange &Range : Filter.LineRanges) {
+        if (Range.first <= EndLine && BeginLine <= Range.second)
+          return true;
+      }
+      return false;
+    }
+  }
+  return false;
+}
+
+/// \brief Returns false if \p D is entirely in one file and outside of the
+/// lines of this file in \p LineFilter.
+bool overlapsLineFilter(ArrayRef<FileFilter> LineFilter, const Decl *D,
+                        const SourceManager &SM) {
+  if (LineFilter.empty())
+    return true;
+  SourceLocation Begin = SM.getExpansionLoc(D->getLocStart());
+  SourceLocation End = SM.getExpansionLoc(D->getLocEnd());
+  if (Begin.isInvalid() || End.isInvalid())
+    return true;
+  FileID FID = SM.getFileID(Begin);
+  if (FID != SM.getFileID(End))
+    return true;
+  const FileEntry *File = SM.getFileEntryForID(FID);
+  if (!File)
+    return true;
+  return overlapsLineFilter(LineFilter, File->getName(),
+                            SM.getExpansionLineNumber(Begin),
+                            SM.getExpansionLineNumber(End));
+}
+
+/// \brief Passes only the top-level declarations that overlap the line filter
+/// to the static analyzer. It doesn't analyze functions whose diagnostics would
+/// all be discarded then, though they are still inlined into the analyzed
+/// functions.
+class LineFilteredAnalysisConsumer : public ASTConsumer {
+public:
+  LineFilteredAnalysisConsumer(std::unique_ptr<ASTConsumer> Analyzer,
+                               ArrayRef<FileFilter> LineFilter)
+      : Analyzer(std::move(Analyzer)), LineFilter(LineFilter) {}
+
+  void Initialize(ASTContext &Ctx) override {
+    SM = &Ctx.getSourceManager();
+    Analyzer->Initialize(Ctx);
+  }
+
+  bool HandleTopLevelDecl(DeclGroupRef DG) override {
+    for (Decl *D : DG) {
+      if (overlapsLineFilter(LineFilter, D, *SM))
+        Analyzer->HandleTopLevelDecl(DeclGroupRef(D));
+    }
+    return true;
+  }
+
+  void HandleTopLevelDeclInObjCContainer(DeclGroupRef DG) override {
+    for (Decl *D : DG) {
+      if (overlapsLineFilter(LineFilter, D, *SM))
+        Analyzer->HandleTopLevelDeclInObjCContainer(DeclGroupRef(D));
+    }
+  }
+
+  void HandleTranslationUnit(ASTContext &Ctx) override {
+    Analyzer->HandleTranslationUnit(Ctx);
+  }
+
+private:
+  std::unique_ptr<ASTConsumer> Analyzer;
+  ArrayRef<FileFilter> LineFilter;
+  const SourceManager *SM = nullptr;
+};
+
+/// \brief Traverses a subtree of the AST like MatchFinder::matchAST() does,
+/// and runs the matchers of the MatchFinder on every node.
+class MatchingVisitor : public RecursiveASTVisitor<MatchingVisitor> {
+  typedef RecursiveASTVisitor<MatchingVisitor> Base;
+
+public:
+  MatchingVisitor(MatchFinder &Finder, CallMatcherIndex &CallMatchers,
+                  ASTContext &Context,
+                  llvm::StringMap<llvm::TimeRecord> *FinderRecords,
+                  ProfileData *Profile)
+      : Finder(Finder), CallMatchers(CallMatchers), Context(Context),
+        FinderRecords(FinderRecords), Profile(Profile) {}
+
+  bool shouldVisitTemplateInstantiations() const { return true; }
+  bool shouldVisitImplicitCode() const { return true; }
+
+  bool TraverseDecl(Decl *D) {
+    if (!D)
+      return true;
+    match(*D);
+    return Base::TraverseDecl(D);
+  }
+  bool TraverseStmt(Stmt *S) {
+    if (!S)
+      return true;
+    match(*S);
+    return Base::TraverseStmt(S);
+  }
+  bool TraverseType(QualType T) {
+    if (!T.isNull())
+      match(T);
+    return Base::TraverseType(T);
+  }
+  bool TraverseTypeLoc(TypeLoc TL) {
+    if (TL.isNull())
+      return true;
+    // Types within TypeLocs are not traversed separately, match them here.
+    match(TL);
+    match(TL.getType());
+    return Base::TraverseTypeLoc(TL);
+  }
+  bool TraverseNestedNameSpecifier(NestedNameSpecifier *NNS) {
+    if (NNS)
+      match(*NNS);
+    return Base::TraverseNestedNameSpecifier(NNS);
+  }
+  bool TraverseNestedNameSpecifierLoc(NestedNameSpecifierLoc NNS) {
+    if (!NNS)
+      return true;
+    match(NNS);
+    match(*NNS.getNestedNameSpecifier());
+    return Base::TraverseNestedNameSpecifierLoc(NNS);
+  }
+  bool TraverseConstructorInitializer(CXXCtorInitializer *CtorInit) {
+    if (CtorInit)
+      match(*CtorInit);
+    return Base::TraverseConstructorInitializer(CtorInit);
+  }
+
+  template <typename T> void match(const T &Node) {
+    Finder.match(Node, Context);
+    collectProfile();
+  }
+
+  /// \brief Adds the profiling records of the last match to the profile. The
+  /// MatchFinder replaces them on every match.
+  void collectProfile() {
+    if (!FinderRecords)
+      return;
+    CallMatchers.collectProfile(*FinderRecords);
+    for (const auto &Record : *FinderRecords)
+      Profile->Records[Record.getKey()] += Record.getValue();
+    FinderRecords->clear();
+  }
+
+private:
+  MatchFinder &Finder;
+  CallMatcherIndex &CallMatchers;
+  ASTContext &Context;
+  llvm::StringMap<llvm::TimeRecord> *FinderRecords;
+  ProfileData *Profile;
+};
+
+/// \brief Runs the matchers of the checks on a translation unit.
+///
+/// Diagnostics from system headers and from headers that don't match the header
+/// filter are discarded. The matchers are not run on top-level declarations
+/// that can only produce such diagnostics, which usually are most of the
+/// declarations in a translation unit. The skipped declarations are counted in
+/// \c ClangTidyStats::DeclsSkippedNonUserCode. Checks that need matches in all
+/// headers, e.g. because their notes can point to user code, are run on all
+/// declarations by a separate \c MatchFinder.
+///
+/// Declarations loaded from a precompiled preamble are filtered in the same
+/// way, so the results don't depend on whether a preamble is used.
+class ClangTidyMatchConsumer : public ASTConsumer {
+public:
+  ClangTidyMatchConsumer(ClangTidyContext &Context)
+      : Context(Context), UserCodeMatchers(Context), AllMatchers(Context),
+        HeaderFilter(*Context.getOptions().HeaderFilterRegex) {}
+
+  /// \brief Registers the matchers of \p Check.
+  void addCheck(ClangTidyCheck *Check) {
+    MatcherGroup &Group =
+        Check->needsMatchesInAllHeaders() ? AllMatchers : UserCodeMatchers;
+    Check->registerMatchers(&Group.Finder);
+    Check->registerCallMatchers(&Group.CallMatchers);
+    Group.Checks.push_back(Check);
+  }
+
+  /// \brief Returns the time spent matching the last translation unit. Only
+  /// measured if profiling is enabled.
+  const llvm::TimeRecord &getMatchTime() const { return MatchTime; }
+  /// \brief Returns the growth of the heap while matching the last translation
+  /// unit. Only measured if the profile tracks memory.
+  int64_t getMatchMemory() const { return MatchMemory; }
+
+  void HandleTranslationUnit(ASTContext &Ctx) override {
+    ProfileData *Profile = Context.getCheckProfileData();
+    if (Profile) {
+      MatchTime = llvm::TimeRecord();
+      MatchTime -= llvm::TimeRecord::getCurrentTime(/*Start=*/true);
+      MatchMemory = -getHeapSize(Profile);
+    }
+    matchTranslationUnit(Ctx);
+    if (Profile) {
+      MatchTime += llvm::TimeRecord::getCurrentTime(/*Start=*/false);
+      MatchMemory += getHeapSize(Profile);
+    }
+    // The cached analyses point into the AST, which is about to go away.
+    Context.getAnalysisCache().clear();
+  }
+
+private:
+  /// \brief The matchers of the checks that are run on the same top-level
+  /// declarations.
+  struct MatcherGroup {
+    MatcherGroup(ClangTidyContext &Context)
+        : Finder(createFinderOptions(Context, FinderRecords)),
+          CallMatchers(Finder) {
+      if (Context.getCheckProfileData())
+        CallMatchers.enableProfiling();
+    }
+
+    /// \brief The profiling records of the last match, if profiling is
+    /// enabled.
+    llvm::StringMap<llvm::TimeRecord> FinderRecords;
+    MatchFinder Finder;
+    CallMatcherIndex CallMatchers;
+    std::vector<ClangTidyCheck *> Checks;
+  };
+
+  void matchTranslationUnit(ASTContext &Ctx) {
+    TranslationUnitDecl *TU = Ctx.getTranslationUnitDecl();
+    SmallVector<Decl *, 64> Decls;
+    SmallVector<Decl *, 64> UserDecls;
+    unsigned NumDecls = 0;
+    for (Decl *D : TU->decls()) {
+      // Like RecursiveASTVisitor, skip blocks, they are traversed with the
+      // expressions containing them.
+      if (isa<BlockDecl>(D) || isa<CapturedDecl>(D))
+        continue;
+      ++NumDecls;
+      Decls.push_back(D);
+      if (!UserCodeMatchers.Checks.empty() &&
+          isInUserCode(D, Ctx.getSourceManager()))
+        UserDecls.push_back(D);
+    }
+
+    matchDecls(AllMatchers, Decls, NumDecls, Ctx);
+    matchDecls(UserCodeMatchers, UserDecls, NumDecls, Ctx);
+    if (!UserCodeMatchers.Checks.empty() && UserDecls.size() != Decls.size()) {
+      ClangTidyStats Stats;
+      Stats.DeclsSkippedNonUserCode = Decls.size() - UserDecls.size();
+      Context.addResults(None, Stats);
+    }
+  }
+
+  /// \brief Runs the matchers of \p Group on \p Decls, which are the
+  /// top-level declarations of \p Ctx that were not skipped.
+  void matchDecls(MatcherGroup &Group, ArrayRef<Decl *> Decls,
+                  unsigned NumDecls, ASTContext &Ctx) {
+    if (Group.Checks.empty())
+      return;
+    ProfileData *Profile = Context.getCheckProfileData();
+    if (Profile) {
+      for (ClangTidyCheck *Check : Group.Checks) {
+        CheckProfile &CheckData = Profile->Checks[Check->getID()];
+        CheckData.DeclsMatched += Decls.size();
+        CheckData.DeclsSkipped += NumDecls - Decls.size();
+      }
+    }
+
+    MatchingVisitor Visitor(Group.Finder, Group.CallMatchers, Ctx,
+                            Profile ? &Group.FinderRecords : nullptr, Profile);
+    // If nothing is skipped, let the MatchFinder traverse the AST itself, it
+    // shares more work between the nodes.
+    if (Decls.size() == NumDecls) {
+      Group.Finder.matchAST(Ctx);
+      Visitor.collectProfile();
+      return;
+    }
+
+    for (ClangTidyCheck *Check : Group.Checks)
+      Check->onStartOfTranslationUnit();
+    Visitor.match(*Ctx.getTranslationUnitDecl());
+    for (Decl *D : Decls)
+      Visitor.TraverseDecl(D);
+    for (ClangTidyCheck *Check : Group.Checks)
+      Check->onEndOfTranslationUnit();
+  }
+
+  static MatchFinder::MatchFinderOptions
+  createFinderOptions(ClangTidyContext &Context,
+                      llvm::StringMap<llvm::TimeRecord> &Records) {
+    MatchFinder::MatchFinderOptions FinderOptions;
+    if (Context.getCheckProfileData())
+      FinderOptions.CheckProfiling.emplace(Records);
+    return FinderOptions;
+  }
+
+  /// \brief Returns false if \p D is entirely in a file whose diagnostics are
+  /// discarded by ClangTidyDiagnosticConsumer.
+  ///
+  /// The line filter is not applied, it usually selects a few lines of the
+  /// files it names, and declarations outside of it are counted as suppressed
+  /// warnings only if they produce any.
+  bool isInUserCode(const Decl *D, const SourceManager &SM) {
+    SourceLocation Begin = SM.getExpansionLoc(D->getLocStart());
+    SourceLocation End = SM.getExpansionLoc(D->getLocEnd());
+    // Keep implicit declarations and declarations spanning several files.
+    if (Begin.isInvalid() || End.isInvalid())
+      return true;
+    FileID FID = SM.getFileID(Begin);
+    if (FID != SM.getFileID(End))
+      return true;
+
+    if (!*Context.getOptions().SystemHeaders && SM.isInSystemHeader(Begin))
+      return false;
+    if (SM.isInMainFile(Begin))
+      return true;
+    // -DMACRO definitions on the command line don't have a FileEntry.
+    const FileEntry *File = SM.getFileEntryForID(FID);
+    return !File || HeaderFilter.match(File->getName());
+  }
+
+  ClangTidyContext &Context;
+  /// \brief The checks whose matches outside of user code are discarded.
+  MatcherGroup UserCodeMatchers;
+  /// \brief The checks that need matches in all headers.
+  MatcherGroup AllMatchers;
+  llvm::Regex HeaderFilter;
+  llvm::TimeRecord MatchTime;
+  int64_t MatchMemory = 0;
+};
+
 class ClangTidyASTConsumer : public MultiplexConsumer {
 public:
-  ClangTidyASTConsumer(std::vector<std::unique_ptr<ASTConsumer>> Consumers,
-                       std::unique_ptr<ast_matchers::MatchFinder> Finder,
-                       std::vector<std::unique_ptr<ClangTidyCheck>> Checks)
-      : MultiplexConsumer(std::move(Consumers)), Finder(std::move(Finder)),
-        Checks(std::move(Checks)) {}
+  /// \p MatchConsumer is the consumer in \p Consumers that runs the matchers
+  /// of \p Checks, if any.
+  ClangTidyASTConsumer(ClangTidyContext &Context,
+                       std::vector<std::unique_ptr<ASTConsumer>> Consumers,
+                       std::vector<std::unique_ptr<ClangTidyCheck>> Checks,
+                       const ClangTidyMatchConsumer *MatchConsumer)
+      : MultiplexConsumer(std::move(Consumers)), Context(Context),
+        Checks(std::move(Checks)), MatchConsumer(MatchConsumer) {
+    // The consumer is created right before the parsing starts.
+    if (ProfileData *Profile = Context.getCheckProfileData()) {
+      Start = llvm::TimeRecord::getCurrentTime(/*Start=*/true);
+      StartMemory = getHeapSize(Profile);
+    }
+  }
+
+  void HandleTranslationUnit(ASTContext &Ctx) override {
+    ProfileData *Profile = Context.getCheckProfileData();
+    if (!Profile) {
+      MultiplexConsumer::HandleTranslationUnit(Ctx);
+      return;
+    }
+
+    TranslationUnitProfile TU;
+    TU.File = Context.getCurrentFile();
+    TU.StartTime = Start.getWallTime();
+    TU.Frontend = llvm::TimeRecord::getCurrentTime(/*Start=*/false);
+    TU.Frontend -= Start;
+    int64_t Memory = getHeapSize(Profile);
+    TU.FrontendMemory = Memory - StartMemory;
+    // The other consumer is the static analyzer.
+    TU.Analyzer -= llvm::TimeRecord::getCurrentTime(/*Start=*/true);
+    MultiplexConsumer::HandleTranslationUnit(Ctx);
+    TU.Analyzer += llvm::TimeRecord::getCurrentTime(/*Start=*/false);
+    TU.AnalyzerMemory = getHeapSize(Profile) - Memory;
+    if (MatchConsumer) {
+      TU.Checks = MatchConsumer->getMatchTime();
+      TU.Analyzer -= TU.Checks;
+      TU.ChecksMemory = MatchConsumer->getMatchMemory();
+      TU.AnalyzerMemory -= TU.ChecksMemory;
+    }
+    Profile->TranslationUnits.push_back(std::move(TU));
+  }
 
 private:
-  std::unique_ptr<ast_matchers::MatchFinder> Finder;
+  ClangTidyContext &Context;
   std::vector<std::unique_ptr<ClangTidyCheck>> Checks;
+  const ClangTidyMatchConsumer *MatchConsumer;
+  llvm::TimeRecord Start;
+  int64_t StartMemory = 0;
 };
 
 } // namespace
@@ -339,31 +730,33 @@ ClangTidyASTConsumerFactory::CreateASTConsumer(
   Context.setCurrentFile(File);
   Context.setASTContext(&Compiler.getASTContext());
 
-  auto WorkingDir = Compiler.getSourceManager()
-                        .getFileManager()
-                        .getVirtualFileSystem()
-                        ->getCurrentWorkingDirectory();
-  if (WorkingDir)
-    Context.setCurrentBuildDirectory(WorkingDir.get());
+  // Parallel runs don't change the working directory of the process, they
+  // set the working directory of the FileManager instead.
+  FileManager &Files = Compiler.getSourceManager().getFileManager();
+  if (!Files.getFileSystemOpts().WorkingDir.empty()) {
+    Context.setCurrentBuildDirectory(Files.getFileSystemOpts().WorkingDir);
+  } else {
+    auto WorkingDir =
+        Files.getVirtualFileSystem()->getCurrentWorkingDirectory();
+    if (WorkingDir)
+      Context.setCurrentBuildDirectory(WorkingDir.get());
+  }
 
   std::vector<std::unique_ptr<ClangTidyCheck>> Checks;
   CheckFactories->createChecks(&Context, Checks);
 
-  ast_matchers::MatchFinder::MatchFinderOptions FinderOptions;
-  if (auto *P = Context.getCheckProfileData())
-    FinderOptions.CheckProfiling.emplace(P->Records);
-
-  std::unique_ptr<ast_matchers::MatchFinder> Finder(
-      new ast_matchers::MatchFinder(std::move(FinderOptions)));
-
+  auto MatchConsumer = llvm::make_unique<ClangTidyMatchConsumer>(Context);
   for (auto &Check : Checks) {
-    Check->registerMatchers(&*Finder);
+    MatchConsumer->addCheck(Check.get());
     Check->registerPPCallbacks(Compiler);
   }
 
   std::vector<std::unique_ptr<ASTConsumer>> Consumers;
-  if (!Checks.empty())
-    Consumers.push_back(Finder->newASTConsumer());
+  const ClangTidyMatchConsumer *MatchConsumerPtr = nullptr;
+  if (!Checks.empty()) {
+    MatchConsumerPtr = MatchConsumer.get();
+    Consumers.push_back(std::move(MatchConsumer));
+  }
 
   AnalyzerOptionsRef AnalyzerOptions = Compiler.getAnalyzerOpts();
   // FIXME: Remove this option once clang's cfg-temporary-dtors option defaults
@@ -383,10 +776,15 @@ ClangTidyASTConsumerFactory::CreateASTConsumer(
         ento::CreateAnalysisConsumer(Compiler);
     AnalysisConsumer->AddDiagnosticConsumer(
         new AnalyzerDiagnosticConsumer(Context));
-    Consumers.push_back(std::move(AnalysisConsumer));
+    const auto &LineFilter = Context.getGlobalOptions().LineFilter;
+    if (LineFilter.empty())
+      Consumers.push_back(std::move(AnalysisConsumer));
+    else
+      Consumers.push_back(llvm::make_unique<LineFilteredAnalysisConsumer>(
+          std::move(AnalysisConsumer), LineFilter));
   }
   return llvm::make_unique<ClangTidyASTConsumer>(
-      std::move(Consumers), std::move(Finder), std::move(Checks));
+      Context, std::move(Consumers), std::move(Checks), MatchConsumerPtr);
 }
 
 std::vector<std::string> ClangTidyASTConsumerFactory::getCheckNames() {
@@ -415,12 +813,25 @@ ClangTidyOptions::OptionMap ClangTidyASTConsumerFactory::getCheckOptions() {
 
 DiagnosticBuilder ClangTidyCheck::diag(SourceLocation Loc, StringRef Message,
                                        DiagnosticIDs::Level Level) {
+  if (ProfileData *Profile = Context->getCheckProfileData())
+    ++Profile->Checks[CheckName].Diagnostics;
   return Context->diag(CheckName, Loc, Message, Level);
 }
 
 void ClangTidyCheck::run(const ast_matchers::MatchFinder::MatchResult &Result) {
   Context->setSourceManager(Result.SourceManager);
+  ProfileData *Profile = Context->getCheckProfileData();
+  if (!Profile) {
+    check(Result);
+    return;
+  }
+  CheckProfile &CheckData = Profile->Checks[CheckName];
+  ++CheckData.Matches;
+  CheckData.Callbacks -= llvm::TimeRecord::getCurrentTime(/*Start=*/true);
+  CheckData.CallbackMemory -= getHeapSize(Profile);
   check(Result);
+  CheckData.Callbacks += llvm::TimeRecord::getCurrentTime(/*Start=*/false);
+  CheckData.CallbackMemory += getHeapSize(Profile);
 }
 
 OptionsView::OptionsView(StringRef CheckName,
@@ -472,11 +883,7 @@ ClangTidyOptions::OptionMap getCheckOptions(const ClangTidyOptions &Options) {
   return Factory.getCheckOptions();
 }
 
-void runClangTidy(clang::tidy::ClangTidyContext &Context,
-                  const CompilationDatabase &Compilations,
-                  ArrayRef<std::string> InputFiles, ProfileData *Profile) {
-  ClangTool Tool(Compilations, InputFiles);
-
+ArgumentsAdjuster getClangTidyArgumentsAdjuster(ClangTidyContext &Context) {
   // Add extra arguments passed by the clang-tidy command-line.
   ArgumentsAdjuster PerFileExtraArgumentsInserter =
       [&Context](const CommandLineArguments &Args, StringRef Filename) {
@@ -511,36 +918,271 @@ void runClangTidy(clang::tidy::ClangTidyContext &Context,
         return AdjustedArgs;
       };
 
-  Tool.appendArgumentsAdjuster(PerFileExtraArgumentsInserter);
-  Tool.appendArgumentsAdjuster(PluginArgumentsRemover);
-  if (Profile)
-    Context.setCheckProfileData(Profile);
+  return combineAdjusters(PerFileExtraArgumentsInserter,
+                          PluginArgumentsRemover);
+}
 
-  ClangTidyDiagnosticConsumer DiagConsumer(Context);
+namespace {
 
-  Tool.setDiagnosticConsumer(&DiagConsumer);
+class ActionFactory : public FrontendActionFactory {
+public:
+  ActionFactory(ClangTidyContext &Context)
+      : ConsumerFactory(Context), Dependencies(nullptr) {}
+  FrontendAction *create() override { return new Action(this); }
+
+  /// \brief If \p Deps is not null, the absolute paths of the files of the
+  /// following translation units are added to it.
+  void collectDependencies(std::vector<std::string> *Deps) {
+    Dependencies = Deps;
+  }
 
-  class ActionFactory : public FrontendActionFactory {
+private:
+  class Action : public ASTFrontendAction {
   public:
-    ActionFactory(ClangTidyContext &Context) : ConsumerFactory(Context) {}
-    FrontendAction *create() override { return new Action(&ConsumerFactory); }
+    Action(ActionFactory *Factory) : Factory(Factory) {}
+    std::unique_ptr<ASTConsumer> CreateASTConsumer(CompilerInstance &Compiler,
+                                                   StringRef File) override {
+      return Factory->ConsumerFactory.CreateASTConsumer(Compiler, File);
+    }
+
+    void EndSourceFileAction() override {
+      if (!Factory->Dependencies)
+        return;
+      SourceManager &SM = getCompilerInstance().getSourceManager();
+      for (auto It = SM.fileinfo_begin(), End = SM.fileinfo_end(); It != End;
+           ++It) {
+        SmallString<128> Path(It->first->getName());
+        SM.getFileManager().makeAbsolutePath(Path);
+        Factory->Dependencies->push_back(Path.str());
+      }
+    }
 
   private:
-    class Action : public ASTFrontendAction {
-    public:
-      Action(ClangTidyASTConsumerFactory *Factory) : Factory(Factory) {}
-      std::unique_ptr<ASTConsumer> CreateASTConsumer(CompilerInstance &Compiler,
-                                                     StringRef File) override {
-        return Factory->CreateASTConsumer(Compiler, File);
+    ActionFactory *Factory;
+  };
+
+  ClangTidyASTConsumerFactory ConsumerFactory;
+  std::vector<std::string> *Dependencies;
+};
+
+/// \brief Provides the options of a \c ClangTidyContext to the contexts of
+/// worker threads. Options providers cache configuration files and are not
+/// thread-safe, so all accesses are serialized.
+class SynchronizedOptionsProvider : public ClangTidyOptionsProvider {
+public:
+  SynchronizedOptionsProvider(ClangTidyContext &Context, std::mutex &Lock)
+      : Context(Context), Lock(Lock) {}
+
+  const ClangTidyGlobalOptions &getGlobalOptions() override {
+    // Global options are not modified after construction.
+    return Context.getGlobalOptions();
+  }
+
+  std::vector<OptionsSource> getRawOptions(StringRef FileName) override {
+    std::lock_guard<std::mutex> Guard(Lock);
+    return {OptionsSource(Context.getOptionsForFile(FileName),
+                          OptionsSourceTypeDefaultBinary)};
+  }
+
+private:
+  ClangTidyContext &Context;
+  std::mutex &Lock;
+};
+
+/// \brief Returns the statistics collected between \p Before and \p After.
+ClangTidyStats getStatsSince(const ClangTidyStats &Before,
+                             const ClangTidyStats &After) {
+  ClangTidyStats Stats;
+  Stats.ErrorsDisplayed = After.ErrorsDisplayed - Before.ErrorsDisplayed;
+  Stats.ErrorsIgnoredCheckFilter =
+      After.ErrorsIgnoredCheckFilter - Before.ErrorsIgnoredCheckFilter;
+  Stats.ErrorsIgnoredNOLINT =
+      After.ErrorsIgnoredNOLINT - Before.ErrorsIgnoredNOLINT;
+  Stats.ErrorsIgnoredNonUserCode =
+      After.ErrorsIgnoredNonUserCode - Before.ErrorsIgnoredNonUserCode;
+  Stats.ErrorsIgnoredLineFilter =
+      After.ErrorsIgnoredLineFilter - Before.ErrorsIgnoredLineFilter;
+  Stats.DeclsSkippedNonUserCode =
+      After.DeclsSkippedNonUserCode - Before.DeclsSkippedNonUserCode;
+  return Stats;
+}
+
+/// \brief Runs \p Factory on all compile commands of \p File and collects
+/// the results in \p Context. If \p Cache is not null, the results of compile
+/// commands are read from it if possible, and stored in it otherwise.
+///
+/// Unlike \c ClangTool, this doesn't change the working directory of the
+/// process, so it can be used from several threads at the same time. The
+/// directory of the compile command is passed to the compiler instead.
+void runOnFile(StringRef File, const CompilationDatabase &Compilations,
+               const ArgumentsAdjuster &Adjuster, ActionFactory &Factory,
+               DiagnosticConsumer &DiagConsumer, ClangTidyContext &Context,
+               const ClangTidyCache *Cache, std::mutex &ErrsLock) {
+  static int StaticSymbol;
+  std::string MainExecutable =
+      llvm::sys::fs::getMainExecutable("clang_tool", &StaticSymbol);
+
+  std::string AbsolutePath = getAbsolutePath(File);
+  std::vector<CompileCommand> CompileCommands =
+      Compilations.getCompileCommands(AbsolutePath);
+  if (CompileCommands.empty()) {
+    std::lock_guard<std::mutex> Guard(ErrsLock);
+    llvm::errs() << "Skipping " << AbsolutePath
+                 << ". Compile command not found.\n";
+    return;
+  }
+
+  for (CompileCommand &Command : CompileCommands) {
+    CommandLineArguments CommandLine =
+        Adjuster(Command.CommandLine, Command.Filename);
+    assert(!CommandLine.empty());
+    CommandLine[0] = MainExecutable;
+    CommandLine.insert(CommandLine.begin() + 1,
+                       "-working-directory=" + Command.Directory);
+
+    std::string CacheKey;
+    if (Cache) {
+      CacheKey = ClangTidyCache::getKey(CommandLine, Command.Directory,
+                                        Context.getOptionsForFile(AbsolutePath),
+                                        Context.getGlobalOptions());
+      std::vector<ClangTidyError> Errors;
+      ClangTidyStats Stats;
+      if (Cache->lookup(CacheKey, Errors, Stats)) {
+        Stats.CacheHits = 1;
+        Context.addResults(Errors, Stats);
+        continue;
       }
+    }
+    size_t FirstError = Context.getErrors().size();
+    ClangTidyStats StatsBefore = Context.getStats();
+    std::vector<std::string> Dependencies;
+    Factory.collectDependencies(Cache ? &Dependencies : nullptr);
+
+    FileSystemOptions FileSystemOpts;
+    FileSystemOpts.WorkingDir = Command.Directory;
+    IntrusiveRefCntPtr<FileManager> Files(new FileManager(FileSystemOpts));
+    ToolInvocation Invocation(std::move(CommandLine), &Factory, Files.get(),
+                              std::make_shared<PCHContainerOperations>());
+    Invocation.setDiagnosticConsumer(&DiagConsumer);
+    bool Success = Invocation.run();
+    if (!Success) {
+      std::lock_guard<std::mutex> Guard(ErrsLock);
+      llvm::errs() << "Error while processing " << AbsolutePath << ".\n";
+    }
 
-    private:
-      ClangTidyASTConsumerFactory *Factory;
-    };
+    if (Cache) {
+      // Failed runs are repeated, so that their errors are reported again.
+      if (Success)
+        Cache->store(CacheKey, Dependencies,
+                     Context.getErrors().slice(FirstError),
+                     getStatsSince(StatsBefore, Context.getStats()));
+      ClangTidyStats Stats;
+      Stats.CacheMisses = 1;
+      Context.addResults(None, Stats);
+    }
+  }
+}
 
-    ClangTidyASTConsumerFactory ConsumerFactory;
+/// \brief Processes \p InputFiles on \p NumThreads threads. Each thread has its
+/// own \c ClangTidyContext and takes the next file when it's done with the
+/// previous one. The errors are added to \p Context in the order of
+/// \p InputFiles, so the result doesn't depend on the scheduling.
+///
+/// This is also used with a single thread if results are cached, as it handles
+/// each file separately.
+void runClangTidyInParallel(ClangTidyContext &Context,
+                            const CompilationDatabase &Compilations,
+                            ArrayRef<std::string> InputFiles,
+                            ProfileData *Profile, unsigned NumThreads,
+                            const ClangTidyCache *Cache) {
+  std::mutex OptionsLock, ErrsLock;
+  std::atomic<size_t> NextFile(0);
+  std::vector<std::vector<ClangTidyError>> FileErrors(InputFiles.size());
+  std::vector<ClangTidyStats> ThreadStats(NumThreads);
+  std::vector<ProfileData> ThreadProfiles(NumThreads);
+  for (ProfileData &ThreadProfile : ThreadProfiles)
+    ThreadProfile.TrackMemory = Profile && Profile->TrackMemory;
+
+  auto Worker = [&](unsigned ThreadIndex) {
+    ClangTidyContext ThreadContext(
+        llvm::make_unique<SynchronizedOptionsProvider>(Context, OptionsLock));
+    if (Profile)
+      ThreadContext.setCheckProfileData(&ThreadProfiles[ThreadIndex]);
+    ClangTidyDiagnosticConsumer DiagConsumer(ThreadContext);
+    ActionFactory Factory(ThreadContext);
+    ArgumentsAdjuster Adjuster = combineAdjusters(
+        combineAdjusters(getClangStripOutputAdjuster(),
+                         getClangSyntaxOnlyAdjuster()),
+        getClangTidyArgumentsAdjuster(ThreadContext));
+
+    for (size_t I = NextFile++; I < InputFiles.size(); I = NextFile++) {
+      runOnFile(InputFiles[I], Compilations, Adjuster, Factory, DiagConsumer,
+                ThreadContext, Cache, ErrsLock);
+      ArrayRef<ClangTidyError> Errors = ThreadContext.getErrors();
+      FileErrors[I].assign(Errors.begin(), Errors.end());
+      ThreadContext.clearErrors();
+    }
+    ThreadStats[ThreadIndex] = ThreadContext.getStats();
   };
 
+  std::vector<std::thread> Threads;
+  for (unsigned I = 0; I < NumThreads; ++I)
+    Threads.emplace_back(Worker, I);
+  for (std::thread &Thread : Threads)
+    Thread.join();
+
+  for (const std::vector<ClangTidyError> &Errors : FileErrors)
+    Context.addResults(Errors, ClangTidyStats());
+  for (const ClangTidyStats &Stats : ThreadStats)
+    Context.addResults(None, Stats);
+  if (Profile) {
+    for (unsigned Thread = 0; Thread < NumThreads; ++Thread) {
+      const ProfileData &ThreadProfile = ThreadProfiles[Thread];
+      for (const auto &Record : ThreadProfile.Records)
+        Profile->Records[Record.getKey()] += Record.getValue();
+      for (const auto &Check : ThreadProfile.Checks) {
+        CheckProfile &CheckData = Profile->Checks[Check.getKey()];
+        CheckData.Callbacks += Check.getValue().Callbacks;
+        CheckData.CallbackMemory += Check.getValue().CallbackMemory;
+        CheckData.Matches += Check.getValue().Matches;
+        CheckData.Diagnostics += Check.getValue().Diagnostics;
+        CheckData.DeclsMatched += Check.getValue().DeclsMatched;
+        CheckData.DeclsSkipped += Check.getValue().DeclsSkipped;
+      }
+      for (TranslationUnitProfile TU : ThreadProfile.TranslationUnits) {
+        TU.Thread = Thread;
+        Profile->TranslationUnits.push_back(std::move(TU));
+      }
+    }
+  }
+}
+} // namespace
+
+std::unique_ptr<FrontendActionFactory>
+createClangTidyActionFactory(ClangTidyContext &Context) {
+  return llvm::make_unique<ActionFactory>(Context);
+}
+
+void runClangTidy(clang::tidy::ClangTidyContext &Context,
+                  const CompilationDatabase &Compilations,
+                  ArrayRef<std::string> InputFiles, ProfileData *Profile,
+                  unsigned NumThreads, const ClangTidyCache *Cache) {
+  NumThreads = std::min<size_t>(NumThreads, InputFiles.size());
+  if (NumThreads > 1 || Cache) {
+    runClangTidyInParallel(Context, Compilations, InputFiles, Profile,
+                           std::max(NumThreads, 1u), Cache);
+    return;
+  }
+
+  ClangTool Tool(Compilations, InputFiles);
+  Tool.appendArgumentsAdjuster(getClangTidyArgumentsAdjuster(Context));
+  if (Profile)
+    Context.setCheckProfileData(Profile);
+
+  ClangTidyDiagnosticConsumer DiagConsumer(Context);
+
+  Tool.setDiagnosticConsumer(&DiagConsumer);
+
   ActionFactory Factory(Context);
   Tool.run(&Factory);
 }
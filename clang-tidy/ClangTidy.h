@@ -10,11 +10,13 @@
 #ifndef LLVM_CLANG_TOOLS_EXTRA_CLANG_TIDY_CLANGTIDY_H
 #define LLVM_CLANG_TOOLS_EXTRA_CLANG_TIDY_CLANGTIDY_H
 
+#include "CallMatcherIndex.h"
 #include "ClangTidyDiagnosticConsumer.h"
 #include "ClangTidyOptions.h"
 #include "clang/ASTMatchers/ASTMatchFinder.h"
 #include "clang/Basic/Diagnostic.h"
 #include "clang/Basic/SourceManager.h"
+#include "clang/Tooling/ArgumentsAdjusters.h"
 #include "clang/Tooling/Refactoring.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/Support/raw_ostream.h"
@@ -27,6 +29,7 @@ namespace clang {
 class CompilerInstance;
 namespace tooling {
 class CompilationDatabase;
+class FrontendActionFactory;
 }
 
 namespace tidy {
@@ -158,10 +161,31 @@ public:
   /// matches occur in the order of the AST traversal.
   virtual void registerMatchers(ast_matchers::MatchFinder *Finder) {}
 
+  /// \brief Override this to register matchers of calls to functions with
+  /// particular names with \p Index.
+  ///
+  /// They are only run on calls to functions with these names, which is
+  /// cheaper than registering them in \c registerMatchers(). Callbacks that are
+  /// only registered here don't get \c onStartOfTranslationUnit() and
+  /// \c onEndOfTranslationUnit() calls.
+  virtual void registerCallMatchers(CallMatcherIndex *Index) {}
+
   /// \brief ``ClangTidyChecks`` that register ASTMatchers should do the actual
   /// work in here.
   virtual void check(const ast_matchers::MatchFinder::MatchResult &Result) {}
 
+  /// \brief Override this to return true if the check needs matches in headers
+  /// that its diagnostics are not reported for.
+  ///
+  /// By default, the matchers are not run on top-level declarations that are
+  /// entirely in system headers or in headers not matching the header filter.
+  /// Checks that collect information from such declarations to diagnose user
+  /// code need all of them. So do checks whose warnings can have notes outside
+  /// of the matched declaration: a warning in a header is still reported if
+  /// one of its notes is in user code. The matchers of the other checks still
+  /// skip these declarations.
+  virtual bool needsMatchesInAllHeaders() const { return false; }
+
   /// \brief Add a diagnostic with the check's name.
   DiagnosticBuilder diag(SourceLocation Loc, StringRef Description,
                          DiagnosticIDs::Level Level = DiagnosticIDs::Warning);
@@ -185,8 +209,14 @@ protected:
   StringRef getCurrentMainFile() const { return Context->getCurrentFile(); }
   /// \brief Returns the language options from the context.
   LangOptions getLangOpts() const { return Context->getLangOpts(); }
+  /// \brief Returns the analyses of the current translation unit that are
+  /// shared between the checks.
+  AnalysisCache &getAnalysisCache() const {
+    return Context->getAnalysisCache();
+  }
 };
 
+class ClangTidyCache;
 class ClangTidyCheckFactories;
 
 class ClangTidyASTConsumerFactory {
@@ -224,10 +254,31 @@ ClangTidyOptions::OptionMap getCheckOptions(const ClangTidyOptions &Options);
 ///
 /// \param Profile if provided, it enables check profile collection in
 /// MatchFinder, and will contain the result of the profile.
+///
+/// \param NumThreads the number of translation units processed in parallel.
+/// Each thread uses its own \c ClangTidyContext, the results are merged into
+/// \p Context in the order of \p InputFiles. Profiles of parallel runs contain
+/// the sum of the times of all threads.
+///
+/// \param Cache if provided, the results of translation units that didn't
+/// change are read from it instead of analyzing them, and the results of the
+/// other translation units are stored in it.
 void runClangTidy(clang::tidy::ClangTidyContext &Context,
                   const tooling::CompilationDatabase &Compilations,
                   ArrayRef<std::string> InputFiles,
-                  ProfileData *Profile = nullptr);
+                  ProfileData *Profile = nullptr, unsigned NumThreads = 1,
+                  const ClangTidyCache *Cache = nullptr);
+
+/// \brief Returns a factory of frontend actions that run the checks enabled in
+/// \p Context on each translation unit. The check modules are instantiated
+/// once per factory, so it can be reused for many translation units.
+std::unique_ptr<tooling::FrontendActionFactory>
+createClangTidyActionFactory(ClangTidyContext &Context);
+
+/// \brief Returns the arguments adjuster applying the extra arguments from the
+/// options of \p Context and removing plugin arguments.
+tooling::ArgumentsAdjuster
+getClangTidyArgumentsAdjuster(ClangTidyContext &Context);
 
 // FIXME: This interface will need to be significantly extended to be useful.
 // FIXME: Implement confidence levels for displaying/fixing errors.
@@ -0,0 +1,286 @@
+//===--- ClangTidyCache.cpp - clang-tidy ------------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "ClangTidyCache.h"
+#include "clang/Tooling/ReplacementsYaml.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/Chrono.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/YAMLTraits.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace clang;
+using namespace clang::tidy;
+
+namespace {
+/// \brief Version of the format of the entries, part of every key.
+const char CacheFormatVersion[] = "2";
+
+/// \brief A \c ClangTidyError in a form that can be mapped to YAML.
+struct SerializedError {
+  std::string DiagnosticName;
+  int DiagLevel;
+  std::string BuildDirectory;
+  bool IsWarningAsError;
+  tooling::DiagnosticMessage Message;
+  std::vector<tooling::DiagnosticMessage> Notes;
+  std::vector<tooling::Replacement> Replacements;
+};
+
+struct CacheEntry {
+  std::vector<ClangTidyCache::Dependency> Dependencies;
+  std::vector<SerializedError> Errors;
+  ClangTidyStats Stats;
+};
+} // namespace
+
+LLVM_YAML_IS_SEQUENCE_VECTOR(ClangTidyCache::Dependency)
+LLVM_YAML_IS_SEQUENCE_VECTOR(SerializedError)
+LLVM_YAML_IS_SEQUENCE_VECTOR(tooling::DiagnosticMessage)
+
+namespace llvm {
+namespace yaml {
+
+template <> struct MappingTraits<ClangTidyCache::Dependency> {
+  static void mapping(IO &IO, ClangTidyCache::Dependency &Dep) {
+    IO.mapRequired("Path", Dep.Path);
+    IO.mapRequired("Size", Dep.Size);
+    IO.mapRequired("ModificationTime", Dep.ModificationTime);
+    IO.mapRequired("Hash", Dep.Hash);
+  }
+};
+
+template <> struct MappingTraits<tooling::DiagnosticMessage> {
+  static void mapping(IO &IO, tooling::DiagnosticMessage &Message) {
+    IO.mapRequired("Message", Message.Message);
+    IO.mapRequired("FilePath", Message.FilePath);
+    IO.mapRequired("FileOffset", Message.FileOffset);
+  }
+};
+
+template <> struct MappingTraits<SerializedError> {
+  static void mapping(IO &IO, SerializedError &Error) {
+    IO.mapRequired("DiagnosticName", Error.DiagnosticName);
+    IO.mapRequired("Level", Error.DiagLevel);
+    IO.mapRequired("BuildDirectory", Error.BuildDirectory);
+    IO.mapRequired("IsWarningAsError", Error.IsWarningAsError);
+    IO.mapRequired("Message", Error.Message);
+    IO.mapOptional("Notes", Error.Notes);
+    IO.mapOptional("Replacements", Error.Replacements);
+  }
+};
+
+template <> struct MappingTraits<ClangTidyStats> {
+  static void mapping(IO &IO, ClangTidyStats &Stats) {
+    IO.mapRequired("ErrorsDisplayed", Stats.ErrorsDisplayed);
+    IO.mapRequired("ErrorsIgnoredCheckFilter", Stats.ErrorsIgnoredCheckFilter);
+    IO.mapRequired("ErrorsIgnoredNOLINT", Stats.ErrorsIgnoredNOLINT);
+    IO.mapRequired("ErrorsIgnoredNonUserCode", Stats.ErrorsIgnoredNonUserCode);
+    IO.mapRequired("ErrorsIgnoredLineFilter", Stats.ErrorsIgnoredLineFilter);
+    IO.mapRequired("DeclsSkippedNonUserCode", Stats.DeclsSkippedNonUserCode);
+  }
+};
+
+template <> struct MappingTraits<CacheEntry> {
+  static void mapping(IO &IO, CacheEntry &Entry) {
+    IO.mapRequired("Dependencies", Entry.Dependencies);
+    IO.mapRequired("Errors", Entry.Errors);
+    IO.mapRequired("Stats", Entry.Stats);
+  }
+};
+
+} // namespace yaml
+} // namespace llvm
+
+/// \brief Returns the MD5 of \p Contents in hex.
+static std::string hashContents(StringRef Contents) {
+  llvm::MD5 Hash;
+  Hash.update(Contents);
+  llvm::MD5::MD5Result Result;
+  Hash.final(Result);
+  SmallString<32> Hex;
+  llvm::MD5::stringifyResult(Result, Hex);
+  return Hex.str();
+}
+
+/// \brief Fills \p Dep for the file at \p Path. Returns false if the file can't
+/// be read.
+static bool getDependency(StringRef Path, ClangTidyCache::Dependency &Dep) {
+  llvm::sys::fs::file_status Status;
+  if (llvm::sys::fs::status(Path, Status))
+    return false;
+  auto Buffer = llvm::MemoryBuffer::getFile(Path);
+  if (!Buffer)
+    return false;
+  Dep.Path = Path;
+  Dep.Size = Status.getSize();
+  Dep.ModificationTime =
+      llvm::sys::toTimeT(Status.getLastModificationTime());
+  // A file modified within the resolution of the modification time could be
+  // modified again without changing it. Always compare the contents then.
+  if (Dep.ModificationTime + 2 >=
+      static_cast<uint64_t>(
+          llvm::sys::toTimeT(std::chrono::system_clock::now())))
+    Dep.ModificationTime = 0;
+  Dep.Hash = hashContents((*Buffer)->getBuffer());
+  return true;
+}
+
+/// \brief Returns true if the file \p Dep describes has the same contents.
+static bool isUnchanged(const ClangTidyCache::Dependency &Dep) {
+  llvm::sys::fs::file_status Status;
+  if (llvm::sys::fs::status(Dep.Path, Status) || Status.getSize() != Dep.Size)
+    return false;
+  // Only read files whose modification time changed, e.g. by a new checkout.
+  if (static_cast<uint64_t>(llvm::sys::toTimeT(
+          Status.getLastModificationTime())) == Dep.ModificationTime)
+    return true;
+  auto Buffer = llvm::MemoryBuffer::getFile(Dep.Path);
+  return Buffer && hashContents((*Buffer)->getBuffer()) == Dep.Hash;
+}
+
+ClangTidyCache::ClangTidyCache(StringRef Directory) : Directory(Directory) {}
+
+std::string
+ClangTidyCache::getKey(ArrayRef<std::string> CommandLine, StringRef Directory,
+                       const ClangTidyOptions &Options,
+                       const ClangTidyGlobalOptions &GlobalOptions) {
+  llvm::MD5 Hash;
+  auto AddString = [&Hash](StringRef S) {
+    Hash.update(S);
+    // Keep the boundaries between strings.
+    Hash.update(StringRef("\0", 1));
+  };
+  AddString(CacheFormatVersion);
+
+  // Results depend on the checks compiled into the binary.
+  static int StaticSymbol;
+  std::string Executable =
+      llvm::sys::fs::getMainExecutable("clang-tidy", &StaticSymbol);
+  llvm::sys::fs::file_status Status;
+  if (!llvm::sys::fs::status(Executable, Status)) {
+    AddString(Executable);
+    AddString(llvm::utostr(Status.getSize()));
+    AddString(
+        llvm::utostr(llvm::sys::toTimeT(Status.getLastModificationTime())));
+  }
+
+  AddString(Directory);
+  for (const std::string &Arg : CommandLine)
+    AddString(Arg);
+
+  // The enabled checks, their options and the filters.
+  AddString(configurationAsText(Options));
+  AddString(Options.SystemHeaders && *Options.SystemHeaders ? "1" : "0");
+  for (const FileFilter &Filter : GlobalOptions.LineFilter) {
+    AddString(Filter.Name);
+    for (const FileFilter::LineRange &Range : Filter.LineRanges)
+      AddString(llvm::utostr(Range.first) + "-" + llvm::utostr(Range.second));
+  }
+
+  llvm::MD5::MD5Result Result;
+  Hash.final(Result);
+  SmallString<32> Key;
+  llvm::MD5::stringifyResult(Result, Key);
+  return Key.str();
+}
+
+std::string ClangTidyCache::getEntryPath(StringRef Key) const {
+  SmallString<128> Path(Directory);
+  llvm::sys::path::append(Path, Key + ".yaml");
+  return Path.str();
+}
+
+bool ClangTidyCache::lookup(StringRef Key, std::vector<ClangTidyError> &Errors,
+                            ClangTidyStats &Stats) const {
+  auto Buffer = llvm::MemoryBuffer::getFile(getEntryPath(Key));
+  if (!Buffer)
+    return false;
+  CacheEntry Entry;
+  llvm::yaml::Input Input((*Buffer)->getBuffer());
+  Input >> Entry;
+  if (Input.error())
+    return false;
+
+  for (const Dependency &Dep : Entry.Dependencies) {
+    if (!isUnchanged(Dep))
+      return false;
+  }
+
+  for (const SerializedError &Serialized : Entry.Errors) {
+    ClangTidyError Error(
+        Serialized.DiagnosticName,
+        static_cast<ClangTidyError::Level>(Serialized.DiagLevel),
+        Serialized.BuildDirectory, Serialized.IsWarningAsError);
+    Error.Message = Serialized.Message;
+    Error.Notes.append(Serialized.Notes.begin(), Serialized.Notes.end());
+    for (const tooling::Replacement &Replacement : Serialized.Replacements) {
+      if (llvm::Error Err =
+              Error.Fix[Replacement.getFilePath()].add(Replacement)) {
+        llvm::consumeError(std::move(Err));
+        return false;
+      }
+    }
+    Errors.push_back(std::move(Error));
+  }
+  Stats = Entry.Stats;
+  return true;
+}
+
+void ClangTidyCache::store(StringRef Key, ArrayRef<std::string> Dependencies,
+                           ArrayRef<ClangTidyError> Errors,
+                           const ClangTidyStats &Stats) const {
+  CacheEntry Entry;
+  for (const std::string &Path : Dependencies) {
+    Dependency Dep;
+    // Don't store results that can't be validated.
+    if (!getDependency(Path, Dep))
+      return;
+    Entry.Dependencies.push_back(std::move(Dep));
+  }
+  for (const ClangTidyError &Error : Errors) {
+    SerializedError Serialized;
+    Serialized.DiagnosticName = Error.DiagnosticName;
+    Serialized.DiagLevel = Error.DiagLevel;
+    Serialized.BuildDirectory = Error.BuildDirectory;
+    Serialized.IsWarningAsError = Error.IsWarningAsError;
+    Serialized.Message = Error.Message;
+    Serialized.Notes.assign(Error.Notes.begin(), Error.Notes.end());
+    for (const auto &FileAndReplacements : Error.Fix)
+      for (const tooling::Replacement &Replacement : FileAndReplacements.second)
+        Serialized.Replacements.push_back(Replacement);
+    Entry.Errors.push_back(std::move(Serialized));
+  }
+  Entry.Stats = Stats;
+
+  if (llvm::sys::fs::create_directories(Directory))
+    return;
+  std::string Path = getEntryPath(Key);
+  SmallString<128> TempPath;
+  int FD;
+  if (llvm::sys::fs::createUniqueFile(Path + "-%%%%%%%%.tmp", FD, TempPath))
+    return;
+  {
+    llvm::raw_fd_ostream OS(FD, /*shouldClose=*/true);
+    llvm::yaml::Output YAML(OS);
+    YAML << Entry;
+    if (OS.has_error()) {
+      OS.clear_error();
+      llvm::sys::fs::remove(TempPath);
+      return;
+    }
+  }
+  // Other processes only ever see complete entries.
+  if (llvm::sys::fs::rename(TempPath, Path))
+    llvm::sys::fs::remove(TempPath);
+}
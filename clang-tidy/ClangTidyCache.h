@@ -0,0 +1,77 @@
+//===--- ClangTidyCache.h - clang-tidy --------------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_TOOLS_EXTRA_CLANG_TIDY_CLANGTIDYCACHE_H
+#define LLVM_CLANG_TOOLS_EXTRA_CLANG_TIDY_CLANGTIDYCACHE_H
+
+#include "ClangTidyDiagnosticConsumer.h"
+#include "ClangTidyOptions.h"
+#include <string>
+#include <vector>
+
+namespace clang {
+namespace tidy {
+
+/// \brief Stores the results of running clang-tidy on translation units in a
+/// directory, so that translation units that didn't change don't need to be
+/// parsed and analyzed again.
+///
+/// The results of a compile command are stored under a key computed from the
+/// command, the clang-tidy options and the clang-tidy binary. Each entry lists
+/// the files the translation unit included, with a hash of their contents. The
+/// entry is used only while none of these files changed.
+///
+/// Entries are written atomically, so a cache directory can be shared between
+/// threads and clang-tidy processes.
+class ClangTidyCache {
+public:
+  /// \brief A file included by a translation unit whose results are stored.
+  struct Dependency {
+    std::string Path;
+    uint64_t Size;
+    uint64_t ModificationTime;
+    /// \brief MD5 of the contents of the file, in hex.
+    std::string Hash;
+  };
+
+  ClangTidyCache(StringRef Directory);
+
+  /// \brief Returns the key of the results of running clang-tidy with
+  /// \p Options and \p GlobalOptions on the compile command \p CommandLine,
+  /// run in \p Directory.
+  static std::string getKey(ArrayRef<std::string> CommandLine,
+                            StringRef Directory,
+                            const ClangTidyOptions &Options,
+                            const ClangTidyGlobalOptions &GlobalOptions);
+
+  /// \brief Reads the results stored under \p Key into \p Errors and \p Stats.
+  ///
+  /// Returns false if there are none, or if any of the files included by the
+  /// translation unit changed since the results were stored.
+  bool lookup(StringRef Key, std::vector<ClangTidyError> &Errors,
+              ClangTidyStats &Stats) const;
+
+  /// \brief Stores \p Errors and \p Stats under \p Key.
+  ///
+  /// \p Dependencies are the absolute paths of all files of the translation
+  /// unit, including the main file.
+  void store(StringRef Key, ArrayRef<std::string> Dependencies,
+             ArrayRef<ClangTidyError> Errors,
+             const ClangTidyStats &Stats) const;
+
+private:
+  std::string getEntryPath(StringRef Key) const;
+
+  std::string Directory;
+};
+
+} // end namespace tidy
+} // end namespace clang
+
+#endif // LLVM_CLANG_TOOLS_EXTRA_CLANG_TIDY_CLANGTIDYCACHE_H
@@ -21,7 +21,9 @@
 #include "clang/AST/ASTDiagnostic.h"
 #include "clang/Basic/DiagnosticOptions.h"
 #include "clang/Frontend/DiagnosticRenderer.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringMap.h"
 #include <tuple>
 #include <vector>
 using namespace clang;
@@ -126,35 +128,55 @@ static bool ConsumeNegativeIndicator(StringRef &GlobList) {
   }
   return false;
 }
-// Converts first glob from the comma-separated list of globs to Regex and
-// removes it and the trailing comma from the GlobList.
-static llvm::Regex ConsumeGlob(StringRef &GlobList) {
+// Splits first glob from the comma-separated list of globs into the parts
+// between '*'s and removes it and the trailing comma from the GlobList.
+static SmallVector<std::string, 2> ConsumeGlob(StringRef &GlobList) {
   StringRef UntrimmedGlob = GlobList.substr(0, GlobList.find(','));
   StringRef Glob = UntrimmedGlob.trim(' ');
   GlobList = GlobList.substr(UntrimmedGlob.size() + 1);
-  SmallString<128> RegexText("^");
-  StringRef MetaChars("()^$|*+?.[]\\{}");
-  for (char C : Glob) {
-    if (C == '*')
-      RegexText.push_back('.');
-    else if (MetaChars.find(C) != StringRef::npos)
-      RegexText.push_back('\\');
-    RegexText.push_back(C);
-  }
-  RegexText.push_back('$');
-  return llvm::Regex(RegexText);
+  SmallVector<StringRef, 2> Parts;
+  Glob.split(Parts, '*');
+  return SmallVector<std::string, 2>(Parts.begin(), Parts.end());
 }
 
-GlobList::GlobList(StringRef Globs)
-    : Positive(!ConsumeNegativeIndicator(Globs)), Regex(ConsumeGlob(Globs)),
-      NextGlob(Globs.empty() ? nullptr : new GlobList(Globs)) {}
+GlobList::GlobList(StringRef Globs) {
+  do {
+    bool Positive = !ConsumeNegativeIndicator(Globs);
+    Items.push_back({Positive, ConsumeGlob(Globs)});
+  } while (!Globs.empty());
+}
 
-bool GlobList::contains(StringRef S, bool Contains) {
-  if (Regex.match(S))
-    Contains = Positive;
+bool GlobList::Glob::matches(StringRef S) const {
+  if (Parts.size() == 1)
+    return S == Parts.front();
+  // The first part is anchored at the start and the last part at the end. The
+  // parts in between can be matched at their first occurrence, as any string
+  // matched by a later occurrence is also matched by the first one.
+  if (!S.startswith(Parts.front()))
+    return false;
+  S = S.drop_front(Parts.front().size());
+  for (size_t I = 1, E = Parts.size() - 1; I < E; ++I) {
+    size_t Pos = S.find(Parts[I]);
+    if (Pos == StringRef::npos)
+      return false;
+    S = S.drop_front(Pos + Parts[I].size());
+  }
+  return S.endswith(Parts.back());
+}
 
-  if (NextGlob)
-    Contains = NextGlob->contains(S, Contains);
+bool GlobList::contains(StringRef S) {
+  auto Cached = Cache.find(S);
+  if (Cached != Cache.end())
+    return Cached->second;
+  // The last matching glob determines the result.
+  bool Contains = false;
+  for (const Glob &G : llvm::reverse(Items)) {
+    if (G.matches(S)) {
+      Contains = G.Positive;
+      break;
+    }
+  }
+  Cache[S] = Contains;
   return Contains;
 }
 
@@ -187,12 +209,19 @@ void ClangTidyContext::setSourceManager(SourceManager *SourceMgr) {
 
 void ClangTidyContext::setCurrentFile(StringRef File) {
   CurrentFile = File;
-  CurrentOptions = getOptionsForFile(CurrentFile);
-  CheckFilter.reset(new GlobList(*getOptions().Checks));
-  WarningAsErrorFilter.reset(new GlobList(*getOptions().WarningsAsErrors));
+  ClangTidyOptions NewOptions = getOptionsForFile(CurrentFile);
+  // Most files share their options, keep the filters and the results they
+  // remembered in this case.
+  if (!CheckFilter || *NewOptions.Checks != *CurrentOptions.Checks)
+    CheckFilter.reset(new GlobList(*NewOptions.Checks));
+  if (!WarningAsErrorFilter ||
+      *NewOptions.WarningsAsErrors != *CurrentOptions.WarningsAsErrors)
+    WarningAsErrorFilter.reset(new GlobList(*NewOptions.WarningsAsErrors));
+  CurrentOptions = std::move(NewOptions);
 }
 
 void ClangTidyContext::setASTContext(ASTContext *Context) {
+  Analyses.clear();
   DiagEngine->SetArgToStringFn(&FormatASTNodeDiagnosticArgument, Context);
   LangOpts = Context->getLangOpts();
 }
@@ -229,6 +258,19 @@ void ClangTidyContext::storeError(const ClangTidyError &Error) {
   Errors.push_back(Error);
 }
 
+void ClangTidyContext::addResults(ArrayRef<ClangTidyError> NewErrors,
+                                  const ClangTidyStats &NewStats) {
+  Errors.insert(Errors.end(), NewErrors.begin(), NewErrors.end());
+  Stats.ErrorsDisplayed += NewStats.ErrorsDisplayed;
+  Stats.ErrorsIgnoredCheckFilter += NewStats.ErrorsIgnoredCheckFilter;
+  Stats.ErrorsIgnoredNOLINT += NewStats.ErrorsIgnoredNOLINT;
+  Stats.ErrorsIgnoredNonUserCode += NewStats.ErrorsIgnoredNonUserCode;
+  Stats.ErrorsIgnoredLineFilter += NewStats.ErrorsIgnoredLineFilter;
+  Stats.DeclsSkippedNonUserCode += NewStats.DeclsSkippedNonUserCode;
+  Stats.CacheHits += NewStats.CacheHits;
+  Stats.CacheMisses += NewStats.CacheMisses;
+}
+
 StringRef ClangTidyContext::getCheckName(unsigned DiagnosticID) const {
   llvm::DenseMap<unsigned, std::string>::const_iterator I =
       CheckNamesByDiagnosticID.find(DiagnosticID);
@@ -465,74 +507,36 @@ llvm::Regex *ClangTidyDiagnosticConsumer::getHeaderFilter() {
   return HeaderFilter.get();
 }
 
-void ClangTidyDiagnosticConsumer::removeIncompatibleErrors(
-    SmallVectorImpl<ClangTidyError> &Errors) const {
+void clang::tidy::removeIncompatibleErrors(
+    SmallVectorImpl<ClangTidyError> &Errors) {
   // Each error is modelled as the set of intervals in which it applies
-  // replacements. To detect overlapping replacements, we use a sweep line
-  // algorithm over these sets of intervals.
-  // An event here consists of the opening or closing of an interval. During the
-  // process, we maintain a counter with the amount of open intervals. If we
-  // find an endpoint of an interval and this counter is different from 0, it
-  // means that this interval overlaps with another one, so we set it as
-  // inapplicable.
-  struct Event {
-    // An event can be either the begin or the end of an interval.
-    enum EventType {
-      ET_Begin = 1,
-      ET_End = -1,
-    };
-
-    Event(unsigned Begin, unsigned End, EventType Type, unsigned ErrorId,
-          unsigned ErrorSize)
-        : Type(Type), ErrorId(ErrorId) {
-      // The events are going to be sorted by their position. In case of draw:
-      //
-      // * If an interval ends at the same position at which other interval
-      //   begins, this is not an overlapping, so we want to remove the ending
-      //   interval before adding the starting one: end events have higher
-      //   priority than begin events.
-      //
-      // * If we have several begin points at the same position, we will mark as
-      //   inapplicable the ones that we process later, so the first one has to
-      //   be the one with the latest end point, because this one will contain
-      //   all the other intervals. For the same reason, if we have several end
-      //   points in the same position, the last one has to be the one with the
-      //   earliest begin point. In both cases, we sort non-increasingly by the
-      //   position of the complementary.
-      //
-      // * In case of two equal intervals, the one whose error is bigger can
-      //   potentially contain the other one, so we want to process its begin
-      //   points before and its end points later.
-      //
-      // * Finally, if we have two equal intervals whose errors have the same
-      //   size, none of them will be strictly contained inside the other.
-      //   Sorting by ErrorId will guarantee that the begin point of the first
-      //   one will be processed before, disallowing the second one, and the
-      //   end point of the first one will also be processed before,
-      //   disallowing the first one.
-      if (Type == ET_Begin)
-        Priority = std::make_tuple(Begin, Type, -End, -ErrorSize, ErrorId);
-      else
-        Priority = std::make_tuple(End, Type, -Begin, ErrorSize, ErrorId);
-    }
-
-    bool operator<(const Event &Other) const {
-      return Priority < Other.Priority;
-    }
-
-    // Determines if this event is the begin or the end of an interval.
-    EventType Type;
-    // The index of the error to which the interval that generated this event
-    // belongs.
+  // replacements. The intervals of each file are sorted by their begin, and
+  // among intervals with the same begin, containing intervals come first. A
+  // sweep over them keeps track of the interval that reaches the furthest, the
+  // "owner" of the current position:
+  //
+  // * An interval that begins before the end of the owner overlaps with it,
+  //   so it is inapplicable. If it's contained in the owner, the owner is still
+  //   applicable. If it ends after the owner, the owner is inapplicable too and
+  //   the interval becomes the owner.
+  //
+  // * Of two equal intervals, the one whose error is bigger can contain the
+  //   other one, so it comes first. If both errors have the same size, none of
+  //   them is contained in the other and both are inapplicable.
+  //
+  // * An insertion overlaps with the intervals that strictly contain its
+  //   offset, not with the intervals it touches.
+  struct Interval {
+    unsigned Begin;
+    unsigned End;
     unsigned ErrorId;
-    // The events will be sorted based on this field.
-    std::tuple<unsigned, EventType, int, int, unsigned> Priority;
   };
 
   // Compute error sizes.
-  std::vector<int> Sizes;
+  std::vector<unsigned> Sizes;
+  Sizes.reserve(Errors.size());
   for (const auto &Error : Errors) {
-    int Size = 0;
+    unsigned Size = 0;
     for (const auto &FileAndReplaces : Error.Fix) {
       for (const auto &Replace : FileAndReplaces.second)
         Size += Replace.getLength();
@@ -540,49 +544,79 @@ void ClangTidyDiagnosticConsumer::removeIncompatibleErrors(
     Sizes.push_back(Size);
   }
 
-  // Build events from error intervals.
-  std::map<std::string, std::vector<Event>> FileEvents;
+  // Collect the intervals of each file. Files are identified by their index
+  // in FileIntervals, so that paths are only hashed once per replacement.
+  llvm::StringMap<unsigned> FileIds;
+  std::vector<std::vector<Interval>> FileIntervals;
   for (unsigned I = 0; I < Errors.size(); ++I) {
     for (const auto &FileAndReplace : Errors[I].Fix) {
       for (const auto &Replace : FileAndReplace.second) {
+        auto Inserted = FileIds.insert(
+            std::make_pair(Replace.getFilePath(), FileIntervals.size()));
+        if (Inserted.second)
+          FileIntervals.emplace_back();
         unsigned Begin = Replace.getOffset();
-        unsigned End = Begin + Replace.getLength();
-        const std::string &FilePath = Replace.getFilePath();
-        // FIXME: Handle empty intervals, such as those from insertions.
-        if (Begin == End)
-          continue;
-        auto &Events = FileEvents[FilePath];
-        Events.emplace_back(Begin, End, Event::ET_Begin, I, Sizes[I]);
-        Events.emplace_back(Begin, End, Event::ET_End, I, Sizes[I]);
+        FileIntervals[Inserted.first->second].push_back(
+            {Begin, Begin + Replace.getLength(), I});
       }
     }
   }
 
   std::vector<bool> Apply(Errors.size(), true);
-  for (auto &FileAndEvents : FileEvents) {
-    std::vector<Event> &Events = FileAndEvents.second;
-    // Sweep.
-    std::sort(Events.begin(), Events.end());
-    int OpenIntervals = 0;
-    for (const auto &Event : Events) {
-      if (Event.Type == Event::ET_End)
-        --OpenIntervals;
-      // This has to be checked after removing the interval from the count if it
-      // is an end event, or before adding it if it is a begin event.
-      if (OpenIntervals != 0)
-        Apply[Event.ErrorId] = false;
-      if (Event.Type == Event::ET_Begin)
-        ++OpenIntervals;
+  // For each inapplicable error, another error it overlaps with.
+  std::vector<unsigned> OverlapsWith(Errors.size());
+  auto SetOverlapping = [&](unsigned ErrorId, unsigned OtherErrorId) {
+    if (Apply[ErrorId]) {
+      Apply[ErrorId] = false;
+      OverlapsWith[ErrorId] = OtherErrorId;
+    }
+  };
+
+  for (std::vector<Interval> &Intervals : FileIntervals) {
+    std::sort(Intervals.begin(), Intervals.end(),
+              [&Sizes](const Interval &LHS, const Interval &RHS) {
+                return std::tie(LHS.Begin, RHS.End, Sizes[RHS.ErrorId],
+                                LHS.ErrorId) <
+                       std::tie(RHS.Begin, LHS.End, Sizes[LHS.ErrorId],
+                                RHS.ErrorId);
+              });
+
+    const Interval *Owner = nullptr;
+    for (const Interval &Current : Intervals) {
+      if (Current.Begin == Current.End) {
+        if (Owner && Owner->Begin < Current.Begin && Current.Begin < Owner->End)
+          SetOverlapping(Current.ErrorId, Owner->ErrorId);
+        continue;
+      }
+
+      if (!Owner || Owner->End <= Current.Begin) {
+        Owner = &Current;
+        continue;
+      }
+      SetOverlapping(Current.ErrorId, Owner->ErrorId);
+      bool SameAsOwner = Current.Begin == Owner->Begin &&
+                         Current.End == Owner->End &&
+                         Sizes[Current.ErrorId] == Sizes[Owner->ErrorId];
+      if (Current.End > Owner->End || SameAsOwner)
+        SetOverlapping(Owner->ErrorId, Current.ErrorId);
+      if (Current.End > Owner->End)
+        Owner = &Current;
     }
-    assert(OpenIntervals == 0 && "Amount of begin/end points doesn't match");
   }
 
   for (unsigned I = 0; I < Errors.size(); ++I) {
-    if (!Apply[I]) {
-      Errors[I].Fix.clear();
-      Errors[I].Notes.emplace_back(
-          "this fix will not be applied because it overlaps with another fix");
+    if (Apply[I])
+      continue;
+    Errors[I].Fix.clear();
+    const ClangTidyError &Other = Errors[OverlapsWith[I]];
+    std::string Note =
+        "this fix will not be applied because it overlaps with another fix";
+    if (OverlapsWith[I] != I) {
+      Note += " from '" + Other.DiagnosticName + "'";
+      if (Apply[OverlapsWith[I]])
+        Note += ", which is applied";
     }
+    Errors[I].Notes.emplace_back(Note);
   }
 }
 
@@ -10,12 +10,14 @@
 #ifndef LLVM_CLANG_TOOLS_EXTRA_CLANG_TIDY_CLANGTIDYDIAGNOSTICCONSUMER_H
 #define LLVM_CLANG_TOOLS_EXTRA_CLANG_TIDY_CLANGTIDYDIAGNOSTICCONSUMER_H
 
+#include "AnalysisCache.h"
 #include "ClangTidyOptions.h"
 #include "clang/Basic/Diagnostic.h"
 #include "clang/Basic/SourceManager.h"
 #include "clang/Tooling/Core/Diagnostic.h"
 #include "clang/Tooling/Refactoring.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/Support/Regex.h"
 #include "llvm/Support/Timer.h"
@@ -50,6 +52,10 @@ struct ClangTidyError : tooling::Diagnostic {
 /// \brief Read-only set of strings represented as a list of positive and
 /// negative globs. Positive globs add all matched strings to the set, negative
 /// globs remove them in the order of appearance in the list.
+///
+/// Each glob is split into the literal parts between its '*'s once, and the
+/// result for each queried string is remembered, as the same check names are
+/// looked up for every diagnostic.
 class GlobList {
 public:
   /// \brief \p GlobList is a comma-separated list of globs (only '*'
@@ -58,14 +64,20 @@ public:
 
   /// \brief Returns \c true if the pattern matches \p S. The result is the last
   /// matching glob's Positive flag.
-  bool contains(StringRef S) { return contains(S, false); }
+  bool contains(StringRef S);
 
 private:
-  bool contains(StringRef S, bool Contains);
+  struct Glob {
+    bool Positive;
+    /// \brief The parts of the glob between '*'s. A glob without '*' has a
+    /// single part, that must be equal to the whole string.
+    SmallVector<std::string, 2> Parts;
+
+    bool matches(StringRef S) const;
+  };
 
-  bool Positive;
-  llvm::Regex Regex;
-  std::unique_ptr<GlobList> NextGlob;
+  std::vector<Glob> Items;
+  llvm::StringMap<bool> Cache;
 };
 
 /// \brief Contains displayed and ignored diagnostic counters for a ClangTidy
@@ -73,7 +85,8 @@ private:
 struct ClangTidyStats {
   ClangTidyStats()
       : ErrorsDisplayed(0), ErrorsIgnoredCheckFilter(0), ErrorsIgnoredNOLINT(0),
-        ErrorsIgnoredNonUserCode(0), ErrorsIgnoredLineFilter(0) {}
+        ErrorsIgnoredNonUserCode(0), ErrorsIgnoredLineFilter(0),
+        DeclsSkippedNonUserCode(0), CacheHits(0), CacheMisses(0) {}
 
   unsigned ErrorsDisplayed;
   unsigned ErrorsIgnoredCheckFilter;
@@ -81,15 +94,83 @@ struct ClangTidyStats {
   unsigned ErrorsIgnoredNonUserCode;
   unsigned ErrorsIgnoredLineFilter;
 
+  /// \brief Number of top-level declarations in system headers and in headers
+  /// not matching the header filter that the matchers were not run on. These
+  /// are not warnings, and are not part of \c errorsIgnored().
+  unsigned DeclsSkippedNonUserCode;
+
+  /// \brief Number of compile commands whose results were read from, or were
+  /// not found in the \c ClangTidyCache.
+  unsigned CacheHits;
+  unsigned CacheMisses;
+
   unsigned errorsIgnored() const {
     return ErrorsIgnoredNOLINT + ErrorsIgnoredCheckFilter +
            ErrorsIgnoredNonUserCode + ErrorsIgnoredLineFilter;
   }
 };
 
+/// \brief Profiling data of a single check.
+struct CheckProfile {
+  CheckProfile()
+      : CallbackMemory(0), Matches(0), Diagnostics(0), DeclsMatched(0),
+        DeclsSkipped(0) {}
+
+  /// \brief Time spent in \c ClangTidyCheck::check(). The rest of the check's
+  /// record in \c ProfileData::Records is spent in its matchers.
+  llvm::TimeRecord Callbacks;
+  /// \brief Growth of the heap in \c ClangTidyCheck::check(), in bytes. Only
+  /// measured if \c ProfileData::TrackMemory is set.
+  int64_t CallbackMemory;
+  /// \brief Number of matches the check was called for.
+  unsigned Matches;
+  /// \brief Number of diagnostics the check reported, including the ones that
+  /// were discarded later.
+  unsigned Diagnostics;
+  /// \brief Number of top-level declarations the check's matchers were run on.
+  unsigned DeclsMatched;
+  /// \brief Number of top-level declarations the check's matchers were not run
+  /// on, because the diagnostics in them would be discarded.
+  unsigned DeclsSkipped;
+};
+
+/// \brief Profiling data of a single translation unit.
+struct TranslationUnitProfile {
+  TranslationUnitProfile()
+      : StartTime(0), FrontendMemory(0), ChecksMemory(0), AnalyzerMemory(0),
+        Thread(0) {}
+
+  std::string File;
+  /// \brief Wall time when the parsing started, in seconds.
+  double StartTime;
+  /// \brief Parsing and semantic analysis, which are interleaved.
+  llvm::TimeRecord Frontend;
+  /// \brief Matchers and callbacks of the clang-tidy checks.
+  llvm::TimeRecord Checks;
+  /// \brief Clang Static Analyzer checks.
+  llvm::TimeRecord Analyzer;
+  /// \brief Growth of the heap in each of the phases above, in bytes. Only
+  /// measured if \c ProfileData::TrackMemory is set.
+  int64_t FrontendMemory;
+  int64_t ChecksMemory;
+  int64_t AnalyzerMemory;
+  /// \brief Index of the thread that processed the translation unit.
+  unsigned Thread;
+};
+
 /// \brief Container for clang-tidy profiling data.
 struct ProfileData {
+  ProfileData() : TrackMemory(false) {}
+
+  /// \brief Whether to measure the growth of the heap with
+  /// \c llvm::sys::Process::GetMallocUsage(), which slows down the run. The
+  /// heap is shared by all threads, so with several threads the numbers
+  /// include allocations of the other threads.
+  bool TrackMemory;
+  /// \brief Time spent in the matchers and callbacks of each check.
   llvm::StringMap<llvm::TimeRecord> Records;
+  llvm::StringMap<CheckProfile> Checks;
+  std::vector<TranslationUnitProfile> TranslationUnits;
 };
 
 /// \brief Every \c ClangTidyCheck reports errors through a \c DiagnosticsEngine
@@ -157,6 +238,10 @@ public:
   /// \c CurrentFile.
   ClangTidyOptions getOptionsForFile(StringRef File) const;
 
+  /// \brief Makes the options provider read configuration files again. Takes
+  /// effect with the next call of \c setCurrentFile.
+  void clearOptionsCache() { OptionsProvider->clearCache(); }
+
   /// \brief Returns \c ClangTidyStats containing issued and ignored diagnostic
   /// counters.
   const ClangTidyStats &getStats() const { return Stats; }
@@ -167,6 +252,15 @@ public:
   /// \brief Clears collected errors.
   void clearErrors() { Errors.clear(); }
 
+  /// \brief Appends \p Errors to the collected errors and adds \p Stats to the
+  /// statistics. Used to merge the results of contexts that processed other
+  /// translation units.
+  void addResults(ArrayRef<ClangTidyError> Errors, const ClangTidyStats &Stats);
+
+  /// \brief Returns the results of analyses shared between the checks. They
+  /// are dropped when the next translation unit starts.
+  AnalysisCache &getAnalysisCache() { return Analyses; }
+
   /// \brief Set the output struct for profile data.
   ///
   /// Setting a non-null pointer here will enable profile collection in
@@ -213,6 +307,8 @@ private:
 
   llvm::DenseMap<unsigned, std::string> CheckNamesByDiagnosticID;
 
+  AnalysisCache Analyses;
+
   ProfileData *Profile;
 };
 
@@ -237,8 +333,6 @@ public:
 private:
   void finalizeLastError();
 
-  void removeIncompatibleErrors(SmallVectorImpl<ClangTidyError> &Errors) const;
-
   /// \brief Returns the \c HeaderFilter constructed for the options set in the
   /// context.
   llvm::Regex *getHeaderFilter();
@@ -257,6 +351,16 @@ private:
   bool LastErrorWasIgnored;
 };
 
+/// \brief Drops the fixes of the errors in \p Errors whose replacements overlap
+/// with the replacements of other errors.
+///
+/// A fix is kept if all its replacements are kept. Of two overlapping
+/// replacements, the one that contains the other one is kept, or none of them
+/// if neither contains the other. An insertion overlaps with the replacements
+/// that strictly contain its offset. Every dropped fix gets a note naming a
+/// check whose fix it overlaps with.
+void removeIncompatibleErrors(SmallVectorImpl<ClangTidyError> &Errors);
+
 } // end namespace tidy
 } // end namespace clang
 
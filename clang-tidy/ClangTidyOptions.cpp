@@ -17,6 +17,7 @@
 #include "llvm/Support/Path.h"
 #include "llvm/Support/YAMLTraits.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
 #include <utility>
 
 #define DEBUG_TYPE "clang-tidy-options"
@@ -318,6 +319,88 @@ std::error_code parseLineFilter(StringRef LineFilter,
   return Input.error();
 }
 
+/// \brief Parses the line number and the optional line count of one side of a
+/// hunk header, e.g. "12,3". The count is 1 if it's omitted.
+static bool parseHunkRange(StringRef &Header, unsigned &Start,
+                           unsigned &Count) {
+  if (Header.consumeInteger(10, Start))
+    return false;
+  Count = 1;
+  return !Header.consume_front(",") || !Header.consumeInteger(10, Count);
+}
+
+std::error_code parseLineFilterFromDiff(StringRef Diff,
+                                        unsigned StripComponents,
+                                        ClangTidyGlobalOptions &Options) {
+  const auto Invalid = std::make_error_code(std::errc::invalid_argument);
+  std::vector<FileFilter> Filters;
+  // The filter of the file of the current hunk, if it's not deleted.
+  llvm::Optional<size_t> CurrentFilter;
+  // The number of the next line of the hunk in the new file, and the lines
+  // left in the hunk from each side.
+  unsigned NewLine = 0, NewLeft = 0, OldLeft = 0;
+
+  SmallVector<StringRef, 128> Lines;
+  Diff.split(Lines, '\n');
+  for (StringRef Line : Lines) {
+    Line = Line.rtrim('\r');
+    if (NewLeft == 0 && OldLeft == 0) {
+      if (Line.startswith("+++ ")) {
+        StringRef Name = Line.drop_front(4);
+        Name = Name.substr(0, Name.find('\t')).trim('"');
+        CurrentFilter = llvm::None;
+        if (Name == "/dev/null")
+          continue;
+        for (unsigned I = 0; I < StripComponents; ++I) {
+          size_t Slash = Name.find('/');
+          if (Slash == StringRef::npos)
+            return Invalid;
+          Name = Name.drop_front(Slash + 1);
+        }
+        CurrentFilter = Filters.size();
+        Filters.emplace_back();
+        Filters.back().Name = Name;
+      } else if (Line.startswith("@@ -")) {
+        StringRef Header = Line.drop_front(4);
+        unsigned OldStart;
+        if (!parseHunkRange(Header, OldStart, OldLeft) ||
+            !Header.consume_front(" +") ||
+            !parseHunkRange(Header, NewLine, NewLeft))
+          return Invalid;
+      }
+      continue;
+    }
+
+    if (Line.startswith("+")) {
+      if (CurrentFilter) {
+        std::vector<FileFilter::LineRange> &Ranges =
+            Filters[*CurrentFilter].LineRanges;
+        if (!Ranges.empty() && Ranges.back().second + 1 == NewLine)
+          Ranges.back().second = NewLine;
+        else
+          Ranges.emplace_back(NewLine, NewLine);
+      }
+      ++NewLine;
+      NewLeft -= std::min(NewLeft, 1u);
+    } else if (Line.startswith("-")) {
+      OldLeft -= std::min(OldLeft, 1u);
+    } else if (!Line.startswith("\\")) {
+      // A context line. "\ No newline at end of file" belongs to no side.
+      ++NewLine;
+      NewLeft -= std::min(NewLeft, 1u);
+      OldLeft -= std::min(OldLeft, 1u);
+    }
+  }
+
+  Options.LineFilter.clear();
+  for (FileFilter &Filter : Filters) {
+    // A filter without ranges would include all lines of the file.
+    if (!Filter.LineRanges.empty())
+      Options.LineFilter.push_back(std::move(Filter));
+  }
+  return std::error_code();
+}
+
 llvm::ErrorOr<ClangTidyOptions> parseConfiguration(StringRef Config) {
   llvm::yaml::Input Input(Config);
   ClangTidyOptions Options;
@@ -140,6 +140,10 @@ public:
   /// \brief Returns options applying to a specific translation unit with the
   /// specified \p FileName.
   ClangTidyOptions getOptions(llvm::StringRef FileName);
+
+  /// \brief Forgets the configuration read from files, so that it is read again
+  /// when it's needed next. Used by long-running clang-tidy processes.
+  virtual void clearCache() {}
 };
 
 /// \brief Implementation of the \c ClangTidyOptionsProvider interface, which
@@ -247,6 +251,8 @@ public:
 
   std::vector<OptionsSource> getRawOptions(llvm::StringRef FileName) override;
 
+  void clearCache() override { CachedOptions.clear(); }
+
 protected:
   /// \brief Try to read configuration files from \p Directory using registered
   /// \c ConfigHandlers.
@@ -261,6 +267,15 @@ protected:
 std::error_code parseLineFilter(llvm::StringRef LineFilter,
                                 ClangTidyGlobalOptions &Options);
 
+/// \brief Stores the lines added by the unified diff \p Diff as the LineFilter
+/// of \p Options. \p StripComponents leading components are removed from the
+/// file names in the diff, like 'patch -p' does.
+///
+/// Files whose changes only remove lines are not added to the filter.
+std::error_code parseLineFilterFromDiff(llvm::StringRef Diff,
+                                        unsigned StripComponents,
+                                        ClangTidyGlobalOptions &Options);
+
 /// \brief Parses configuration from JSON and returns \c ClangTidyOptions or an
 /// error.
 llvm::ErrorOr<ClangTidyOptions> parseConfiguration(llvm::StringRef Config);
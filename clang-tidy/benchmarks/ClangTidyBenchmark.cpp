@@ -0,0 +1,101 @@
+//===--- ClangTidyBenchmark.cpp - Time the checks of all modules ----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Measures the time clang-tidy needs to run the checks of all modules over
+// translation units, e.g. a large preprocessed source file:
+//
+//   clang-tidy-benchmark -iterations=5 SemaDecl.ii -- -std=c++11
+//
+// Each iteration parses the files again. With -profile, the time spent in the
+// matchers and callbacks of the checks is reported separately from the time
+// spent parsing, which makes changes to the matching easier to see.
+//
+//===----------------------------------------------------------------------===//
+
+#include "../ClangTidy.h"
+#include "../ClangTidyForceLinker.h"
+#include "clang/Tooling/CommonOptionsParser.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+using namespace clang::tooling;
+using namespace llvm;
+
+static cl::OptionCategory BenchmarkCategory("clang-tidy-benchmark options");
+
+static cl::opt<unsigned> Iterations("iterations",
+                                    cl::desc("Number of times the files are "
+                                             "processed"),
+                                    cl::init(5), cl::cat(BenchmarkCategory));
+
+static cl::opt<std::string> Checks("checks",
+                                   cl::desc("Checks to run, the static "
+                                            "analyzer is excluded by default"),
+                                   cl::init("*,-clang-analyzer-*"),
+                                   cl::cat(BenchmarkCategory));
+
+static cl::opt<bool> Profile("profile",
+                             cl::desc("Report the time spent in the checks, "
+                                      "which adds some overhead"),
+                             cl::init(false), cl::cat(BenchmarkCategory));
+
+namespace clang {
+namespace tidy {
+
+static int benchmarkMain(int argc, const char **argv) {
+  CommonOptionsParser OptionsParser(argc, argv, BenchmarkCategory,
+                                    cl::OneOrMore);
+
+  ClangTidyOptions Options;
+  Options.Checks = Checks;
+  std::vector<double> Times, CheckTimes;
+  size_t NumErrors = 0;
+  for (unsigned I = 0; I != Iterations; ++I) {
+    ClangTidyContext Context(llvm::make_unique<DefaultOptionsProvider>(
+        ClangTidyGlobalOptions(),
+        ClangTidyOptions::getDefaults().mergeWith(Options)));
+    ProfileData Data;
+    auto Start = std::chrono::steady_clock::now();
+    runClangTidy(Context, OptionsParser.getCompilations(),
+                 OptionsParser.getSourcePathList(), Profile ? &Data : nullptr);
+    std::chrono::duration<double, std::milli> Elapsed =
+        std::chrono::steady_clock::now() - Start;
+    Times.push_back(Elapsed.count());
+
+    double CheckTime = 0;
+    for (const TranslationUnitProfile &TU : Data.TranslationUnits)
+      CheckTime += TU.Checks.getWallTime() * 1000;
+    CheckTimes.push_back(CheckTime);
+    NumErrors = Context.getErrors().size();
+  }
+  if (Times.empty())
+    return 0;
+
+  outs() << "Checks: " << Checks << "\n"
+         << "Warnings: " << NumErrors << "\n";
+  outs() << format("Total: min %.1fms, max %.1fms\n",
+                   *std::min_element(Times.begin(), Times.end()),
+                   *std::max_element(Times.begin(), Times.end()));
+  if (Profile)
+    outs() << format("Matching: min %.1fms, max %.1fms\n",
+                     *std::min_element(CheckTimes.begin(), CheckTimes.end()),
+                     *std::max_element(CheckTimes.begin(), CheckTimes.end()));
+  return 0;
+}
+
+} // namespace tidy
+} // namespace clang
+
+int main(int argc, const char **argv) {
+  return clang::tidy::benchmarkMain(argc, argv);
+}
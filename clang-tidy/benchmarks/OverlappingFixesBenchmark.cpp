@@ -0,0 +1,135 @@
+//===--- OverlappingFixesBenchmark.cpp - Time overlapping fix resolution --===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Measures the time clang-tidy needs to drop the fixes that overlap with each
+// other, as -fix does after running many checks over a large code base:
+//
+//   clang-tidy-fixes-benchmark -fixes=100000 -files=100
+//
+// The fixes are synthesized in blocks that mirror the situations of
+// OverlappingReplacementsTest: a token replaced by two checks, a statement
+// replacement that contains renamings, renamings with several usages, and
+// insertions at the same offset and inside other replacements.
+//
+//===----------------------------------------------------------------------===//
+
+#include "../ClangTidyDiagnosticConsumer.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+using namespace llvm;
+
+static cl::OptionCategory BenchmarkCategory(
+    "clang-tidy-fixes-benchmark options");
+
+static cl::opt<unsigned> Iterations("iterations",
+                                    cl::desc("Number of times the fixes are "
+                                             "resolved"),
+                                    cl::init(5), cl::cat(BenchmarkCategory));
+
+static cl::opt<unsigned> NumFixes("fixes",
+                                  cl::desc("Number of fixes to synthesize"),
+                                  cl::init(100000), cl::cat(BenchmarkCategory));
+
+static cl::opt<unsigned> NumFiles("files",
+                                  cl::desc("Number of files the fixes are "
+                                           "spread over"),
+                                  cl::init(100), cl::cat(BenchmarkCategory));
+
+namespace clang {
+namespace tidy {
+
+/// \brief Distance between the blocks of fixes in a file.
+static const unsigned BlockSize = 100;
+
+static void addFix(std::vector<ClangTidyError> &Errors, StringRef CheckName,
+                   StringRef File, ArrayRef<std::pair<unsigned, unsigned>>
+                                       OffsetsAndLengths) {
+  Errors.emplace_back(CheckName, ClangTidyError::Warning, "/",
+                      /*IsWarningAsError=*/false);
+  Errors.back().Message.Message = "warning";
+  Errors.back().Message.FilePath = File;
+  Errors.back().Message.FileOffset = OffsetsAndLengths.front().first;
+  for (const auto &OffsetAndLength : OffsetsAndLengths) {
+    auto Err = Errors.back().Fix[File].add(tooling::Replacement(
+        File, OffsetAndLength.first, OffsetAndLength.second, "x"));
+    if (Err)
+      report_fatal_error(toString(std::move(Err)));
+  }
+}
+
+/// \brief Appends the fixes of the block at \p Begin in \p File to \p Errors.
+static void addBlock(std::vector<ClangTidyError> &Errors, StringRef File,
+                     unsigned Begin) {
+  // "int a = 0;" turned into "char a = 0;" and "int b = 0;" by two checks
+  // whose fixes don't overlap.
+  addFix(Errors, "use-char", File, {{Begin, 3}});
+  addFix(Errors, "start-with-b", File, {{Begin + 4, 1}});
+  // "if (false) { a = 1; b = a; }" removed, which contains the usages of the
+  // variable renamed by another check.
+  addFix(Errors, "if-false", File, {{Begin + 20, 30}});
+  addFix(Errors, "rename-potato", File,
+         {{Begin + 6, 4}, {Begin + 30, 4}, {Begin + 60, 4}});
+  // Two checks replacing the same token, and two checks inserting at the same
+  // offset.
+  addFix(Errors, "upper-case", File, {{Begin + 70, 5}});
+  addFix(Errors, "lower-case", File, {{Begin + 70, 5}});
+  addFix(Errors, "add-semicolon", File, {{Begin + 80, 0}});
+  addFix(Errors, "add-braces", File, {{Begin + 80, 0}});
+  // An insertion inside a replacement.
+  addFix(Errors, "add-const", File, {{Begin + 25, 0}});
+}
+
+static int benchmarkMain(int argc, const char **argv) {
+  cl::HideUnrelatedOptions(BenchmarkCategory);
+  cl::ParseCommandLineOptions(argc, argv);
+
+  std::vector<std::string> Files;
+  for (unsigned I = 0; I < std::max(1u, unsigned(NumFiles)); ++I)
+    Files.push_back("/src/file" + std::to_string(I) + ".cpp");
+  std::vector<ClangTidyError> Errors;
+  for (unsigned Block = 0; Errors.size() < NumFixes; ++Block)
+    addBlock(Errors, Files[Block % Files.size()],
+             Block / Files.size() * BlockSize);
+  Errors.erase(Errors.begin() + NumFixes, Errors.end());
+
+  std::vector<double> Times;
+  size_t NumDropped = 0;
+  for (unsigned I = 0; I != Iterations; ++I) {
+    SmallVector<ClangTidyError, 0> Copy(Errors.begin(), Errors.end());
+    auto Start = std::chrono::steady_clock::now();
+    removeIncompatibleErrors(Copy);
+    std::chrono::duration<double, std::milli> Elapsed =
+        std::chrono::steady_clock::now() - Start;
+    Times.push_back(Elapsed.count());
+    NumDropped = std::count_if(
+        Copy.begin(), Copy.end(),
+        [](const ClangTidyError &Error) { return Error.Fix.empty(); });
+  }
+  if (Times.empty())
+    return 0;
+
+  outs() << "Fixes: " << Errors.size() << " in " << Files.size() << " files\n"
+         << "Dropped: " << NumDropped << "\n";
+  outs() << format("Total: min %.1fms, max %.1fms\n",
+                   *std::min_element(Times.begin(), Times.end()),
+                   *std::max_element(Times.begin(), Times.end()));
+  return 0;
+}
+
+} // namespace tidy
+} // namespace clang
+
+int main(int argc, const char **argv) {
+  return clang::tidy::benchmarkMain(argc, argv);
+}
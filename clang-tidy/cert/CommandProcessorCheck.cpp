@@ -17,18 +17,17 @@ namespace clang {
 namespace tidy {
 namespace cert {
 
-void CommandProcessorCheck::registerMatchers(MatchFinder *Finder) {
-  Finder->addMatcher(
-      callExpr(
-          callee(functionDecl(anyOf(hasName("::system"), hasName("::popen"),
-                                    hasName("::_popen")))
-                     .bind("func")),
-          // Do not diagnose when the call expression passes a null pointer
-          // constant to system(); that only checks for the presence of a
-          // command processor, which is not a security risk by itself.
-          unless(callExpr(callee(functionDecl(hasName("::system"))),
-                          argumentCountIs(1),
-                          hasArgument(0, nullPointerConstant()))))
+void CommandProcessorCheck::registerCallMatchers(CallMatcherIndex *Index) {
+  Index->addMatcher(
+      {"::system", "::popen", "::_popen"},
+      callExpr(callee(functionDecl().bind("func")),
+               // Do not diagnose when the call expression passes a null
+               // pointer constant to system(); that only checks for the
+               // presence of a command processor, which is not a security
+               // risk by itself.
+               unless(callExpr(callee(functionDecl(hasName("::system"))),
+                               argumentCountIs(1),
+                               hasArgument(0, nullPointerConstant()))))
           .bind("expr"),
       this);
 }
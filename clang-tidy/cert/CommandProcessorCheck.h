@@ -27,7 +27,7 @@ class CommandProcessorCheck : public ClangTidyCheck {
 public:
   CommandProcessorCheck(StringRef Name, ClangTidyContext *Context)
       : ClangTidyCheck(Name, Context) {}
-  void registerMatchers(ast_matchers::MatchFinder *Finder) override;
+  void registerCallMatchers(CallMatcherIndex *Index) override;
   void check(const ast_matchers::MatchFinder::MatchResult &Result) override;
 };
 
@@ -27,6 +27,8 @@ public:
       : ClangTidyCheck(Name, Context) {}
   void registerMatchers(ast_matchers::MatchFinder *Finder) override;
   void check(const ast_matchers::MatchFinder::MatchResult &Result) override;
+  // Notes point to the constructors and functions that may throw.
+  bool needsMatchesInAllHeaders() const override { return true; }
 };
 
 } // namespace cert
@@ -38,6 +38,8 @@ public:
   void registerMatchers(ast_matchers::MatchFinder *Finder) override;
   void check(const ast_matchers::MatchFinder::MatchResult &Result) override;
   void storeOptions(ClangTidyOptions::OptionMap &Opts) override;
+  // Notes point to the parameters of the callee.
+  bool needsMatchesInAllHeaders() const override { return true; }
 
 private:
   const bool StrictMode;
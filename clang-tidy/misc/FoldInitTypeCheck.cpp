@@ -17,7 +17,7 @@ namespace clang {
 namespace tidy {
 namespace misc {
 
-void FoldInitTypeCheck::registerMatchers(MatchFinder *Finder) {
+void FoldInitTypeCheck::registerCallMatchers(CallMatcherIndex *Index) {
   // We match functions of interest and bind the iterator and init value types.
   // Note: Right now we check only builtin types.
   const auto BuiltinTypeWithId = [](const char *ID) {
@@ -39,34 +39,34 @@ void FoldInitTypeCheck::registerMatchers(MatchFinder *Finder) {
   const auto InitParam = parmVarDecl(hasType(BuiltinTypeWithId("InitType")));
 
   // std::accumulate, std::reduce.
-  Finder->addMatcher(
-      callExpr(callee(functionDecl(
-                   hasAnyName("::std::accumulate", "::std::reduce"),
-                   hasParameter(0, IteratorParam), hasParameter(2, InitParam))),
+  Index->addMatcher(
+      {"::std::accumulate", "::std::reduce"},
+      callExpr(callee(functionDecl(hasParameter(0, IteratorParam),
+                                   hasParameter(2, InitParam))),
                argumentCountIs(3))
           .bind("Call"),
       this);
   // std::inner_product.
-  Finder->addMatcher(
-      callExpr(callee(functionDecl(hasName("::std::inner_product"),
-                                   hasParameter(0, IteratorParam),
+  Index->addMatcher(
+      {"::std::inner_product"},
+      callExpr(callee(functionDecl(hasParameter(0, IteratorParam),
                                    hasParameter(2, Iterator2Param),
                                    hasParameter(3, InitParam))),
                argumentCountIs(4))
           .bind("Call"),
       this);
   // std::reduce with a policy.
-  Finder->addMatcher(
-      callExpr(callee(functionDecl(hasName("::std::reduce"),
-                                   hasParameter(1, IteratorParam),
+  Index->addMatcher(
+      {"::std::reduce"},
+      callExpr(callee(functionDecl(hasParameter(1, IteratorParam),
                                    hasParameter(3, InitParam))),
                argumentCountIs(4))
           .bind("Call"),
       this);
   // std::inner_product with a policy.
-  Finder->addMatcher(
-      callExpr(callee(functionDecl(hasName("::std::inner_product"),
-                                   hasParameter(1, IteratorParam),
+  Index->addMatcher(
+      {"::std::inner_product"},
+      callExpr(callee(functionDecl(hasParameter(1, IteratorParam),
                                    hasParameter(3, Iterator2Param),
                                    hasParameter(4, InitParam))),
                argumentCountIs(5))
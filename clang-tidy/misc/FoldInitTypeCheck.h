@@ -29,7 +29,7 @@ class FoldInitTypeCheck : public ClangTidyCheck {
 public:
   FoldInitTypeCheck(StringRef Name, ClangTidyContext *Context)
       : ClangTidyCheck(Name, Context) {}
-  void registerMatchers(ast_matchers::MatchFinder *Finder) override;
+  void registerCallMatchers(CallMatcherIndex *Index) override;
   void check(const ast_matchers::MatchFinder::MatchResult &Result) override;
 
 private:
@@ -45,6 +45,8 @@ public:
   void registerMatchers(ast_matchers::MatchFinder *Finder) override;
   void check(const ast_matchers::MatchFinder::MatchResult &Result) override;
   void onEndOfTranslationUnit() override;
+  // Definitions and uses of the declared names in any header matter.
+  bool needsMatchesInAllHeaders() const override { return true; }
 
 private:
   llvm::StringMap<std::vector<const CXXRecordDecl *>> DeclNameToDefinitions;
@@ -31,6 +31,8 @@ public:
   void check(const ast_matchers::MatchFinder::MatchResult &Result) override;
   void registerPPCallbacks(clang::CompilerInstance &Compiler) override;
   void storeOptions(ClangTidyOptions::OptionMap &Opts) override;
+  // Notes point to the constructors of the base or member.
+  bool needsMatchesInAllHeaders() const override { return true; }
 
 private:
   std::unique_ptr<utils::IncludeInserter> Inserter;
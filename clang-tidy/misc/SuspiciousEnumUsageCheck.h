@@ -26,6 +26,8 @@ public:
   void registerMatchers(ast_matchers::MatchFinder *Finder) override;
   void check(const ast_matchers::MatchFinder::MatchResult &Result) override;
   void storeOptions(ClangTidyOptions::OptionMap &Opts) override;
+  // Notes point to the uses of the enum as a bitmask.
+  bool needsMatchesInAllHeaders() const override { return true; }
 
 private:
   void checkSuspiciousBitmaskUsage(const Expr*, const EnumDecl*);
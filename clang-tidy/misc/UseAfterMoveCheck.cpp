@@ -37,7 +37,7 @@ struct UseAfterMove {
 /// various internal helper functions).
 class UseAfterMoveFinder {
 public:
-  UseAfterMoveFinder(ASTContext *TheContext);
+  UseAfterMoveFinder(ASTContext *TheContext, AnalysisCache &Cache);
 
   // Within the given function body, finds the first use of 'MovedVariable' that
   // occurs after 'MovingCall' (the expression that performs the move). If a
@@ -60,8 +60,9 @@ private:
                   llvm::SmallPtrSetImpl<const DeclRefExpr *> *DeclRefs);
 
   ASTContext *Context;
-  std::unique_ptr<ExprSequence> Sequence;
-  std::unique_ptr<StmtToBlockMap> BlockMap;
+  AnalysisCache &Cache;
+  const ExprSequence *Sequence;
+  const StmtToBlockMap *BlockMap;
   llvm::SmallPtrSet<const CFGBlock *, 8> Visited;
 };
 
@@ -81,29 +82,20 @@ static StatementMatcher inDecltypeOrTemplateArg() {
                    to(functionDecl(ast_matchers::isTemplateInstantiation())))));
 }
 
-UseAfterMoveFinder::UseAfterMoveFinder(ASTContext *TheContext)
-    : Context(TheContext) {}
+UseAfterMoveFinder::UseAfterMoveFinder(ASTContext *TheContext,
+                                       AnalysisCache &Cache)
+    : Context(TheContext), Cache(Cache), Sequence(nullptr), BlockMap(nullptr) {}
 
 bool UseAfterMoveFinder::find(Stmt *FunctionBody, const Expr *MovingCall,
                               const ValueDecl *MovedVariable,
                               UseAfterMove *TheUseAfterMove) {
-  // Generate the CFG manually instead of through an AnalysisDeclContext because
-  // it seems the latter can't be used to generate a CFG for the body of a
-  // labmda.
-  //
-  // We include implicit and temporary destructors in the CFG so that
-  // destructors marked [[noreturn]] are handled correctly in the control flow
-  // analysis. (These are used in some styles of assertion macros.)
-  CFG::BuildOptions Options;
-  Options.AddImplicitDtors = true;
-  Options.AddTemporaryDtors = true;
-  std::unique_ptr<CFG> TheCFG =
-      CFG::buildCFG(nullptr, FunctionBody, Context, Options);
+  // The CFG is shared by all moves in the function.
+  const SequencedCFG *TheCFG = getSequencedCFG(FunctionBody, Context, Cache);
   if (!TheCFG)
     return false;
 
-  Sequence.reset(new ExprSequence(TheCFG.get(), Context));
-  BlockMap.reset(new StmtToBlockMap(TheCFG.get(), Context));
+  Sequence = TheCFG->Sequence.get();
+  BlockMap = TheCFG->BlockMap.get();
   Visited.clear();
 
   const CFGBlock *Block = BlockMap->blockContainingStmt(MovingCall);
@@ -421,7 +413,7 @@ void UseAfterMoveCheck::check(const MatchFinder::MatchResult &Result) {
   if (!Arg->getDecl()->getDeclContext()->isFunctionOrMethod())
     return;
 
-  UseAfterMoveFinder finder(Result.Context);
+  UseAfterMoveFinder finder(Result.Context, getAnalysisCache());
   UseAfterMove Use;
   if (finder.find(FunctionBody, MovingCall, Arg->getDecl(), &Use))
     emitDiagnostic(MovingCall, Arg, Use, this, Result.Context);
@@ -49,7 +49,8 @@ void TypePromotionInMathFnCheck::storeOptions(
                 utils::IncludeSorter::toString(IncludeStyle));
 }
 
-void TypePromotionInMathFnCheck::registerMatchers(MatchFinder *Finder) {
+void TypePromotionInMathFnCheck::registerCallMatchers(
+    CallMatcherIndex *Index) {
   constexpr BuiltinType::Kind IntTy = BuiltinType::Int;
   constexpr BuiltinType::Kind LongTy = BuiltinType::Long;
   constexpr BuiltinType::Kind FloatTy = BuiltinType::Float;
@@ -64,26 +65,28 @@ void TypePromotionInMathFnCheck::registerMatchers(MatchFinder *Finder) {
   };
 
   // Match calls to foo(double) with a float argument.
-  auto OneDoubleArgFns = hasAnyName(
+  const std::vector<StringRef> OneDoubleArgFns = {
       "::acos", "::acosh", "::asin", "::asinh", "::atan", "::atanh", "::cbrt",
       "::ceil", "::cos", "::cosh", "::erf", "::erfc", "::exp", "::exp2",
       "::expm1", "::fabs", "::floor", "::ilogb", "::lgamma", "::llrint",
       "::log", "::log10", "::log1p", "::log2", "::logb", "::lrint", "::modf",
       "::nearbyint", "::rint", "::round", "::sin", "::sinh", "::sqrt", "::tan",
-      "::tanh", "::tgamma", "::trunc", "::llround", "::lround");
-  Finder->addMatcher(
-      callExpr(callee(functionDecl(OneDoubleArgFns, parameterCountIs(1),
+      "::tanh", "::tgamma", "::trunc", "::llround", "::lround"};
+  Index->addMatcher(
+      OneDoubleArgFns,
+      callExpr(callee(functionDecl(parameterCountIs(1),
                                    hasBuiltinTyParam(0, DoubleTy))),
                hasBuiltinTyArg(0, FloatTy))
           .bind("call"),
       this);
 
   // Match calls to foo(double, double) where both args are floats.
-  auto TwoDoubleArgFns = hasAnyName("::atan2", "::copysign", "::fdim", "::fmax",
-                                    "::fmin", "::fmod", "::hypot", "::ldexp",
-                                    "::nextafter", "::pow", "::remainder");
-  Finder->addMatcher(
-      callExpr(callee(functionDecl(TwoDoubleArgFns, parameterCountIs(2),
+  const std::vector<StringRef> TwoDoubleArgFns = {
+      "::atan2", "::copysign", "::fdim", "::fmax", "::fmin", "::fmod",
+      "::hypot", "::ldexp", "::nextafter", "::pow", "::remainder"};
+  Index->addMatcher(
+      TwoDoubleArgFns,
+      callExpr(callee(functionDecl(parameterCountIs(2),
                                    hasBuiltinTyParam(0, DoubleTy),
                                    hasBuiltinTyParam(1, DoubleTy))),
                hasBuiltinTyArg(0, FloatTy), hasBuiltinTyArg(1, FloatTy))
@@ -91,8 +94,9 @@ void TypePromotionInMathFnCheck::registerMatchers(MatchFinder *Finder) {
       this);
 
   // Match calls to fma(double, double, double) where all args are floats.
-  Finder->addMatcher(
-      callExpr(callee(functionDecl(hasName("::fma"), parameterCountIs(3),
+  Index->addMatcher(
+      {"::fma"},
+      callExpr(callee(functionDecl(parameterCountIs(3),
                                    hasBuiltinTyParam(0, DoubleTy),
                                    hasBuiltinTyParam(1, DoubleTy),
                                    hasBuiltinTyParam(2, DoubleTy))),
@@ -102,10 +106,10 @@ void TypePromotionInMathFnCheck::registerMatchers(MatchFinder *Finder) {
       this);
 
   // Match calls to frexp(double, int*) where the first arg is a float.
-  Finder->addMatcher(
+  Index->addMatcher(
+      {"::frexp"},
       callExpr(callee(functionDecl(
-                   hasName("::frexp"), parameterCountIs(2),
-                   hasBuiltinTyParam(0, DoubleTy),
+                   parameterCountIs(2), hasBuiltinTyParam(0, DoubleTy),
                    hasParameter(1, parmVarDecl(hasType(pointerType(
                                        pointee(isBuiltinType(IntTy)))))))),
                hasBuiltinTyArg(0, FloatTy))
@@ -114,8 +118,9 @@ void TypePromotionInMathFnCheck::registerMatchers(MatchFinder *Finder) {
 
   // Match calls to nexttoward(double, long double) where the first arg is a
   // float.
-  Finder->addMatcher(
-      callExpr(callee(functionDecl(hasName("::nexttoward"), parameterCountIs(2),
+  Index->addMatcher(
+      {"::nexttoward"},
+      callExpr(callee(functionDecl(parameterCountIs(2),
                                    hasBuiltinTyParam(0, DoubleTy),
                                    hasBuiltinTyParam(1, LongDoubleTy))),
                hasBuiltinTyArg(0, FloatTy))
@@ -124,11 +129,12 @@ void TypePromotionInMathFnCheck::registerMatchers(MatchFinder *Finder) {
 
   // Match calls to remquo(double, double, int*) where the first two args are
   // floats.
-  Finder->addMatcher(
+  Index->addMatcher(
+      {"::remquo"},
       callExpr(
           callee(functionDecl(
-              hasName("::remquo"), parameterCountIs(3),
-              hasBuiltinTyParam(0, DoubleTy), hasBuiltinTyParam(1, DoubleTy),
+              parameterCountIs(3), hasBuiltinTyParam(0, DoubleTy),
+              hasBuiltinTyParam(1, DoubleTy),
               hasParameter(2, parmVarDecl(hasType(pointerType(
                                   pointee(isBuiltinType(IntTy)))))))),
           hasBuiltinTyArg(0, FloatTy), hasBuiltinTyArg(1, FloatTy))
@@ -136,8 +142,9 @@ void TypePromotionInMathFnCheck::registerMatchers(MatchFinder *Finder) {
       this);
 
   // Match calls to scalbln(double, long) where the first arg is a float.
-  Finder->addMatcher(
-      callExpr(callee(functionDecl(hasName("::scalbln"), parameterCountIs(2),
+  Index->addMatcher(
+      {"::scalbln"},
+      callExpr(callee(functionDecl(parameterCountIs(2),
                                    hasBuiltinTyParam(0, DoubleTy),
                                    hasBuiltinTyParam(1, LongTy))),
                hasBuiltinTyArg(0, FloatTy))
@@ -145,8 +152,9 @@ void TypePromotionInMathFnCheck::registerMatchers(MatchFinder *Finder) {
       this);
 
   // Match calls to scalbn(double, int) where the first arg is a float.
-  Finder->addMatcher(
-      callExpr(callee(functionDecl(hasName("::scalbn"), parameterCountIs(2),
+  Index->addMatcher(
+      {"::scalbn"},
+      callExpr(callee(functionDecl(parameterCountIs(2),
                                    hasBuiltinTyParam(0, DoubleTy),
                                    hasBuiltinTyParam(1, IntTy))),
                hasBuiltinTyArg(0, FloatTy))
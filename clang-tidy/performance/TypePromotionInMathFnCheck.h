@@ -32,7 +32,7 @@ public:
 
   void registerPPCallbacks(CompilerInstance &Compiler) override;
   void storeOptions(ClangTidyOptions::OptionMap &Opts) override;
-  void registerMatchers(ast_matchers::MatchFinder *Finder) override;
+  void registerCallMatchers(CallMatcherIndex *Index) override;
   void check(const ast_matchers::MatchFinder::MatchResult &Result) override;
 
 private:
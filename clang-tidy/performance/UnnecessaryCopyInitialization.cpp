@@ -110,10 +110,11 @@ void UnnecessaryCopyInitialization::handleCopyFromMethodReturn(
     const VarDecl &Var, const Stmt &BlockStmt, bool IssueFix,
     const VarDecl *ObjectArg, ASTContext &Context) {
   bool IsConstQualified = Var.getType().isConstQualified();
-  if (!IsConstQualified && !isOnlyUsedAsConst(Var, BlockStmt, Context))
+  if (!IsConstQualified && !isOnlyUsedAsConst(Var, BlockStmt, Context,
+                                               &getAnalysisCache()))
     return;
   if (ObjectArg != nullptr &&
-      !isOnlyUsedAsConst(*ObjectArg, BlockStmt, Context))
+      !isOnlyUsedAsConst(*ObjectArg, BlockStmt, Context, &getAnalysisCache()))
     return;
 
   auto Diagnostic =
@@ -132,8 +133,8 @@ void UnnecessaryCopyInitialization::handleCopyFromMethodReturn(
 void UnnecessaryCopyInitialization::handleCopyFromLocalVar(
     const VarDecl &NewVar, const VarDecl &OldVar, const Stmt &BlockStmt,
     bool IssueFix, ASTContext &Context) {
-  if (!isOnlyUsedAsConst(NewVar, BlockStmt, Context) ||
-      !isOnlyUsedAsConst(OldVar, BlockStmt, Context))
+  if (!isOnlyUsedAsConst(NewVar, BlockStmt, Context, &getAnalysisCache()) ||
+      !isOnlyUsedAsConst(OldVar, BlockStmt, Context, &getAnalysisCache()))
     return;
 
   auto Diagnostic = diag(NewVar.getLocation(),
@@ -89,10 +89,12 @@ void UnnecessaryValueParamCheck::check(const MatchFinder::MatchResult &Result) {
   bool IsConstQualified =
       Param->getType().getCanonicalType().isConstQualified();
 
+  // All parameters of the function are checked, so index the DeclRefExprs of
+  // the function once.
   auto AllDeclRefExprs = utils::decl_ref_expr::allDeclRefExprs(
-      *Param, *Function, *Result.Context);
+      *Param, *Function, *Result.Context, &getAnalysisCache());
   auto ConstDeclRefExprs = utils::decl_ref_expr::constReferenceDeclRefExprs(
-      *Param, *Function, *Result.Context);
+      *Param, *Function, *Result.Context, &getAnalysisCache());
 
   // Do not trigger on non-const value parameters when they are not only used as
   // const.
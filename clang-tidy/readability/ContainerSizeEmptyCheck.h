@@ -31,6 +31,8 @@ public:
   ContainerSizeEmptyCheck(StringRef Name, ClangTidyContext *Context);
   void registerMatchers(ast_matchers::MatchFinder *Finder) override;
   void check(const ast_matchers::MatchFinder::MatchResult &Result) override;
+  // Notes point to the empty() method of the container.
+  bool needsMatchesInAllHeaders() const override { return true; }
 };
 
 } // namespace readability
@@ -31,6 +31,8 @@ public:
 
   void registerMatchers(ast_matchers::MatchFinder *Finder) override;
   void check(const ast_matchers::MatchFinder::MatchResult &Result) override;
+  // Notes point to the other declarations of the function.
+  bool needsMatchesInAllHeaders() const override { return true; }
 
 private:
   void markRedeclarationsAsVisited(const FunctionDecl *FunctionDeclaration);
@@ -26,6 +26,8 @@ public:
       : ClangTidyCheck(Name, Context) {}
   void registerMatchers(ast_matchers::MatchFinder *Finder) override;
   void check(const ast_matchers::MatchFinder::MatchResult &Result) override;
+  // Notes point to the previous declaration.
+  bool needsMatchesInAllHeaders() const override { return true; }
 };
 
 } // namespace readability
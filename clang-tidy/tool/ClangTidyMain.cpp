@@ -16,8 +16,15 @@
 //===----------------------------------------------------------------------===//
 
 #include "../ClangTidy.h"
+#include "../ClangTidyCache.h"
+#include "../ClangTidyForceLinker.h"
+#include "ClangTidyServer.h"
 #include "clang/Tooling/CommonOptionsParser.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Process.h"
+#include <iostream>
+#include <thread>
 
 using namespace clang::ast_matchers;
 using namespace clang::driver;
@@ -106,6 +113,23 @@ JSON array of objects:
                                        cl::init(""),
                                        cl::cat(ClangTidyCategory));
 
+static cl::opt<std::string> Diff("diff", cl::desc(R"(
+Unified diff to read the changed lines from, or '-'
+for the standard input. Only diagnostics on lines
+added by the diff are displayed, like with
+-line-filter, and only declarations overlapping
+them are checked and analyzed.
+)"),
+                                 cl::value_desc("filename"),
+                                 cl::cat(ClangTidyCategory));
+
+static cl::opt<unsigned> DiffStrip("diff-strip", cl::desc(R"(
+Number of leading path components to strip from
+the file names in -diff, like 'patch -p'. Use 1
+for diffs produced by git.
+)"),
+                                   cl::init(0), cl::cat(ClangTidyCategory));
+
 static cl::opt<bool> Fix("fix", cl::desc(R"(
 Apply suggested fixes. Without -fix-errors
 clang-tidy will bail out if any compilation
@@ -199,6 +223,18 @@ code with clang-apply-replacements.
                                         cl::value_desc("filename"),
                                         cl::cat(ClangTidyCategory));
 
+static cl::opt<std::string> ExportCheckProfile("export-check-profile",
+                                               cl::desc(R"(
+JSON file to store the profile of the checks and
+of each translation unit in. Implies
+-enable-check-profile, but doesn't print the
+report. The file can be loaded in the Chrome
+trace viewer (chrome://tracing). Also records the
+growth of the heap ("Memory", in bytes).
+)"),
+                                               cl::value_desc("filename"),
+                                               cl::cat(ClangTidyCategory));
+
 static cl::opt<bool> Quiet("quiet", cl::desc(R"(
 Run clang-tidy in quiet mode. This suppresses
 printing statistics about ignored warnings and
@@ -208,6 +244,45 @@ options are specified.
                            cl::init(false),
                            cl::cat(ClangTidyCategory));
 
+static cl::opt<unsigned> Jobs("j", cl::desc(R"(
+Number of translation units to process in
+parallel. 0 uses one thread per hardware thread.
+The results don't depend on the number of
+threads.
+)"),
+                              cl::init(1), cl::cat(ClangTidyCategory));
+
+static cl::opt<std::string> CacheDir("cache-dir", cl::desc(R"(
+Directory to store the results of translation units
+in. Translation units whose compile command,
+options and files didn't change since they were
+stored are not analyzed again. The directory can be
+shared between runs and projects.
+)"),
+                                     cl::value_desc("directory"),
+                                     cl::cat(ClangTidyCategory));
+
+static cl::opt<bool> Server("server", cl::desc(R"(
+Run as a server for editor integrations: read
+requests to check files from the standard input,
+one JSON object per line, and answer each one
+with its diagnostics on the standard output, in
+the format of -export-fixes. Check modules and
+configuration files are only loaded once.
+)"),
+                            cl::init(false), cl::cat(ClangTidyCategory));
+
+static cl::opt<std::string> ServerPreambleDir("server-preamble-dir",
+                                              cl::desc(R"(
+Directory to store precompiled preambles in with
+-server. The preamble of each file is precompiled
+and reused while the files it includes don't
+change, also by later runs. Checks don't see the
+preprocessor directives of reused preambles.
+)"),
+                                              cl::value_desc("directory"),
+                                              cl::cat(ClangTidyCategory));
+
 namespace clang {
 namespace tidy {
 
@@ -232,11 +307,17 @@ static void printStats(const ClangTidyStats &Stats) {
       llvm::errs() << Separator << Stats.ErrorsIgnoredCheckFilter
                    << " with check filters";
     llvm::errs() << ").\n";
-    if (Stats.ErrorsIgnoredNonUserCode)
-      llvm::errs() << "Use -header-filter=.* to display errors from all "
-                      "non-system headers. Use -system-headers to display "
-                      "errors from system headers as well.\n";
   }
+  if (Stats.DeclsSkippedNonUserCode)
+    llvm::errs() << "Skipped " << Stats.DeclsSkippedNonUserCode
+                 << " declarations in non-user code.\n";
+  if (Stats.ErrorsIgnoredNonUserCode || Stats.DeclsSkippedNonUserCode)
+    llvm::errs() << "Use -header-filter=.* to display errors from all "
+                    "non-system headers. Use -system-headers to display "
+                    "errors from system headers as well.\n";
+  if (Stats.CacheHits || Stats.CacheMisses)
+    llvm::errs() << "Cache: " << Stats.CacheHits << " hits, "
+                 << Stats.CacheMisses << " misses.\n";
 }
 
 static void printProfileData(const ProfileData &Profile,
@@ -274,10 +355,141 @@ static void printProfileData(const ProfileData &Profile,
 
   Total.print(Total, OS);
   OS << "Total\n";
-  OS << Line << "\n";
+  OS << Line;
+
+  if (!Profile.Checks.empty()) {
+    OS << "     Matches  Diagnostics  Callbacks (wall)       Decls      Skipped"
+          "  Name\n";
+    std::vector<std::pair<StringRef, const CheckProfile *>> Checks;
+    for (const auto &P : Profile.Checks)
+      Checks.emplace_back(P.getKey(), &P.getValue());
+    std::sort(Checks.begin(), Checks.end());
+    for (const auto &Check : Checks)
+      OS << format("%12u %12u %15.4fs %12u %12u  ", Check.second->Matches,
+                   Check.second->Diagnostics,
+                   Check.second->Callbacks.getWallTime(),
+                   Check.second->DeclsMatched, Check.second->DeclsSkipped)
+         << Check.first << '\n';
+    OS << Line;
+  }
+  OS << '\n';
   OS.flush();
 }
 
+static void writeJSONString(StringRef S, llvm::raw_ostream &OS) {
+  OS << '"';
+  for (char C : S) {
+    if (C == '"' || C == '\\')
+      OS << '\\' << C;
+    else if (static_cast<unsigned char>(C) < 0x20)
+      OS << format("\\u%04x", C);
+    else
+      OS << C;
+  }
+  OS << '"';
+}
+
+static void writeJSONTimes(StringRef Prefix, const llvm::TimeRecord &Time,
+                           llvm::raw_ostream &OS) {
+  OS << format("\"%sWallTime\": %.6f, ", Prefix.str().c_str(),
+               Time.getWallTime())
+     << format("\"%sUserTime\": %.6f, ", Prefix.str().c_str(),
+               Time.getUserTime())
+     << format("\"%sSystemTime\": %.6f", Prefix.str().c_str(),
+               Time.getSystemTime());
+}
+
+static void writeJSONMemory(StringRef Prefix, int64_t Memory,
+                            llvm::raw_ostream &OS) {
+  OS << ", \"" << Prefix << "Memory\": " << Memory;
+}
+
+/// \brief Writes \p Profile as a JSON object. Besides the data of the checks
+/// and of the translation units, it contains a "traceEvents" array with the
+/// phases of each translation unit in the Chrome trace event format.
+///
+/// All \p EnabledChecks are listed, even those that didn't match anything or
+/// that have no matchers, such as checks only using PPCallbacks.
+static void exportProfileData(const ProfileData &Profile,
+                              ArrayRef<std::string> EnabledChecks,
+                              llvm::raw_ostream &OS) {
+  std::vector<StringRef> CheckNames(EnabledChecks.begin(),
+                                    EnabledChecks.end());
+  // Checks enabled only by the configuration of some files.
+  for (const auto &Record : Profile.Records)
+    CheckNames.push_back(Record.getKey());
+  for (const auto &Check : Profile.Checks)
+    CheckNames.push_back(Check.getKey());
+  std::sort(CheckNames.begin(), CheckNames.end());
+  CheckNames.erase(std::unique(CheckNames.begin(), CheckNames.end()),
+                   CheckNames.end());
+
+  OS << "{\n  \"checks\": [";
+  StringRef Separator = "\n";
+  for (StringRef Name : CheckNames) {
+    CheckProfile Check = Profile.Checks.lookup(Name);
+    llvm::TimeRecord Matchers = Profile.Records.lookup(Name);
+    Matchers -= Check.Callbacks;
+    OS << Separator << "    {\"name\": ";
+    writeJSONString(Name, OS);
+    OS << ", \"matches\": " << Check.Matches
+       << ", \"diagnostics\": " << Check.Diagnostics << ", ";
+    writeJSONTimes("matcher", Matchers, OS);
+    OS << ", ";
+    writeJSONTimes("callback", Check.Callbacks, OS);
+    writeJSONMemory("callback", Check.CallbackMemory, OS);
+    OS << "}";
+    Separator = ",\n";
+  }
+
+  OS << "\n  ],\n  \"translationUnits\": [";
+  Separator = "\n";
+  for (const TranslationUnitProfile &TU : Profile.TranslationUnits) {
+    OS << Separator << "    {\"file\": ";
+    writeJSONString(TU.File, OS);
+    OS << ", \"thread\": " << TU.Thread << ", ";
+    writeJSONTimes("frontend", TU.Frontend, OS);
+    writeJSONMemory("frontend", TU.FrontendMemory, OS);
+    OS << ", ";
+    writeJSONTimes("checks", TU.Checks, OS);
+    writeJSONMemory("checks", TU.ChecksMemory, OS);
+    OS << ", ";
+    writeJSONTimes("analyzer", TU.Analyzer, OS);
+    writeJSONMemory("analyzer", TU.AnalyzerMemory, OS);
+    OS << "}";
+    Separator = ",\n";
+  }
+
+  // Trace events are in microseconds from the start of the first translation
+  // unit.
+  double FirstStart = 0;
+  for (const TranslationUnitProfile &TU : Profile.TranslationUnits) {
+    if (FirstStart == 0 || TU.StartTime < FirstStart)
+      FirstStart = TU.StartTime;
+  }
+  OS << "\n  ],\n  \"traceEvents\": [";
+  Separator = "\n";
+  for (const TranslationUnitProfile &TU : Profile.TranslationUnits) {
+    double Start = TU.StartTime - FirstStart;
+    std::pair<StringRef, const llvm::TimeRecord *> Phases[] = {
+        {"Frontend", &TU.Frontend},
+        {"Checks", &TU.Checks},
+        {"Analyzer", &TU.Analyzer}};
+    for (const auto &Phase : Phases) {
+      OS << Separator << "    {\"name\": \"" << Phase.first
+         << "\", \"cat\": \"clang-tidy\", \"ph\": \"X\", \"pid\": 0, \"tid\": "
+         << TU.Thread << format(", \"ts\": %.0f, \"dur\": %.0f", Start * 1e6,
+                                Phase.second->getWallTime() * 1e6)
+         << ", \"args\": {\"file\": ";
+      writeJSONString(TU.File, OS);
+      OS << "}}";
+      Start += Phase.second->getWallTime();
+      Separator = ",\n";
+    }
+  }
+  OS << "\n  ]\n}\n";
+}
+
 static std::unique_ptr<ClangTidyOptionsProvider> createOptionsProvider() {
   ClangTidyGlobalOptions GlobalOptions;
   if (std::error_code Err = parseLineFilter(LineFilter, GlobalOptions)) {
@@ -285,6 +497,24 @@ static std::unique_ptr<ClangTidyOptionsProvider> createOptionsProvider() {
     llvm::cl::PrintHelpMessage(/*Hidden=*/false, /*Categorized=*/true);
     return nullptr;
   }
+  if (!Diff.empty()) {
+    if (!LineFilter.empty()) {
+      llvm::errs() << "Error: -diff and -line-filter can't be used together.\n";
+      return nullptr;
+    }
+    auto Text = llvm::MemoryBuffer::getFileOrSTDIN(Diff);
+    if (!Text) {
+      llvm::errs() << "Error reading " << Diff << ": "
+                   << Text.getError().message() << "\n";
+      return nullptr;
+    }
+    if (std::error_code Err = parseLineFilterFromDiff((*Text)->getBuffer(),
+                                                      DiffStrip,
+                                                      GlobalOptions)) {
+      llvm::errs() << "Invalid diff: " << Err.message() << "\n";
+      return nullptr;
+    }
+  }
 
   ClangTidyOptions DefaultOptions;
   DefaultOptions.Checks = DefaultChecks;
@@ -338,6 +568,13 @@ static int clangTidyMain(int argc, const char **argv) {
   if (!OptionsProvider)
     return 1;
 
+  // An empty line filter would display the diagnostics of all lines.
+  if (!Diff.empty() && OptionsProvider->getGlobalOptions().LineFilter.empty()) {
+    if (!Quiet)
+      llvm::errs() << "No lines added by the diff.\n";
+    return 0;
+  }
+
   StringRef FileName("dummy");
   auto PathList = OptionsParser.getSourcePathList();
   if (!PathList.empty()) {
@@ -389,6 +626,15 @@ static int clangTidyMain(int argc, const char **argv) {
     return 0;
   }
 
+  if (Server) {
+    // The checks are enabled by the configuration of each requested file.
+    ClangTidyContext Context(std::move(OwningOptionsProvider));
+    ClangTidyServer TidyServer(Context, OptionsParser.getCompilations(),
+                               ServerPreambleDir);
+    TidyServer.run(std::cin, llvm::outs());
+    return 0;
+  }
+
   if (EnabledChecks.empty()) {
     llvm::errs() << "Error: no checks enabled.\n";
     llvm::cl::PrintHelpMessage(/*Hidden=*/false, /*Categorized=*/true);
@@ -402,10 +648,20 @@ static int clangTidyMain(int argc, const char **argv) {
   }
 
   ProfileData Profile;
+  Profile.TrackMemory = !ExportCheckProfile.empty();
 
   ClangTidyContext Context(std::move(OwningOptionsProvider));
+  unsigned NumThreads = Jobs;
+  if (NumThreads == 0)
+    NumThreads = std::max(1u, std::thread::hardware_concurrency());
+  std::unique_ptr<ClangTidyCache> Cache;
+  if (!CacheDir.empty())
+    Cache = llvm::make_unique<ClangTidyCache>(CacheDir);
   runClangTidy(Context, OptionsParser.getCompilations(), PathList,
-               EnableCheckProfile ? &Profile : nullptr);
+               EnableCheckProfile || !ExportCheckProfile.empty() ? &Profile
+                                                                 : nullptr,
+               NumThreads,
+               Cache.get());
   ArrayRef<ClangTidyError> Errors = Context.getErrors();
   bool FoundErrors =
       std::find_if(Errors.begin(), Errors.end(), [](const ClangTidyError &E) {
@@ -440,6 +696,16 @@ static int clangTidyMain(int argc, const char **argv) {
   if (EnableCheckProfile)
     printProfileData(Profile, llvm::errs());
 
+  if (!ExportCheckProfile.empty()) {
+    std::error_code EC;
+    llvm::raw_fd_ostream OS(ExportCheckProfile, EC, llvm::sys::fs::F_None);
+    if (EC) {
+      llvm::errs() << "Error opening output file: " << EC.message() << '\n';
+      return 1;
+    }
+    exportProfileData(Profile, EnabledChecks, OS);
+  }
+
   if (WErrorCount) {
     if (!Quiet) {
       StringRef Plural = WErrorCount == 1 ? "" : "s";
@@ -452,61 +718,6 @@ static int clangTidyMain(int argc, const char **argv) {
   return 0;
 }
 
-// This anchor is used to force the linker to link the CERTModule.
-extern volatile int CERTModuleAnchorSource;
-static int LLVM_ATTRIBUTE_UNUSED CERTModuleAnchorDestination =
-    CERTModuleAnchorSource;
-
-// This anchor is used to force the linker to link the BoostModule.
-extern volatile int BoostModuleAnchorSource;
-static int LLVM_ATTRIBUTE_UNUSED BoostModuleAnchorDestination =
-    BoostModuleAnchorSource;
-
-// This anchor is used to force the linker to link the LLVMModule.
-extern volatile int LLVMModuleAnchorSource;
-static int LLVM_ATTRIBUTE_UNUSED LLVMModuleAnchorDestination =
-    LLVMModuleAnchorSource;
-
-// This anchor is used to force the linker to link the CppCoreGuidelinesModule.
-extern volatile int CppCoreGuidelinesModuleAnchorSource;
-static int LLVM_ATTRIBUTE_UNUSED CppCoreGuidelinesModuleAnchorDestination =
-    CppCoreGuidelinesModuleAnchorSource;
-
-// This anchor is used to force the linker to link the GoogleModule.
-extern volatile int GoogleModuleAnchorSource;
-static int LLVM_ATTRIBUTE_UNUSED GoogleModuleAnchorDestination =
-    GoogleModuleAnchorSource;
-
-// This anchor is used to force the linker to link the MiscModule.
-extern volatile int MiscModuleAnchorSource;
-static int LLVM_ATTRIBUTE_UNUSED MiscModuleAnchorDestination =
-    MiscModuleAnchorSource;
-
-// This anchor is used to force the linker to link the ModernizeModule.
-extern volatile int ModernizeModuleAnchorSource;
-static int LLVM_ATTRIBUTE_UNUSED ModernizeModuleAnchorDestination =
-    ModernizeModuleAnchorSource;
-
-// This anchor is used to force the linker to link the MPIModule.
-extern volatile int MPIModuleAnchorSource;
-static int LLVM_ATTRIBUTE_UNUSED MPIModuleAnchorDestination =
-    MPIModuleAnchorSource;
-
-// This anchor is used to force the linker to link the PerformanceModule.
-extern volatile int PerformanceModuleAnchorSource;
-static int LLVM_ATTRIBUTE_UNUSED PerformanceModuleAnchorDestination =
-    PerformanceModuleAnchorSource;
-
-// This anchor is used to force the linker to link the ReadabilityModule.
-extern volatile int ReadabilityModuleAnchorSource;
-static int LLVM_ATTRIBUTE_UNUSED ReadabilityModuleAnchorDestination =
-    ReadabilityModuleAnchorSource;
-
-// This anchor is used to force the linker to link the HICPPModule.
-extern volatile int HICPPModuleAnchorSource;
-static int LLVM_ATTRIBUTE_UNUSED HICPPModuleAnchorDestination =
-    HICPPModuleAnchorSource;
-
 } // namespace tidy
 } // namespace clang
 
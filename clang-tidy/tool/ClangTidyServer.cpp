@@ -0,0 +1,192 @@
+//===--- ClangTidyServer.cpp - clang-tidy ---------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "ClangTidyServer.h"
+#include "../../preamble-store/PreambleStore.h"
+#include "../ClangTidy.h"
+#include "clang/Frontend/PCHContainerOperations.h"
+#include "clang/Tooling/CompilationDatabase.h"
+#include "clang/Tooling/Tooling.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/YAMLParser.h"
+#include "llvm/Support/raw_ostream.h"
+#include <istream>
+
+using namespace clang;
+using namespace clang::tidy;
+using namespace clang::tooling;
+
+namespace {
+/// \brief A request read from a client.
+struct Request {
+  std::string File;
+  std::string Directory;
+  std::vector<std::string> CommandLine;
+  llvm::Optional<std::string> Contents;
+  bool Reload = false;
+};
+} // namespace
+
+/// \brief Parses the JSON object \p Line into \p Req. Returns false if it's not
+/// a valid request.
+static bool parseRequest(StringRef Line, Request &Req) {
+  llvm::SourceMgr SM;
+  llvm::yaml::Stream Stream(Line, SM);
+  llvm::yaml::document_iterator Doc = Stream.begin();
+  if (Doc == Stream.end())
+    return false;
+  auto *Object = dyn_cast_or_null<llvm::yaml::MappingNode>(Doc->getRoot());
+  if (!Object)
+    return false;
+
+  for (llvm::yaml::KeyValueNode &Entry : *Object) {
+    auto *Key = dyn_cast_or_null<llvm::yaml::ScalarNode>(Entry.getKey());
+    if (!Key)
+      return false;
+    SmallString<16> KeyStorage;
+    StringRef KeyName = Key->getValue(KeyStorage);
+    llvm::yaml::Node *Value = Entry.getValue();
+
+    if (KeyName == "command") {
+      auto *Args = dyn_cast_or_null<llvm::yaml::SequenceNode>(Value);
+      if (!Args)
+        return false;
+      for (llvm::yaml::Node &Arg : *Args) {
+        auto *ArgValue = dyn_cast<llvm::yaml::ScalarNode>(&Arg);
+        if (!ArgValue)
+          return false;
+        SmallString<64> Storage;
+        Req.CommandLine.push_back(ArgValue->getValue(Storage));
+      }
+      continue;
+    }
+
+    auto *Scalar = dyn_cast_or_null<llvm::yaml::ScalarNode>(Value);
+    if (!Scalar)
+      return false;
+    SmallString<128> Storage;
+    StringRef String = Scalar->getValue(Storage);
+    if (KeyName == "file")
+      Req.File = String;
+    else if (KeyName == "directory")
+      Req.Directory = String;
+    else if (KeyName == "contents")
+      Req.Contents = String.str();
+    else if (KeyName == "reload")
+      Req.Reload = String == "true";
+    // Ignore unknown keys, newer clients may send them.
+  }
+  return !Stream.failed() && (Req.Reload || !Req.File.empty());
+}
+
+ClangTidyServer::ClangTidyServer(ClangTidyContext &Context,
+                                 const CompilationDatabase &Compilations,
+                                 StringRef PreambleDirectory)
+    : Context(Context), Compilations(Compilations),
+      DiagConsumer(Context),
+      Factory(createClangTidyActionFactory(Context)),
+      Adjuster(combineAdjusters(
+          combineAdjusters(getClangStripOutputAdjuster(),
+                           getClangSyntaxOnlyAdjuster()),
+          getClangTidyArgumentsAdjuster(Context))),
+      PCHs(std::make_shared<PCHContainerOperations>()) {
+  if (!PreambleDirectory.empty())
+    Preambles = llvm::make_unique<preamble::PreambleStore>(PreambleDirectory,
+                                                         PCHs);
+}
+
+ClangTidyServer::~ClangTidyServer() = default;
+
+void ClangTidyServer::run(std::istream &In, raw_ostream &Out) {
+  std::string Line;
+  while (std::getline(In, Line)) {
+    if (StringRef(Line).trim().empty())
+      continue;
+    Request Req;
+    std::vector<ClangTidyError> Errors;
+    if (!parseRequest(Line, Req))
+      llvm::errs() << "Invalid request: " << Line << "\n";
+    else if (Req.Reload)
+      Context.clearOptionsCache();
+    else
+      Errors = checkFile(Req.File, Req.Directory, Req.CommandLine,
+                         Req.Contents ? llvm::Optional<StringRef>(*Req.Contents)
+                                      : llvm::None);
+    // Answer every request, so that clients don't wait for an answer forever.
+    exportReplacements(Req.File, Errors, Out);
+    Out.flush();
+  }
+}
+
+std::vector<ClangTidyError>
+ClangTidyServer::checkFile(StringRef File, StringRef Directory,
+                           ArrayRef<std::string> CommandLine,
+                           llvm::Optional<StringRef> Contents) {
+  std::string AbsolutePath = getAbsolutePath(File);
+  std::vector<CompileCommand> Commands;
+  if (!CommandLine.empty()) {
+    SmallString<128> WorkingDir(Directory);
+    if (WorkingDir.empty())
+      llvm::sys::fs::current_path(WorkingDir);
+    Commands.push_back(
+        CompileCommand(WorkingDir, AbsolutePath, CommandLine.vec(), ""));
+  } else {
+    Commands = Compilations.getCompileCommands(AbsolutePath);
+  }
+  if (Commands.empty()) {
+    llvm::errs() << "Skipping " << AbsolutePath
+                 << ". Compile command not found.\n";
+    return {};
+  }
+
+  std::unique_ptr<llvm::MemoryBuffer> FileBuffer;
+  if (!Contents && Preambles) {
+    if (auto Buffer = llvm::MemoryBuffer::getFile(AbsolutePath)) {
+      FileBuffer = std::move(*Buffer);
+      Contents = FileBuffer->getBuffer();
+    }
+  }
+
+  static int StaticSymbol;
+  std::string MainExecutable =
+      llvm::sys::fs::getMainExecutable("clang_tool", &StaticSymbol);
+  for (CompileCommand &Command : Commands) {
+    CommandLineArguments Args = Adjuster(Command.CommandLine, AbsolutePath);
+    assert(!Args.empty());
+    Args[0] = MainExecutable;
+    // Like runClangTidy() with several threads, don't change the working
+    // directory of the process.
+    Args.insert(Args.begin() + 1, "-working-directory=" + Command.Directory);
+    if (Preambles && Contents) {
+      // Preambles with errors are parsed with the main file, which reports
+      // them.
+      if (auto Preamble = Preambles->getPreamble(Args, AbsolutePath, *Contents))
+        preamble::PreambleStore::addPreambleArguments(*Preamble, Args);
+    }
+
+    FileSystemOptions FileSystemOpts;
+    FileSystemOpts.WorkingDir = Command.Directory;
+    IntrusiveRefCntPtr<FileManager> Files(new FileManager(FileSystemOpts));
+    ToolInvocation Invocation(std::move(Args), Factory.get(), Files.get(),
+                              PCHs);
+    Invocation.setDiagnosticConsumer(&DiagConsumer);
+    if (Contents)
+      Invocation.mapVirtualFile(AbsolutePath, *Contents);
+    if (!Invocation.run())
+      llvm::errs() << "Error while processing " << AbsolutePath << ".\n";
+  }
+
+  ArrayRef<ClangTidyError> Errors = Context.getErrors();
+  std::vector<ClangTidyError> Result(Errors.begin(), Errors.end());
+  Context.clearErrors();
+  return Result;
+}
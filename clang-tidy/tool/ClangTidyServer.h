@@ -0,0 +1,92 @@
+//===--- ClangTidyServer.h - clang-tidy -------------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_TOOLS_EXTRA_CLANG_TIDY_TOOL_CLANGTIDYSERVER_H
+#define LLVM_CLANG_TOOLS_EXTRA_CLANG_TIDY_TOOL_CLANGTIDYSERVER_H
+
+#include "../ClangTidyDiagnosticConsumer.h"
+#include "clang/Tooling/ArgumentsAdjusters.h"
+#include "llvm/ADT/Optional.h"
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace clang {
+
+class PCHContainerOperations;
+
+namespace preamble {
+class PreambleStore;
+}
+
+namespace tooling {
+class CompilationDatabase;
+class FrontendActionFactory;
+}
+
+namespace tidy {
+
+/// \brief Runs clang-tidy on the files requested by a client, e.g. an editor
+/// integration, that checks single files repeatedly.
+///
+/// The check modules are instantiated and the configuration files are read
+/// only once for all requests. If a preamble directory is given, the preamble
+/// of each file is precompiled into a preamble::PreambleStore and reused while
+/// the files it includes don't change, so that only the rest of the main file
+/// is parsed for each request. Checks still see the declarations of a reused
+/// preamble, but not its preprocessor directives.
+///
+/// Requests are JSON objects, one per line:
+/// \code
+///   {"file": "/src/a.cpp", "directory": "/build",
+///    "command": ["clang++", "-c", "/src/a.cpp"], "contents": "..."}
+/// \endcode
+/// Only "file" is required. Without "command", the compile commands of the
+/// file are taken from the compilation database. "contents" is checked instead
+/// of the contents of the file on disk. The request {"reload": true} makes the
+/// server read the configuration files again.
+///
+/// Every request is answered with a YAML document in the format of
+/// -export-fixes, which ends with a "..." line.
+class ClangTidyServer {
+public:
+  ClangTidyServer(ClangTidyContext &Context,
+                  const tooling::CompilationDatabase &Compilations,
+                  StringRef PreambleDirectory);
+  ~ClangTidyServer();
+
+  /// \brief Answers the requests read from \p In on \p Out until \p In ends.
+  void run(std::istream &In, raw_ostream &Out);
+
+  /// \brief Runs the checks on \p File and returns the errors.
+  ///
+  /// \p File is compiled with \p CommandLine in \p Directory if
+  /// \p CommandLine is not empty, and with its commands from the compilation
+  /// database otherwise. If \p Contents is set, it replaces the contents of
+  /// \p File.
+  std::vector<ClangTidyError> checkFile(StringRef File, StringRef Directory,
+                                        ArrayRef<std::string> CommandLine,
+                                        llvm::Optional<StringRef> Contents);
+
+private:
+  ClangTidyContext &Context;
+  const tooling::CompilationDatabase &Compilations;
+  ClangTidyDiagnosticConsumer DiagConsumer;
+  std::unique_ptr<tooling::FrontendActionFactory> Factory;
+  tooling::ArgumentsAdjuster Adjuster;
+  std::shared_ptr<PCHContainerOperations> PCHs;
+  /// \brief nullptr if preambles are not precompiled.
+  std::unique_ptr<preamble::PreambleStore> Preambles;
+};
+
+} // end namespace tidy
+} // end namespace clang
+
+#endif // LLVM_CLANG_TOOLS_EXTRA_CLANG_TIDY_TOOL_CLANGTIDYSERVER_H
@@ -38,13 +38,85 @@ void extractNodesByIdTo(ArrayRef<BoundNodes> Matches, StringRef ID,
     Nodes.insert(Match.getNodeAs<Node>(ID));
 }
 
+// Matches Matcher on Stmt and its descendants, like findAll().
+SmallVector<BoundNodes, 1> matchWithin(const StatementMatcher &Matcher,
+                                       const Stmt &Stmt, ASTContext &Context) {
+  return match(findAll(Matcher), Stmt, Context);
+}
+
+// Matches Matcher on the descendants of Decl.
+SmallVector<BoundNodes, 1> matchWithin(const StatementMatcher &Matcher,
+                                       const Decl &Decl, ASTContext &Context) {
+  return match(decl(forEachDescendant(Matcher)), Decl, Context);
+}
+
+// The DeclRefExprs to each variable within a Stmt or Decl, and the ones among
+// them that access the variable in a const fashion.
+struct DeclRefIndex : AnalysisCache::Result {
+  static char ID;
+
+  typedef SmallPtrSet<const DeclRefExpr *, 16> DeclRefSet;
+  llvm::DenseMap<const VarDecl *, DeclRefSet> All;
+  llvm::DenseMap<const VarDecl *, DeclRefSet> Const;
+};
+
+char DeclRefIndex::ID;
+
+// Adds the DeclRefExprs bound to "declRef" in Matches to the sets of their
+// variables.
+void indexDeclRefs(
+    ArrayRef<BoundNodes> Matches,
+    llvm::DenseMap<const VarDecl *, DeclRefIndex::DeclRefSet> &Map) {
+  for (const auto &Match : Matches) {
+    const auto *DeclRef = Match.getNodeAs<DeclRefExpr>("declRef");
+    if (const auto *Var = dyn_cast<VarDecl>(DeclRef->getDecl()))
+      Map[Var].insert(DeclRef);
+  }
+}
+
+// Returns the index of Node, a Stmt or a Decl, which is built with the same
+// matchers as allDeclRefExprs() and constReferenceDeclRefExprs(), but for all
+// variables at once.
+template <typename NodeT>
+const DeclRefIndex &getDeclRefIndex(const NodeT &Node, ASTContext &Context,
+                                    AnalysisCache &Cache) {
+  return Cache.get<DeclRefIndex>(&Node, [&] {
+    auto Index = llvm::make_unique<DeclRefIndex>();
+    auto DeclRefToVar = declRefExpr(to(varDecl())).bind("declRef");
+    indexDeclRefs(matchWithin(DeclRefToVar, Node, Context), Index->All);
+
+    auto ConstMethodCallee = callee(cxxMethodDecl(isConst()));
+    indexDeclRefs(
+        matchWithin(
+            expr(anyOf(cxxMemberCallExpr(ConstMethodCallee, on(DeclRefToVar)),
+                       cxxOperatorCallExpr(ConstMethodCallee,
+                                           hasArgument(0, DeclRefToVar)))),
+            Node, Context),
+        Index->Const);
+    auto ConstReferenceOrValue =
+        qualType(anyOf(referenceType(pointee(qualType(isConstQualified()))),
+                       unless(anyOf(referenceType(), pointerType()))));
+    auto UsedAsConstRefOrValueArg = forEachArgumentWithParam(
+        DeclRefToVar, parmVarDecl(hasType(ConstReferenceOrValue)));
+    indexDeclRefs(
+        matchWithin(callExpr(UsedAsConstRefOrValueArg), Node, Context),
+        Index->Const);
+    indexDeclRefs(
+        matchWithin(cxxConstructExpr(UsedAsConstRefOrValueArg), Node, Context),
+        Index->Const);
+    return Index;
+  });
+}
+
 } // namespace
 
 // Finds all DeclRefExprs where a const method is called on VarDecl or VarDecl
 // is the a const reference or value argument to a CallExpr or CXXConstructExpr.
 SmallPtrSet<const DeclRefExpr *, 16>
 constReferenceDeclRefExprs(const VarDecl &VarDecl, const Stmt &Stmt,
-                           ASTContext &Context) {
+                           ASTContext &Context, AnalysisCache *Cache) {
+  if (Cache)
+    return getDeclRefIndex(Stmt, Context, *Cache).Const.lookup(&VarDecl);
   auto DeclRefToVar =
       declRefExpr(to(varDecl(equalsNode(&VarDecl)))).bind("declRef");
   auto ConstMethodCallee = callee(cxxMethodDecl(isConst()));
@@ -75,7 +147,9 @@ constReferenceDeclRefExprs(const VarDecl &VarDecl, const Stmt &Stmt,
 // is the a const reference or value argument to a CallExpr or CXXConstructExpr.
 SmallPtrSet<const DeclRefExpr *, 16>
 constReferenceDeclRefExprs(const VarDecl &VarDecl, const Decl &Decl,
-                           ASTContext &Context) {
+                           ASTContext &Context, AnalysisCache *Cache) {
+  if (Cache)
+    return getDeclRefIndex(Decl, Context, *Cache).Const.lookup(&VarDecl);
   auto DeclRefToVar =
       declRefExpr(to(varDecl(equalsNode(&VarDecl)))).bind("declRef");
   auto ConstMethodCallee = callee(cxxMethodDecl(isConst()));
@@ -106,19 +180,23 @@ constReferenceDeclRefExprs(const VarDecl &VarDecl, const Decl &Decl,
 }
 
 bool isOnlyUsedAsConst(const VarDecl &Var, const Stmt &Stmt,
-                       ASTContext &Context) {
+                       ASTContext &Context, AnalysisCache *Cache) {
   // Collect all DeclRefExprs to the loop variable and all CallExprs and
   // CXXConstructExprs where the loop variable is used as argument to a const
   // reference parameter.
   // If the difference is empty it is safe for the loop variable to be a const
   // reference.
-  auto AllDeclRefs = allDeclRefExprs(Var, Stmt, Context);
-  auto ConstReferenceDeclRefs = constReferenceDeclRefExprs(Var, Stmt, Context);
+  auto AllDeclRefs = allDeclRefExprs(Var, Stmt, Context, Cache);
+  auto ConstReferenceDeclRefs =
+      constReferenceDeclRefExprs(Var, Stmt, Context, Cache);
   return isSetDifferenceEmpty(AllDeclRefs, ConstReferenceDeclRefs);
 }
 
 SmallPtrSet<const DeclRefExpr *, 16>
-allDeclRefExprs(const VarDecl &VarDecl, const Stmt &Stmt, ASTContext &Context) {
+allDeclRefExprs(const VarDecl &VarDecl, const Stmt &Stmt, ASTContext &Context,
+                AnalysisCache *Cache) {
+  if (Cache)
+    return getDeclRefIndex(Stmt, Context, *Cache).All.lookup(&VarDecl);
   auto Matches = match(
       findAll(declRefExpr(to(varDecl(equalsNode(&VarDecl)))).bind("declRef")),
       Stmt, Context);
@@ -128,7 +206,10 @@ allDeclRefExprs(const VarDecl &VarDecl, const Stmt &Stmt, ASTContext &Context) {
 }
 
 SmallPtrSet<const DeclRefExpr *, 16>
-allDeclRefExprs(const VarDecl &VarDecl, const Decl &Decl, ASTContext &Context) {
+allDeclRefExprs(const VarDecl &VarDecl, const Decl &Decl, ASTContext &Context,
+                AnalysisCache *Cache) {
+  if (Cache)
+    return getDeclRefIndex(Decl, Context, *Cache).All.lookup(&VarDecl);
   auto Matches = match(
       decl(forEachDescendant(
           declRefExpr(to(varDecl(equalsNode(&VarDecl)))).bind("declRef"))),
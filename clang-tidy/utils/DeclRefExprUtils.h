@@ -10,6 +10,7 @@
 #ifndef LLVM_CLANG_TOOLS_EXTRA_CLANG_TIDY_UTILS_DECLREFEXPRUTILS_H
 #define LLVM_CLANG_TOOLS_EXTRA_CLANG_TIDY_UTILS_DECLREFEXPRUTILS_H
 
+#include "../AnalysisCache.h"
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/Type.h"
 #include "llvm/ADT/SmallPtrSet.h"
@@ -19,6 +20,11 @@ namespace tidy {
 namespace utils {
 namespace decl_ref_expr {
 
+// The functions below that take an optional ``AnalysisCache`` traverse the
+// ``Stmt`` or ``Decl`` once for all variables when it is provided, and look up
+// the ``DeclRefExprs`` of each variable in the index stored in the cache. This
+// is faster when several variables of the same function are queried.
+
 /// \brief Returns true if all ``DeclRefExpr`` to the variable within ``Stmt``
 /// do not modify it.
 ///
@@ -26,27 +32,31 @@ namespace decl_ref_expr {
 /// variable or the variable is a const reference or value argument to a
 /// ``callExpr()``.
 bool isOnlyUsedAsConst(const VarDecl &Var, const Stmt &Stmt,
-                       ASTContext &Context);
+                       ASTContext &Context, AnalysisCache *Cache = nullptr);
 
 /// Returns set of all ``DeclRefExprs`` to ``VarDecl`` within ``Stmt``.
 llvm::SmallPtrSet<const DeclRefExpr *, 16>
-allDeclRefExprs(const VarDecl &VarDecl, const Stmt &Stmt, ASTContext &Context);
+allDeclRefExprs(const VarDecl &VarDecl, const Stmt &Stmt, ASTContext &Context,
+                AnalysisCache *Cache = nullptr);
 
 /// Returns set of all ``DeclRefExprs`` to ``VarDecl`` within ``Decl``.
 llvm::SmallPtrSet<const DeclRefExpr *, 16>
-allDeclRefExprs(const VarDecl &VarDecl, const Decl &Decl, ASTContext &Context);
+allDeclRefExprs(const VarDecl &VarDecl, const Decl &Decl, ASTContext &Context,
+                AnalysisCache *Cache = nullptr);
 
 /// Returns set of all ``DeclRefExprs`` to ``VarDecl`` within ``Stmt`` where
 /// ``VarDecl`` is guaranteed to be accessed in a const fashion.
 llvm::SmallPtrSet<const DeclRefExpr *, 16>
 constReferenceDeclRefExprs(const VarDecl &VarDecl, const Stmt &Stmt,
-                           ASTContext &Context);
+                           ASTContext &Context,
+                           AnalysisCache *Cache = nullptr);
 
 /// Returns set of all ``DeclRefExprs`` to ``VarDecl`` within ``Decl`` where
 /// ``VarDecl`` is guaranteed to be accessed in a const fashion.
 llvm::SmallPtrSet<const DeclRefExpr *, 16>
 constReferenceDeclRefExprs(const VarDecl &VarDecl, const Decl &Decl,
-                           ASTContext &Context);
+                           ASTContext &Context,
+                           AnalysisCache *Cache = nullptr);
 
 /// Returns ``true`` if ``DeclRefExpr`` is the argument of a copy-constructor
 /// call expression within ``Decl``.
@@ -177,6 +177,29 @@ const CFGBlock *StmtToBlockMap::blockContainingStmt(const Stmt *S) const {
   return Map.lookup(S);
 }
 
+char SequencedCFG::ID;
+
+const SequencedCFG *getSequencedCFG(Stmt *Body, ASTContext *Context,
+                                    AnalysisCache &Cache) {
+  const SequencedCFG &Result = Cache.get<SequencedCFG>(Body, [&] {
+    auto Result = llvm::make_unique<SequencedCFG>();
+    // Generate the CFG manually instead of through an AnalysisDeclContext
+    // because it seems the latter can't be used to generate a CFG for the body
+    // of a lambda.
+    CFG::BuildOptions Options;
+    Options.AddImplicitDtors = true;
+    Options.AddTemporaryDtors = true;
+    Result->TheCFG = CFG::buildCFG(nullptr, Body, Context, Options);
+    if (Result->TheCFG) {
+      Result->Sequence.reset(new ExprSequence(Result->TheCFG.get(), Context));
+      Result->BlockMap.reset(
+          new StmtToBlockMap(Result->TheCFG.get(), Context));
+    }
+    return Result;
+  });
+  return Result.TheCFG ? &Result : nullptr;
+}
+
 } // namespace utils
 } // namespace tidy
 } // namespace clang
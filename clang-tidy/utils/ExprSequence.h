@@ -117,6 +117,26 @@ private:
   llvm::DenseMap<const Stmt *, const CFGBlock *> Map;
 };
 
+/// The CFG of a function body together with its `ExprSequence` and
+/// `StmtToBlockMap`. Checks share them through the `AnalysisCache`, so that
+/// they are built once per function rather than once per match.
+struct SequencedCFG : AnalysisCache::Result {
+  static char ID;
+
+  std::unique_ptr<CFG> TheCFG;
+  std::unique_ptr<ExprSequence> Sequence;
+  std::unique_ptr<StmtToBlockMap> BlockMap;
+};
+
+/// Returns the `SequencedCFG` of \p Body, which is built if \p Cache doesn't
+/// contain it yet. Returns null if the CFG can't be built.
+///
+/// The CFG includes implicit and temporary destructors, so that destructors
+/// marked [[noreturn]] are handled correctly in the control flow analysis.
+/// (These are used in some styles of assertion macros.)
+const SequencedCFG *getSequencedCFG(Stmt *Body, ASTContext *Context,
+                                    AnalysisCache &Cache);
+
 } // namespace utils
 } // namespace tidy
 } // namespace clang
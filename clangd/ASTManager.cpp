@@ -10,29 +10,65 @@
 #include "ASTManager.h"
 #include "JSONRPCDispatcher.h"
 #include "Protocol.h"
+#include "clang/AST/ASTContext.h"
 #include "clang/Frontend/ASTUnit.h"
 #include "clang/Frontend/CompilerInstance.h"
+#include "clang/Lex/HeaderSearch.h"
+#include "clang/Lex/Preprocessor.h"
+#include "clang/Lex/PreprocessingRecord.h"
 #include "clang/Tooling/CompilationDatabase.h"
 #include "llvm/Support/Format.h"
 #include "llvm/Support/Path.h"
+#include <algorithm>
+#include <future>
 #include <mutex>
 #include <thread>
 using namespace clang;
 using namespace clangd;
 
+/// Code completion requests that were not started within this time are
+/// cancelled, the user has most likely typed past the completion point.
+static const std::chrono::milliseconds CodeCompleteTimeout(3000);
+/// Fix-it lookups that were not started within this time are cancelled.
+static const std::chrono::milliseconds FixItsTimeout(5000);
+
+DiagnosticKey DiagnosticKey::get(const Range &R, int Severity,
+                                 StringRef Message) {
+  return {R, Severity, llvm::hash_value(Message)};
+}
+
 void DocData::setAST(std::unique_ptr<ASTUnit> AST) {
   this->AST = std::move(AST);
 }
 
 ASTUnit *DocData::getAST() const { return AST.get(); }
 
+void DocData::clearAST() {
+  AST.reset();
+  PreamblePCH.clear();
+  Snapshot = DocumentSnapshot();
+}
+
+void DocData::setPreamblePCH(std::string Path) {
+  PreamblePCH = std::move(Path);
+}
+
+StringRef DocData::getPreamblePCH() const { return PreamblePCH; }
+
+void DocData::setSnapshot(DocumentSnapshot Snapshot) {
+  this->Snapshot = std::move(Snapshot);
+}
+
 void DocData::cacheFixIts(DiagnosticToReplacementMap FixIts) {
   this->FixIts = std::move(FixIts);
 }
 
 std::vector<clang::tooling::Replacement>
 DocData::getFixIts(const clangd::Diagnostic &D) const {
-  auto it = FixIts.find(D);
+  // Negative lines are reserved for the empty and tombstone keys.
+  if (D.range.start.line < 0)
+    return {};
+  auto it = FixIts.find(DiagnosticKey::get(D.range, D.severity, D.message));
   if (it != FixIts.end())
     return it->second;
   return {};
@@ -43,17 +79,29 @@ ASTManagerRequest::ASTManagerRequest(ASTManagerRequestType Type,
                                      DocVersion Version)
     : Type(Type), File(File), Version(Version) {}
 
-/// Retrieve a copy of the contents of every file in the store, for feeding into
-/// ASTUnit.
+ASTManagerRequest::ASTManagerRequest(
+    std::string File, ASTManagerRequestPriority Priority, TimePoint Deadline,
+    std::function<void(bool Cancelled)> Action)
+    : Type(ASTManagerRequestType::RunAction), File(std::move(File)),
+      Priority(Priority), Deadline(Deadline), Action(std::move(Action)) {}
+
+bool ASTManagerRequest::isMoreUrgentThan(
+    const ASTManagerRequest &Other) const {
+  return std::tie(Priority, Deadline, Seq) <
+         std::tie(Other.Priority, Other.Deadline, Other.Seq);
+}
+
+/// Remap every file in the snapshot for feeding into ASTUnit. The buffers
+/// reference the contents owned by the snapshot without copying them, so the
+/// snapshot must outlive any use of the buffers.
 static std::vector<ASTUnit::RemappedFile>
-getRemappedFiles(const DocumentStore &Docs) {
-  // FIXME: Use VFS instead. This would allow us to get rid of the chdir below.
+getRemappedFiles(const DocumentSnapshot &Docs) {
   std::vector<ASTUnit::RemappedFile> RemappedFiles;
-  for (const auto &P : Docs.getAllDocuments()) {
+  for (const auto &P : Docs) {
     StringRef FileName = P.first;
     RemappedFiles.push_back(ASTUnit::RemappedFile(
-        FileName,
-        llvm::MemoryBuffer::getMemBufferCopy(P.second, FileName).release()));
+        FileName, llvm::MemoryBuffer::getMemBuffer(P.second->Text, FileName)
+                      .release()));
   }
   return RemappedFiles;
 }
@@ -119,39 +167,166 @@ static CompletionItemKind getKind(CXCursorKind K) {
   }
 }
 
+static std::string getResourceDir() {
+  static int Dummy; // Just an address in this process.
+  return CompilerInvocation::GetResourcesPath("clangd", (void *)&Dummy);
+}
+
 ASTManager::ASTManager(JSONOutput &Output, DocumentStore &Store,
-                       bool RunSynchronously)
+                       bool RunSynchronously, unsigned AsyncThreadsCount,
+                       std::chrono::milliseconds MinDebounce,
+                       size_t MemoryBudget, StringRef PreambleCacheDir)
     : Output(Output), Store(Store), RunSynchronously(RunSynchronously),
-      PCHs(std::make_shared<PCHContainerOperations>()),
-      ClangWorker([this]() { runWorker(); }) {}
+      MinDebounce(MinDebounce), MemoryBudget(MemoryBudget),
+      PCHs(std::make_shared<PCHContainerOperations>()) {
+  if (!PreambleCacheDir.empty())
+    Preambles =
+        llvm::make_unique<preamble::PreambleStore>(PreambleCacheDir, PCHs);
+  if (RunSynchronously)
+    return;
+  assert(AsyncThreadsCount != 0 && "Need at least one worker thread");
+  Workers.reserve(AsyncThreadsCount);
+  for (unsigned I = 0; I < AsyncThreadsCount; ++I)
+    Workers.emplace_back([this]() { runWorker(); });
+}
 
 void ASTManager::runWorker() {
   while (true) {
     ASTManagerRequest Request;
+    bool IsOutdated;
 
     // Pick request from the queue
     {
       std::unique_lock<std::mutex> Lock(RequestLock);
-      // Wait for more requests.
-      ClangRequestCV.wait(Lock,
-                          [this] { return !RequestQueue.empty() || Done; });
-      if (Done)
-        return;
-      assert(!RequestQueue.empty() && "RequestQueue was empty");
+      std::vector<std::string>::iterator MostUrgent;
+      while (true) {
+        // Documents that are being processed by other workers are not in
+        // ReadyDocs, those workers pick up their remaining requests.
+        if (Done && ReadyDocs.empty())
+          return;
+
+        // Pick the document with the most urgent request that is not being
+        // debounced. No more changes arrive once we're done, so requests are
+        // not debounced then. There is at most one entry per open document, so
+        // a linear scan is fine.
+        auto Now = std::chrono::steady_clock::now();
+        auto NextWakeUp = ASTManagerRequest::TimePoint::max();
+        const ASTManagerRequest *MostUrgentRequest = nullptr;
+        MostUrgent = ReadyDocs.end();
+        for (auto It = ReadyDocs.begin(), End = ReadyDocs.end(); It != End;
+             ++It) {
+          const auto &Front = DocQueues.find(*It)->second.Requests.front();
+          if (!Done && Front.NotBefore > Now) {
+            NextWakeUp = std::min(NextWakeUp, Front.NotBefore);
+            continue;
+          }
+          if (!MostUrgentRequest ||
+              Front.isMoreUrgentThan(*MostUrgentRequest)) {
+            MostUrgentRequest = &Front;
+            MostUrgent = It;
+          }
+        }
+        if (MostUrgent != ReadyDocs.end())
+          break;
+
+        // Wait for more requests, or until a debounced request is due.
+        if (NextWakeUp == ASTManagerRequest::TimePoint::max())
+          ClangRequestCV.wait(Lock);
+        else
+          ClangRequestCV.wait_until(Lock, NextWakeUp);
+      }
 
-      Request = std::move(RequestQueue.back());
-      RequestQueue.pop_back();
+      std::string File = std::move(*MostUrgent);
+      ReadyDocs.erase(MostUrgent);
+
+      // The document stays scheduled while we process its request, so no other
+      // worker can pick it up until we're done.
+      auto &Queue = DocQueues[File];
+      assert(Queue.Scheduled && "Document in ReadyDocs is not scheduled");
+      assert(!Queue.Requests.empty() && "Scheduled document has no requests");
+      Request = std::move(Queue.Requests.front());
+      Queue.Requests.pop_front();
+
+      if (Request.Type == ASTManagerRequestType::RunAction)
+        IsOutdated = std::chrono::steady_clock::now() > Request.Deadline;
+      else
+        IsOutdated = Request.Version != DocVersions.find(Request.File)->second;
+    } // unlock RequestLock
 
+    if (Request.Type == ASTManagerRequestType::RunAction) {
+      if (IsOutdated)
+        Output.log("Request for " + Twine(Request.File) +
+                   " missed its deadline, cancelling request\n");
+      Request.Action(/*Cancelled=*/IsOutdated);
+    } else if (IsOutdated) {
       // Skip outdated requests
-      if (Request.Version != DocVersions.find(Request.File)->second) {
-        Output.log("Version for " + Twine(Request.File) +
-                   " in request is outdated, skipping request\n");
-        continue;
+      Output.log("Version for " + Twine(Request.File) +
+                 " in request is outdated, skipping request\n");
+    } else {
+      auto StartTime = std::chrono::steady_clock::now();
+      handleRequest(Request.Type, Request.File);
+      if (Request.Type == ASTManagerRequestType::ParseAndPublishDiagnostics) {
+        auto ParseTime = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - StartTime);
+        std::lock_guard<std::mutex> Lock(RequestLock);
+        auto &Queue = DocQueues[Request.File];
+        // Favor recent measurements, parse time changes with the contents of
+        // the document and its preamble.
+        if (Queue.ParseCount == 0)
+          Queue.AverageParseTime = ParseTime;
+        else
+          Queue.AverageParseTime = (Queue.AverageParseTime * 3 + ParseTime) / 4;
+        ++Queue.ParseCount;
       }
-    } // unlock RequestLock
+    }
+
+    // Let other workers pick up the remaining requests for this document.
+    std::lock_guard<std::mutex> Lock(RequestLock);
+    auto QueueIt = DocQueues.find(Request.File);
+    auto &Queue = QueueIt->second;
+    Queue.Scheduled = false;
+    if (!Queue.Requests.empty()) {
+      scheduleDocLocked(Request.File);
+    } else if (Request.Type == ASTManagerRequestType::RemoveDocData &&
+               !IsOutdated) {
+      // The document was closed and not reopened, forget about it. Reopening
+      // it starts over with a fresh version.
+      DocVersions.erase(Request.File);
+      DocQueues.erase(QueueIt);
+    }
+  }
+}
 
-    handleRequest(Request.Type, Request.File);
+void ASTManager::scheduleDocLocked(StringRef File) {
+  auto &Queue = DocQueues[File];
+  if (!Queue.Scheduled) {
+    Queue.Scheduled = true;
+    ReadyDocs.push_back(File.str());
   }
+  // Wake up a worker even if the document was already scheduled, its most
+  // urgent request might have changed.
+  ClangRequestCV.notify_one();
+}
+
+std::chrono::milliseconds
+ASTManager::getDebounceLocked(const DocRequestQueue &Queue) {
+  if (Queue.ParseCount == 0)
+    return std::chrono::milliseconds(0);
+  return std::min(std::max(Queue.AverageParseTime / 2, MinDebounce),
+                  MinDebounce * 10);
+}
+
+void ASTManager::queueRequestLocked(ASTManagerRequest Request) {
+  Request.Seq = NextRequestSeq++;
+  auto &Requests = DocQueues[Request.File].Requests;
+  auto InsertPos = std::upper_bound(
+      Requests.begin(), Requests.end(), Request,
+      [](const ASTManagerRequest &LHS, const ASTManagerRequest &RHS) {
+        return LHS.isMoreUrgentThan(RHS);
+      });
+  std::string File = Request.File;
+  Requests.insert(InsertPos, std::move(Request));
+  scheduleDocLocked(File);
 }
 
 void ASTManager::queueOrRun(ASTManagerRequestType RequestType, StringRef File) {
@@ -164,8 +339,46 @@ void ASTManager::queueOrRun(ASTManagerRequestType RequestType, StringRef File) {
   // We increment the version of the added document immediately and schedule
   // the requested operation to be run on a worker thread
   DocVersion version = ++DocVersions[File];
-  RequestQueue.push_back(ASTManagerRequest(RequestType, File, version));
-  ClangRequestCV.notify_one();
+
+  // Pending requests for older versions of the document are superseded by this
+  // one, cancel them. This also merges bursts of changes into a single reparse,
+  // as the reparse is debounced. RunAction requests are not tied to a version
+  // and are kept.
+  auto &Requests = DocQueues[File].Requests;
+  Requests.erase(std::remove_if(Requests.begin(), Requests.end(),
+                                [](const ASTManagerRequest &R) {
+                                  return R.Type !=
+                                         ASTManagerRequestType::RunAction;
+                                }),
+                 Requests.end());
+
+  ASTManagerRequest Request(RequestType, File, version);
+  if (RequestType == ASTManagerRequestType::ParseAndPublishDiagnostics)
+    Request.NotBefore =
+        std::chrono::steady_clock::now() + getDebounceLocked(DocQueues[File]);
+  queueRequestLocked(std::move(Request));
+}
+
+void ASTManager::runAndWait(StringRef File, ASTManagerRequestPriority Priority,
+                            std::chrono::milliseconds Timeout,
+                            std::function<void(bool Cancelled)> Action) {
+  if (RunSynchronously) {
+    Action(/*Cancelled=*/false);
+    return;
+  }
+
+  std::promise<void> Finished;
+  std::future<void> FinishedFuture = Finished.get_future();
+  {
+    std::lock_guard<std::mutex> Guard(RequestLock);
+    queueRequestLocked(ASTManagerRequest(
+        File, Priority, std::chrono::steady_clock::now() + Timeout,
+        [&Action, &Finished](bool Cancelled) {
+          Action(Cancelled);
+          Finished.set_value();
+        }));
+  } // unlock RequestLock
+  FinishedFuture.wait();
 }
 
 void ASTManager::handleRequest(ASTManagerRequestType RequestType,
@@ -175,44 +388,157 @@ void ASTManager::handleRequest(ASTManagerRequestType RequestType,
     parseFileAndPublishDiagnostics(File);
     break;
   case ASTManagerRequestType::RemoveDocData: {
-    std::lock_guard<std::mutex> Lock(ClangObjectLock);
-    auto DocDataIt = DocDatas.find(File);
+    std::lock_guard<std::mutex> Lock(DocDatasLock);
     // We could get the remove request before parsing for the document is
     // started, just do nothing in that case, parsing request will be discarded
-    // because it has a lower version value
-    if (DocDataIt == DocDatas.end())
-      return;
-    DocDatas.erase(DocDataIt);
+    // because it has a lower version value. If the DocData is still being used
+    // by a code completion, it is destroyed once that finishes.
+    auto It = DocDatas.find(File);
+    if (It != DocDatas.end()) {
+      TotalMemoryUsage -= It->second->MemoryUsage;
+      It->second->MemoryUsage = 0;
+      DocDatas.erase(It);
+    }
     break;
-  } // unlock ClangObjectLock
+  } // unlock DocDatasLock
   }
 }
 
-void ASTManager::parseFileAndPublishDiagnostics(StringRef File) {
-  std::unique_lock<std::mutex> ClangObjectLockGuard(ClangObjectLock);
+std::shared_ptr<DocData> ASTManager::getOrCreateDocData(StringRef File) {
+  std::lock_guard<std::mutex> Lock(DocDatasLock);
+  auto &Data = DocDatas[File];
+  if (!Data)
+    Data = std::make_shared<DocData>();
+  Data->LastUse = ++UseCounter;
+  return Data;
+}
 
-  auto &DocData = DocDatas[File];
-  ASTUnit *Unit = DocData.getAST();
-  if (!Unit) {
-    auto newAST = createASTUnitForFile(File, this->Store);
-    Unit = newAST.get();
+/// Estimates the memory used by \p Unit, the same way libclang's
+/// clang_getCXTUResourceUsage does. The precompiled preamble is not included,
+/// it's stored in a temporary file.
+static size_t estimateMemoryUsage(ASTUnit &Unit) {
+  ASTContext &Ctx = Unit.getASTContext();
+  size_t Total = Ctx.getASTAllocatedMemory() +
+                 Ctx.getSideTableAllocatedMemory() +
+                 Ctx.Idents.getAllocator().getTotalMemory() +
+                 Ctx.Selectors.getTotalMemory();
+
+  const SourceManager &SM = Unit.getSourceManager();
+  SourceManager::MemoryBufferSizes Buffers = SM.getMemoryBufferSizes();
+  Total += SM.getContentCacheSize() + SM.getDataStructureSizes() +
+           Buffers.malloc_bytes + Buffers.mmap_bytes;
+
+  Preprocessor &PP = Unit.getPreprocessor();
+  Total += PP.getTotalMemory() + PP.getHeaderSearchInfo().getTotalMemory();
+  if (PreprocessingRecord *PPRec = PP.getPreprocessingRecord())
+    Total += PPRec->getTotalMemory();
+
+  if (auto Allocator = Unit.getCachedCompletionAllocator())
+    Total += Allocator->getTotalMemory();
+  return Total;
+}
+
+void ASTManager::updateMemoryUsage(DocData &Data) {
+  ASTUnit *Unit = Data.getAST();
+  size_t Usage = Unit ? estimateMemoryUsage(*Unit) : 0;
+
+  // The ASTs are freed after releasing DocDatasLock, that can take a while.
+  std::vector<std::pair<std::shared_ptr<DocData>, std::unique_lock<std::mutex>>>
+      Evicted;
+  {
+    std::lock_guard<std::mutex> Lock(DocDatasLock);
+    TotalMemoryUsage = TotalMemoryUsage - Data.MemoryUsage + Usage;
+    Data.MemoryUsage = Usage;
+    if (MemoryBudget == 0 || TotalMemoryUsage <= MemoryBudget)
+      return;
+
+    std::vector<std::shared_ptr<DocData>> Candidates;
+    for (const auto &Entry : DocDatas)
+      if (Entry.second.get() != &Data && Entry.second->MemoryUsage != 0)
+        Candidates.push_back(Entry.second);
+    std::sort(Candidates.begin(), Candidates.end(),
+              [](const std::shared_ptr<DocData> &LHS,
+                 const std::shared_ptr<DocData> &RHS) {
+                return LHS->LastUse < RHS->LastUse;
+              });
+
+    for (auto &Candidate : Candidates) {
+      if (TotalMemoryUsage <= MemoryBudget)
+        break;
+      // Don't wait for ASTs that are in use, they are not good candidates
+      // anyway. This also avoids deadlocks, as we hold Data's lock.
+      std::unique_lock<std::mutex> CandidateLock(Candidate->Lock,
+                                                 std::try_to_lock);
+      if (!CandidateLock)
+        continue;
+      TotalMemoryUsage -= Candidate->MemoryUsage;
+      Candidate->MemoryUsage = 0;
+      Evicted.emplace_back(std::move(Candidate), std::move(CandidateLock));
+    }
+  } // unlock DocDatasLock
+
+  for (auto &Entry : Evicted)
+    Entry.first->clearAST();
+  if (!Evicted.empty())
+    Output.log("Freed " + Twine(Evicted.size()) +
+               " ASTs to stay within the memory budget\n");
+}
 
-    DocData.setAST(std::move(newAST));
+ASTMemoryUsage ASTManager::getMemoryUsage() {
+  std::lock_guard<std::mutex> Lock(DocDatasLock);
+  ASTMemoryUsage Result;
+  Result.Budget = MemoryBudget;
+  Result.Total = TotalMemoryUsage;
+  for (const auto &Entry : DocDatas)
+    if (Entry.second->MemoryUsage != 0)
+      Result.Files.emplace_back(Entry.first(), Entry.second->MemoryUsage);
+  std::sort(Result.Files.begin(), Result.Files.end());
+  return Result;
+}
+
+void ASTManager::parseFileAndPublishDiagnostics(StringRef File) {
+  std::shared_ptr<DocData> Data = getOrCreateDocData(File);
+  std::unique_lock<std::mutex> DocDataLockGuard(Data->Lock);
+
+  DocumentSnapshot Snapshot = Store.getSnapshot();
+  ASTUnit *Unit = Data->getAST();
+  if (Unit && isStoredPreambleOutdated(File, *Data, Snapshot)) {
+    Data->clearAST();
+    Unit = nullptr;
+  }
+  if (!Unit) {
+    Unit = createASTUnitForFile(File, Snapshot, *Data);
   } else {
     // Do a reparse if this wasn't the first parse.
-    // FIXME: This might have the wrong working directory if it changed in the
-    // meantime.
-    Unit->Reparse(PCHs, getRemappedFiles(this->Store));
+    Unit->Reparse(PCHs, getRemappedFiles(Snapshot));
   }
+  // The AST now references the contents of the new snapshot, the old one can be
+  // released.
+  Data->setSnapshot(std::move(Snapshot));
 
   if (!Unit)
     return;
+  updateMemoryUsage(*Data);
 
   // Send the diagnotics to the editor.
   // FIXME: If the diagnostic comes from a different file, do we want to
   // show them all? Right now we drop everything not coming from the
   // main file.
-  std::string Diagnostics;
+  Data->DiagnosticsJSON.clear();
+  llvm::raw_svector_ostream OS(Data->DiagnosticsJSON);
+  json::Writer W(OS);
+  W.objectBegin();
+  W.key("jsonrpc");
+  W.value("2.0");
+  W.key("method");
+  W.value("textDocument/publishDiagnostics");
+  W.key("params");
+  W.objectBegin();
+  W.key("uri");
+  W.value(URI::fromFile(File).uri);
+  W.key("diagnostics");
+  W.arrayBegin();
+
   DocData::DiagnosticToReplacementMap LocalFixIts; // Temporary storage
   for (ASTUnit::stored_diag_iterator D = Unit->stored_diag_begin(),
                                      DEnd = Unit->stored_diag_end();
@@ -224,43 +550,48 @@ void ASTManager::parseFileAndPublishDiagnostics(StringRef File) {
     P.line = D->getLocation().getSpellingLineNumber() - 1;
     P.character = D->getLocation().getSpellingColumnNumber();
     Range R = {P, P};
-    Diagnostics +=
-        R"({"range":)" + Range::unparse(R) +
-        R"(,"severity":)" + std::to_string(getSeverity(D->getLevel())) +
-        R"(,"message":")" + llvm::yaml::escape(D->getMessage()) +
-        R"("},)";
-
+    int Severity = getSeverity(D->getLevel());
+    W.objectBegin();
+    W.key("range");
+    Range::unparse(W, R);
+    W.key("severity");
+    W.value(Severity);
+    W.key("message");
+    W.value(D->getMessage());
+    W.objectEnd();
+
+    if (D->getFixIts().empty())
+      continue;
     // We convert to Replacements to become independent of the SourceManager.
-    clangd::Diagnostic Diag = {R, getSeverity(D->getLevel()), D->getMessage()};
-    auto &FixItsForDiagnostic = LocalFixIts[Diag];
+    auto &FixItsForDiagnostic =
+        LocalFixIts[DiagnosticKey::get(R, Severity, D->getMessage())];
     for (const FixItHint &Fix : D->getFixIts()) {
       FixItsForDiagnostic.push_back(clang::tooling::Replacement(
           Unit->getSourceManager(), Fix.RemoveRange, Fix.CodeToInsert));
     }
   }
+  W.arrayEnd();
+  W.objectEnd();
+  W.objectEnd();
 
   // Put FixIts into place.
-  DocData.cacheFixIts(std::move(LocalFixIts));
-
-  ClangObjectLockGuard.unlock();
-  // No accesses to clang objects are allowed after this point.
+  Data->cacheFixIts(std::move(LocalFixIts));
 
-  // Publish diagnostics.
-  if (!Diagnostics.empty())
-    Diagnostics.pop_back(); // Drop trailing comma.
-  Output.writeMessage(
-      R"({"jsonrpc":"2.0","method":"textDocument/publishDiagnostics","params":{"uri":")" +
-      URI::fromFile(File).uri + R"(","diagnostics":[)" + Diagnostics + R"(]}})");
+  // Publish diagnostics. This only copies the message into the output queue,
+  // so it's cheap enough to do while holding the lock that guards the buffer.
+  Output.writeMessage(Data->DiagnosticsJSON.str());
 }
 
 ASTManager::~ASTManager() {
   {
     std::lock_guard<std::mutex> Guard(RequestLock);
-    // Wake up the clang worker thread, then exit.
+    // Wake up the clang worker threads, they exit after finishing the queued
+    // requests.
     Done = true;
-    ClangRequestCV.notify_one();
-  } // unlock DocDataLock
-  ClangWorker.join();
+    ClangRequestCV.notify_all();
+  } // unlock RequestLock
+  for (auto &Worker : Workers)
+    Worker.join();
 }
 
 void ASTManager::onDocumentAdd(StringRef File) {
@@ -273,6 +604,7 @@ void ASTManager::onDocumentRemove(StringRef File) {
 
 tooling::CompilationDatabase *
 ASTManager::getOrCreateCompilationDatabaseForFile(StringRef File) {
+  // Must be called with CompilationDatabasesLock held.
   namespace path = llvm::sys::path;
 
   assert((path::is_absolute(File, path::Style::posix) ||
@@ -305,19 +637,16 @@ ASTManager::getOrCreateCompilationDatabaseForFile(StringRef File) {
   return nullptr;
 }
 
-std::unique_ptr<clang::ASTUnit>
-ASTManager::createASTUnitForFile(StringRef File, const DocumentStore &Docs) {
-  tooling::CompilationDatabase *CDB =
-      getOrCreateCompilationDatabaseForFile(File);
-
+std::vector<std::string> ASTManager::getCommandLineForFile(StringRef File) {
   std::vector<tooling::CompileCommand> Commands;
+  {
+    std::lock_guard<std::mutex> Guard(CompilationDatabasesLock);
+    tooling::CompilationDatabase *CDB =
+        getOrCreateCompilationDatabaseForFile(File);
+    if (CDB)
+      Commands = CDB->getCompileCommands(File);
+  } // unlock CompilationDatabasesLock
 
-  if (CDB) {
-    Commands = CDB->getCompileCommands(File);
-    // chdir. This is thread hostile.
-    if (!Commands.empty())
-      llvm::sys::fs::set_current_path(Commands.front().Directory);
-  }
   if (Commands.empty()) {
     // Add a fake command line if we know nothing.
     Commands.push_back(tooling::CompileCommand(
@@ -325,38 +654,118 @@ ASTManager::createASTUnitForFile(StringRef File, const DocumentStore &Docs) {
         {"clang", "-fsyntax-only", File.str()}, ""));
   }
 
+  // Pass the working directory to the compiler instead of changing the working
+  // directory of the process, which would affect all other worker threads. It
+  // is stored in the FileSystemOptions of the ASTUnit, so reparses use it too.
+  // Insert it right after the driver name, so that the command from the
+  // compilation database can still override it. Commands without a directory
+  // are run in the directory of the process.
+  std::vector<std::string> CommandLine =
+      std::move(Commands.front().CommandLine);
+  if (!Commands.front().Directory.empty())
+    CommandLine.insert(CommandLine.begin() + 1,
+                       "-working-directory=" + Commands.front().Directory);
+
   // Inject the resource dir.
   // FIXME: Don't overwrite it if it's already there.
-  static int Dummy; // Just an address in this process.
-  std::string ResourceDir =
-      CompilerInvocation::GetResourcesPath("clangd", (void *)&Dummy);
-  Commands.front().CommandLine.push_back("-resource-dir=" + ResourceDir);
+  CommandLine.push_back("-resource-dir=" + getResourceDir());
+  return CommandLine;
+}
+
+/// Returns the contents of File in \p Docs, nullptr if it's not there.
+static const DocumentContents *findDocument(const DocumentSnapshot &Docs,
+                                            StringRef File) {
+  for (const auto &Doc : Docs)
+    if (Doc.first == File)
+      return Doc.second.get();
+  return nullptr;
+}
+
+llvm::Optional<preamble::StoredPreamble>
+ASTManager::getStoredPreamble(StringRef File, ArrayRef<std::string> CommandLine,
+                              const DocumentSnapshot &Docs) {
+  if (!Preambles)
+    return llvm::None;
+  if (const DocumentContents *Doc = findDocument(Docs, File))
+    return Preambles->getPreamble(CommandLine, File, Doc->Text);
+  return llvm::None;
+}
+
+bool ASTManager::isStoredPreambleOutdated(StringRef File, DocData &Data,
+                                          const DocumentSnapshot &Docs) {
+  if (Data.getPreamblePCH().empty())
+    return false;
+  const DocumentContents *Doc = findDocument(Docs, File);
+  if (!Doc)
+    return true;
+  // Checking the preamble runs the driver and stats every file it includes,
+  // don't do that again for every reparse and completion of the same version.
+  if (Doc->Version == Data.PreambleCheckedVersion)
+    return false;
+  auto Preamble = getStoredPreamble(File, getCommandLineForFile(File), Docs);
+  if (!Preamble || Preamble->PCHPath != Data.getPreamblePCH())
+    return true;
+  Data.PreambleCheckedVersion = Doc->Version;
+  return false;
+}
+
+ASTUnit *ASTManager::createASTUnitForFile(StringRef File,
+                                          const DocumentSnapshot &Docs,
+                                          DocData &Data) {
+  std::vector<std::string> CommandLine = getCommandLineForFile(File);
+
+  // Use a stored preamble if possible, ASTUnit builds its own otherwise.
+  unsigned PrecompilePreambleAfterNParses = 1;
+  std::string PreamblePCH;
+  if (auto Preamble = getStoredPreamble(File, CommandLine, Docs)) {
+    preamble::PreambleStore::addPreambleArguments(*Preamble, CommandLine);
+    PrecompilePreambleAfterNParses = 0;
+    PreamblePCH = std::move(Preamble->PCHPath);
+  }
 
   IntrusiveRefCntPtr<DiagnosticsEngine> Diags =
       CompilerInstance::createDiagnostics(new DiagnosticOptions);
 
   std::vector<const char *> ArgStrs;
-  for (const auto &S : Commands.front().CommandLine)
+  for (const auto &S : CommandLine)
     ArgStrs.push_back(S.c_str());
 
   auto ArgP = &*ArgStrs.begin();
-  return std::unique_ptr<clang::ASTUnit>(ASTUnit::LoadFromCommandLine(
-      ArgP, ArgP + ArgStrs.size(), PCHs, Diags, ResourceDir,
+  std::unique_ptr<ASTUnit> Unit(ASTUnit::LoadFromCommandLine(
+      ArgP, ArgP + ArgStrs.size(), PCHs, Diags, getResourceDir(),
       /*OnlyLocalDecls=*/false, /*CaptureDiagnostics=*/true,
       getRemappedFiles(Docs),
-      /*RemappedFilesKeepOriginalName=*/true,
-      /*PrecompilePreambleAfterNParses=*/1, /*TUKind=*/TU_Complete,
+      /*RemappedFilesKeepOriginalName=*/true, PrecompilePreambleAfterNParses,
+      /*TUKind=*/TU_Complete,
       /*CacheCodeCompletionResults=*/true,
       /*IncludeBriefCommentsInCodeCompletion=*/true,
       /*AllowPCHWithCompilerErrors=*/true));
+  ASTUnit *Result = Unit.get();
+  Data.setAST(std::move(Unit));
+  Data.setPreamblePCH(Result ? std::move(PreamblePCH) : std::string());
+  if (const DocumentContents *Doc = findDocument(Docs, File))
+    Data.PreambleCheckedVersion = Doc->Version;
+  return Result;
 }
 
 std::vector<clang::tooling::Replacement>
 ASTManager::getFixIts(StringRef File, const clangd::Diagnostic &D) {
+  std::vector<clang::tooling::Replacement> FixIts;
+  runAndWait(File, ASTManagerRequestPriority::FixIts, FixItsTimeout,
+             [&](bool Cancelled) {
+               if (!Cancelled)
+                 FixIts = getFixItsImpl(File, D);
+             });
+  return FixIts;
+}
+
+std::vector<clang::tooling::Replacement>
+ASTManager::getFixItsImpl(StringRef File, const clangd::Diagnostic &D) {
   // TODO(ibiryukov): the FixIts should be available immediately
   // even when parsing is being run on a worker thread
-  std::lock_guard<std::mutex> Guard(ClangObjectLock);
-  return DocDatas[File].getFixIts(D);
+  std::shared_ptr<DocData> Data = getOrCreateDocData(File);
+  std::lock_guard<std::mutex> Guard(Data->Lock);
+  return Data->getFixIts(D);
 }
 
 namespace {
@@ -402,6 +811,17 @@ public:
 
 std::vector<CompletionItem>
 ASTManager::codeComplete(StringRef File, unsigned Line, unsigned Column) {
+  std::vector<CompletionItem> Items;
+  runAndWait(File, ASTManagerRequestPriority::CodeComplete,
+             CodeCompleteTimeout, [&](bool Cancelled) {
+               if (!Cancelled)
+                 Items = codeCompleteImpl(File, Line, Column);
+             });
+  return Items;
+}
+
+std::vector<CompletionItem>
+ASTManager::codeCompleteImpl(StringRef File, unsigned Line, unsigned Column) {
   CodeCompleteOptions CCO;
   CCO.IncludeBriefComments = 1;
   // This is where code completion stores dirty buffers. Need to free after
@@ -413,13 +833,21 @@ ASTManager::codeComplete(StringRef File, unsigned Line, unsigned Column) {
   std::vector<CompletionItem> Items;
   CompletionItemsCollector Collector(&Items, CCO);
 
-  std::lock_guard<std::mutex> Guard(ClangObjectLock);
-  auto &DocData = DocDatas[File];
-  auto Unit = DocData.getAST();
+  std::shared_ptr<DocData> Data = getOrCreateDocData(File);
+  std::lock_guard<std::mutex> Guard(Data->Lock);
+  // The remapped buffers used for completion reference the snapshot, keep it
+  // alive until completion is done.
+  DocumentSnapshot Snapshot = Store.getSnapshot();
+  auto Unit = Data->getAST();
+  if (Unit && isStoredPreambleOutdated(File, *Data, Snapshot)) {
+    Data->clearAST();
+    Unit = nullptr;
+  }
   if (!Unit) {
-    auto newAST = createASTUnitForFile(File, this->Store);
-    Unit = newAST.get();
-    DocData.setAST(std::move(newAST));
+    Unit = createASTUnitForFile(File, Snapshot, *Data);
+    Data->setSnapshot(Snapshot);
+    if (Unit)
+      updateMemoryUsage(*Data);
   }
   if (!Unit)
     return {};
@@ -429,7 +857,7 @@ ASTManager::codeComplete(StringRef File, unsigned Line, unsigned Column) {
   LangOptions LangOpts = Unit->getLangOpts();
   // The language server protocol uses zero-based line and column numbers.
   // The clang code completion uses one-based numbers.
-  Unit->CodeComplete(File, Line + 1, Column + 1, getRemappedFiles(this->Store),
+  Unit->CodeComplete(File, Line + 1, Column + 1, getRemappedFiles(Snapshot),
                      CCO.IncludeMacros, CCO.IncludeCodePatterns,
                      CCO.IncludeBriefComments, Collector, PCHs, *DiagEngine,
                      LangOpts, *SourceMgr, Unit->getFileManager(),
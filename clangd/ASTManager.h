@@ -10,14 +10,22 @@
 #ifndef LLVM_CLANG_TOOLS_EXTRA_CLANGD_ASTMANAGER_H
 #define LLVM_CLANG_TOOLS_EXTRA_CLANGD_ASTMANAGER_H
 
+#include "../preamble-store/PreambleStore.h"
 #include "DocumentStore.h"
 #include "JSONRPCDispatcher.h"
 #include "Protocol.h"
 #include "clang/Tooling/Core/Replacement.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/IntrusiveRefCntPtr.h"
+#include "llvm/ADT/SmallString.h"
+#include <chrono>
 #include <condition_variable>
 #include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <thread>
+#include <vector>
 
 namespace clang {
 class ASTUnit;
@@ -32,42 +40,189 @@ namespace clangd {
 /// Using 'unsigned' here to avoid undefined behaviour on overflow.
 typedef unsigned DocVersion;
 
-/// Stores ASTUnit and FixIts map for an opened document
+/// Identifies a diagnostic in the FixIts index of a DocData. Only a hash of the
+/// message is stored, so that indexing the diagnostics of a parse doesn't copy
+/// all of their messages.
+struct DiagnosticKey {
+  Range R;
+  int Severity;
+  size_t MessageHash;
+
+  static DiagnosticKey get(const Range &R, int Severity, StringRef Message);
+};
+
+} // namespace clangd
+} // namespace clang
+
+namespace llvm {
+template <> struct DenseMapInfo<clang::clangd::DiagnosticKey> {
+  // Diagnostics never start on a negative line.
+  static clang::clangd::DiagnosticKey getEmptyKey() {
+    return {{{-1, 0}, {-1, 0}}, 0, 0};
+  }
+  static clang::clangd::DiagnosticKey getTombstoneKey() {
+    return {{{-2, 0}, {-2, 0}}, 0, 0};
+  }
+  static unsigned getHashValue(const clang::clangd::DiagnosticKey &Key) {
+    return hash_combine(Key.R.start.line, Key.R.start.character,
+                        Key.R.end.line, Key.R.end.character, Key.Severity,
+                        Key.MessageHash);
+  }
+  static bool isEqual(const clang::clangd::DiagnosticKey &LHS,
+                      const clang::clangd::DiagnosticKey &RHS) {
+    return std::tie(LHS.R, LHS.Severity, LHS.MessageHash) ==
+           std::tie(RHS.R, RHS.Severity, RHS.MessageHash);
+  }
+};
+} // namespace llvm
+
+namespace clang {
+namespace clangd {
+
+/// Stores ASTUnit and FixIts map for an opened document. Every DocData is
+/// guarded by its own Lock, so that different documents can be processed in
+/// parallel.
 class DocData {
 public:
-  typedef std::map<clangd::Diagnostic, std::vector<clang::tooling::Replacement>>
+  /// Only contains the diagnostics that have FixIts.
+  typedef llvm::DenseMap<DiagnosticKey,
+                         std::vector<clang::tooling::Replacement>>
       DiagnosticToReplacementMap;
 
 public:
   void setAST(std::unique_ptr<ASTUnit> AST);
   ASTUnit *getAST() const;
+  /// Frees the AST and the snapshot it references. The FixIts stay available.
+  void clearAST();
+
+  /// Sets the path of the stored preamble the AST was built with, empty if the
+  /// ASTUnit builds its own preamble.
+  void setPreamblePCH(std::string Path);
+  StringRef getPreamblePCH() const;
+
+  /// Sets the documents the AST was built from. The AST references their
+  /// contents without copying them, so they are kept alive together with it.
+  void setSnapshot(DocumentSnapshot Snapshot);
 
   void cacheFixIts(DiagnosticToReplacementMap FixIts);
   std::vector<clang::tooling::Replacement>
   getFixIts(const clangd::Diagnostic &D) const;
 
+  /// A lock for all accesses to this DocData.
+  std::mutex Lock;
+
+  /// Estimated memory used by the AST, in bytes. 0 if there is no AST.
+  /// Guarded by ASTManager::DocDatasLock.
+  size_t MemoryUsage = 0;
+  /// When the DocData was last accessed, used to find the least recently used
+  /// ASTs. Guarded by ASTManager::DocDatasLock.
+  uint64_t LastUse = 0;
+
+  /// The version of the document the stored preamble of the AST was last
+  /// found up to date for, so that it's only checked again after the document
+  /// changed. Meaningless if getPreamblePCH() is empty.
+  DocVersion PreambleCheckedVersion = 0;
+
+  /// Holds the serialized diagnostics of the last parse. Reused between parses
+  /// to avoid allocations.
+  SmallString<256> DiagnosticsJSON;
+
 private:
+  // Declared before AST, so that it is destroyed after the AST.
+  DocumentSnapshot Snapshot;
   std::unique_ptr<ASTUnit> AST;
+  std::string PreamblePCH;
   DiagnosticToReplacementMap FixIts;
 };
 
-enum class ASTManagerRequestType { ParseAndPublishDiagnostics, RemoveDocData };
+enum class ASTManagerRequestType {
+  ParseAndPublishDiagnostics,
+  RemoveDocData,
+  /// Runs ASTManagerRequest::Action. Used for requests that return a result to
+  /// the caller, e.g. code completion.
+  RunAction
+};
+
+/// Priority classes of requests, from the most urgent to the least urgent.
+/// Workers always pick up pending requests of a more urgent class first.
+enum class ASTManagerRequestPriority { CodeComplete, FixIts, Diagnostics };
 
 /// A request to the worker thread
 class ASTManagerRequest {
 public:
+  typedef std::chrono::steady_clock::time_point TimePoint;
+
   ASTManagerRequest() = default;
   ASTManagerRequest(ASTManagerRequestType Type, std::string File,
                     DocVersion Version);
+  ASTManagerRequest(std::string File, ASTManagerRequestPriority Priority,
+                    TimePoint Deadline,
+                    std::function<void(bool Cancelled)> Action);
+
+  /// Returns true if this request should be processed before \p Other.
+  bool isMoreUrgentThan(const ASTManagerRequest &Other) const;
 
   ASTManagerRequestType Type;
   std::string File;
-  DocVersion Version;
+  /// Used to discard outdated ParseAndPublishDiagnostics and RemoveDocData
+  /// requests. Not used for RunAction requests.
+  DocVersion Version = 0;
+  ASTManagerRequestPriority Priority = ASTManagerRequestPriority::Diagnostics;
+  /// Requests with equal priority are processed earliest deadline first.
+  /// RunAction requests that were not started before their deadline are
+  /// cancelled.
+  TimePoint Deadline = TimePoint::max();
+  /// Keeps requests with equal priority and deadline in FIFO order.
+  uint64_t Seq = 0;
+  /// The request is not started before this time. Used to debounce reparses.
+  TimePoint NotBefore = TimePoint::min();
+  /// Only used for RunAction requests. Called on the worker thread, with
+  /// \p Cancelled set to true if the request missed its deadline.
+  std::function<void(bool Cancelled)> Action;
+};
+
+/// Requests scheduled for a single document. Requests for one document are
+/// processed serially, the most urgent ones first.
+struct DocRequestQueue {
+  std::deque<ASTManagerRequest> Requests;
+  /// True if the document is waiting in ASTManager::ReadyDocs or one of its
+  /// requests is being processed by a worker thread. Used to ensure at most one
+  /// worker processes requests for a document at any time.
+  bool Scheduled = false;
+  /// Moving average of the time it took to parse this document.
+  std::chrono::milliseconds AverageParseTime{0};
+  /// Number of times this document was parsed.
+  unsigned ParseCount = 0;
+};
+
+/// Memory used by the ASTs of the open documents.
+struct ASTMemoryUsage {
+  /// The memory budget in bytes, 0 if there is none.
+  size_t Budget;
+  /// The estimated memory used by all ASTs, in bytes.
+  size_t Total;
+  /// The estimated memory used by the AST of each document that has one.
+  std::vector<std::pair<std::string, size_t>> Files;
 };
 
 class ASTManager : public DocumentStoreListener {
 public:
-  ASTManager(JSONOutput &Output, DocumentStore &Store, bool RunSynchronously);
+  /// If \p RunSynchronously is false, requests are processed on
+  /// \p AsyncThreadsCount worker threads. Requests for different documents may
+  /// run in parallel. Reparses caused by document changes are delayed by at
+  /// least \p MinDebounce, see getDebounceLocked.
+  /// If \p MemoryBudget is not 0, the least recently used ASTs are freed when
+  /// the estimated memory used by all ASTs exceeds \p MemoryBudget bytes. They
+  /// are rebuilt when they are needed again.
+  /// If \p PreambleCacheDir is not empty, preambles are stored in that
+  /// directory and shared between files and clangd sessions, see
+  /// PreambleStore.
+  ASTManager(JSONOutput &Output, DocumentStore &Store, bool RunSynchronously,
+             unsigned AsyncThreadsCount, std::chrono::milliseconds MinDebounce,
+             size_t MemoryBudget, StringRef PreambleCacheDir);
+  /// Finishes the queued requests without waiting for their debounce windows,
+  /// so that the diagnostics of the latest version of every document are
+  /// published, then stops the worker threads.
   ~ASTManager() override;
 
   void onDocumentAdd(StringRef File) override;
@@ -76,7 +231,9 @@ public:
   /// Get code completions at a specified \p Line and \p Column in \p File.
   ///
   /// This function is thread-safe and returns completion items that own the
-  /// data they contain.
+  /// data they contain. The completion is scheduled before any pending
+  /// diagnostics requests. Returns no items if it could not be started before
+  /// its deadline.
   std::vector<CompletionItem> codeComplete(StringRef File, unsigned Line,
                                            unsigned Column);
 
@@ -84,10 +241,15 @@ public:
   /// replacements.
   ///
   /// This function is thread-safe. It returns a copy to avoid handing out
-  /// references to unguarded data.
+  /// references to unguarded data. The lookup is scheduled before any pending
+  /// diagnostics requests.
   std::vector<clang::tooling::Replacement>
   getFixIts(StringRef File, const clangd::Diagnostic &D);
 
+  /// Returns the estimated memory used by the ASTs. This function is
+  /// thread-safe.
+  ASTMemoryUsage getMemoryUsage();
+
   DocumentStore &getStore() const { return Store; }
 
 private:
@@ -98,62 +260,138 @@ private:
   // asynchronously.
   bool RunSynchronously;
 
+  /// The smallest delay between a document change and its reparse.
+  std::chrono::milliseconds MinDebounce;
+
   /// Loads a compilation database for File. May return nullptr if it fails. The
   /// database is cached for subsequent accesses.
+  /// Must be called with CompilationDatabasesLock held.
   clang::tooling::CompilationDatabase *
   getOrCreateCompilationDatabaseForFile(StringRef File);
-  // Creates a new ASTUnit for the document at File.
-  // FIXME: This calls chdir internally, which is thread unsafe.
-  std::unique_ptr<clang::ASTUnit>
-  createASTUnitForFile(StringRef File, const DocumentStore &Docs);
+  /// Returns the command line to compile File with, from its compilation
+  /// database or a default one.
+  std::vector<std::string> getCommandLineForFile(StringRef File);
+  /// Returns the stored preamble for the contents of File in \p Docs, or None
+  /// if preambles are not stored or File has none.
+  llvm::Optional<preamble::StoredPreamble>
+  getStoredPreamble(StringRef File, ArrayRef<std::string> CommandLine,
+                    const DocumentSnapshot &Docs);
+  /// Returns true if the AST of \p Data was built with a stored preamble that
+  /// no longer matches the contents of File or the files it includes. Such an
+  /// AST can't be reparsed, it must be created again. The preamble is only
+  /// checked if File changed since it was last found up to date.
+  bool isStoredPreambleOutdated(StringRef File, DocData &Data,
+                                const DocumentSnapshot &Docs);
+  // Creates a new ASTUnit for the document at File and stores it in \p Data.
+  // The ASTUnit references the contents of \p Docs, which must be kept alive
+  // with it.
+  ASTUnit *createASTUnitForFile(StringRef File, const DocumentSnapshot &Docs,
+                                DocData &Data);
+
+  /// Returns the DocData for File, creating an empty one if there is none, and
+  /// marks it as most recently used. The returned DocData stays valid after it
+  /// is removed from DocDatas, so it is safe to use it after RemoveDocData has
+  /// been processed.
+  std::shared_ptr<DocData> getOrCreateDocData(StringRef File);
+  /// Records the memory used by the AST of \p Data and frees the least recently
+  /// used other ASTs until the total fits into MemoryBudget. ASTs that are in
+  /// use by another thread are skipped. Must be called with \p Data's lock
+  /// held.
+  void updateMemoryUsage(DocData &Data);
 
   /// If RunSynchronously is false, queues the request to be run on the worker
   /// thread.
   /// If RunSynchronously is true, runs the request handler immediately on the
   /// main thread.
   void queueOrRun(ASTManagerRequestType RequestType, StringRef File);
+  /// Runs \p Action on a worker thread with the specified \p Priority and
+  /// waits for it to finish. \p Action is called with Cancelled set to true if
+  /// it could not be started within \p Timeout.
+  /// If RunSynchronously is true, runs \p Action immediately on the calling
+  /// thread.
+  void runAndWait(StringRef File, ASTManagerRequestPriority Priority,
+                  std::chrono::milliseconds Timeout,
+                  std::function<void(bool Cancelled)> Action);
+  /// Adds \p Request to the queue of its document, keeping the queue sorted by
+  /// urgency. Must be called with RequestLock held.
+  void queueRequestLocked(ASTManagerRequest Request);
 
   void runWorker();
+  /// Returns the time to wait after a change of the document before reparsing
+  /// it, so that bursts of changes result in a single reparse. The delay grows
+  /// with the measured parse time of the document, from MinDebounce up to
+  /// 10 * MinDebounce. Documents that were not parsed yet are parsed
+  /// immediately. Must be called with RequestLock held.
+  std::chrono::milliseconds getDebounceLocked(const DocRequestQueue &Queue);
+  /// Schedules File to be picked up by a worker thread unless it already is.
+  /// Must be called with RequestLock held.
+  void scheduleDocLocked(StringRef File);
   void handleRequest(ASTManagerRequestType RequestType, StringRef File);
 
+  std::vector<CompletionItem> codeCompleteImpl(StringRef File, unsigned Line,
+                                               unsigned Column);
+  std::vector<clang::tooling::Replacement>
+  getFixItsImpl(StringRef File, const clangd::Diagnostic &D);
+
   /// Parses files and publishes diagnostics.
   /// This function is called on the worker thread in asynchronous mode and
   /// on the main thread in synchronous mode.
   void parseFileAndPublishDiagnostics(StringRef File);
 
   /// Caches compilation databases loaded from directories(keys are directories).
+  /// Guarded by CompilationDatabasesLock.
   llvm::StringMap<std::unique_ptr<clang::tooling::CompilationDatabase>>
       CompilationDatabases;
+  /// A lock for access to CompilationDatabases.
+  std::mutex CompilationDatabasesLock;
 
   /// Clang objects.
   /// A map from filenames to DocData structures that store ASTUnit and Fixits for
   /// the files. The ASTUnits are used for generating diagnostics and fix-it-s
-  /// asynchronously by the worker thread and synchronously for code completion.
-  llvm::StringMap<DocData> DocDatas;
+  /// asynchronously by the worker threads and synchronously for code completion.
+  /// The map itself is guarded by DocDatasLock, the contents of each DocData
+  /// are guarded by DocData::Lock.
+  llvm::StringMap<std::shared_ptr<DocData>> DocDatas;
+  std::mutex DocDatasLock;
+  /// The sum of DocData::MemoryUsage of all DocDatas. Guarded by DocDatasLock.
+  size_t TotalMemoryUsage = 0;
+  /// Incremented on every access to a DocData. Guarded by DocDatasLock.
+  uint64_t UseCounter = 0;
+  /// 0 if the memory used by ASTs is not limited.
+  size_t MemoryBudget;
+  /// Immutable after construction, safe to share between threads.
   std::shared_ptr<clang::PCHContainerOperations> PCHs;
-  /// A lock for access to the DocDatas, CompilationDatabases and PCHs.
-  std::mutex ClangObjectLock;
+  /// nullptr if preambles are not stored. Thread-safe.
+  std::unique_ptr<preamble::PreambleStore> Preambles;
 
   /// Stores latest versions of the tracked documents to discard outdated requests.
-  /// Guarded by RequestLock.
-  /// TODO(ibiryukov): the entries are neved deleted from this map.
+  /// Entries are deleted once a document is closed and all of its requests have
+  /// been processed. Guarded by RequestLock.
   llvm::StringMap<DocVersion> DocVersions;
 
-  /// A LIFO queue of requests. Note that requests are discarded if the `version`
-  /// field is not equal to the one stored inside DocVersions.
-  /// TODO(krasimir): code completion should always have priority over parsing
-  /// for diagnostics.
-  std::deque<ASTManagerRequest> RequestQueue;
-  /// Setting Done to true will make the worker thread terminate.
+  /// Pending requests for each document. Note that requests are discarded if
+  /// the `version` field is not equal to the one stored inside DocVersions.
+  /// Queuing a new version of a document cancels all pending requests for its
+  /// older versions.
+  llvm::StringMap<DocRequestQueue> DocQueues;
+  /// Documents that have pending requests and are not being processed by any
+  /// worker thread. Workers pick the document with the most urgent request.
+  std::vector<std::string> ReadyDocs;
+  /// Sequence number of the next queued request.
+  uint64_t NextRequestSeq = 0;
+  /// Setting Done to true will make the worker threads terminate once there
+  /// are no requests left.
   bool Done = false;
-  /// Condition variable to wake up the worker thread.
+  /// Condition variable to wake up the worker threads.
   std::condition_variable ClangRequestCV;
-  /// Lock for accesses to RequestQueue, DocVersions and Done.
+  /// Lock for accesses to DocQueues, ReadyDocs, NextRequestSeq, DocVersions
+  /// and Done.
   std::mutex RequestLock;
 
-  /// We run parsing on a separate thread. This thread looks into RequestQueue to
-  /// find requests to handle and terminates when Done is set to true.
-  std::thread ClangWorker;
+  /// We run parsing on a pool of worker threads. Each thread takes a document
+  /// from ReadyDocs, handles its most urgent request and terminates when Done
+  /// is set to true and ReadyDocs is empty.
+  std::vector<std::thread> Workers;
 };
 
 } // namespace clangd
@@ -14,20 +14,73 @@
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Program.h"
+#include <chrono>
 #include <iostream>
 #include <string>
+#include <thread>
 using namespace clang::clangd;
 
+static unsigned getDefaultAsyncThreadsCount() {
+  unsigned HardwareConcurrency = std::thread::hardware_concurrency();
+  // C++ standard says that hardware_concurrency() may return 0, fallback to 1
+  // worker thread in that case.
+  if (HardwareConcurrency == 0)
+    return 1;
+  return HardwareConcurrency;
+}
+
 static llvm::cl::opt<bool>
     RunSynchronously("run-synchronously",
                      llvm::cl::desc("parse on main thread"),
                      llvm::cl::init(false), llvm::cl::Hidden);
 
+static llvm::cl::opt<unsigned>
+    WorkerThreadsCount("j",
+                       llvm::cl::desc("Number of worker threads used to parse "
+                                      "documents in parallel"),
+                       llvm::cl::init(getDefaultAsyncThreadsCount()));
+
+static llvm::cl::opt<unsigned> DebounceMs(
+    "debounce-ms",
+    llvm::cl::desc("Minimum delay in milliseconds between a document change "
+                   "and its reparse. Grows with the time it takes to parse the "
+                   "document"),
+    llvm::cl::init(100));
+
+static llvm::cl::opt<unsigned> MemoryBudgetMB(
+    "memory-budget-mb",
+    llvm::cl::desc("Memory budget in megabytes for the ASTs of open documents. "
+                   "The least recently used ASTs are freed when it is "
+                   "exceeded. 0 means unlimited"),
+    llvm::cl::init(2048));
+
+static llvm::cl::opt<std::string> PreambleCacheDir(
+    "preamble-cache-dir",
+    llvm::cl::desc("Directory to store precompiled preambles in. Stored "
+                   "preambles are shared between files with the same includes "
+                   "and flags, and across clangd sessions. If empty, every "
+                   "document builds its own preamble in memory"),
+    llvm::cl::init(""));
+
+static llvm::cl::opt<LogLevel> Verbosity(
+    "log", llvm::cl::desc("Verbosity of the messages written to stderr"),
+    llvm::cl::values(
+        clEnumValN(LogLevel::Error, "error", "Only log failures"),
+        clEnumValN(LogLevel::Info, "info", "Also log informational messages"),
+        clEnumValN(LogLevel::Verbose, "verbose",
+                   "Also log every message received and sent")),
+    llvm::cl::init(LogLevel::Info));
+
 int main(int argc, char *argv[]) {
   llvm::cl::ParseCommandLineOptions(argc, argv, "clangd");
+  if (WorkerThreadsCount == 0) {
+    llvm::errs() << "A number of worker threads cannot be 0. Did you mean to "
+                    "specify -run-synchronously?\n";
+    return 1;
+  }
   llvm::raw_ostream &Outs = llvm::outs();
   llvm::raw_ostream &Logs = llvm::errs();
-  JSONOutput Out(Outs, Logs);
+  JSONOutput Out(Outs, Logs, Verbosity);
 
   // Change stdin to binary to not lose \r\n on windows.
   llvm::sys::ChangeStdinToBinary();
@@ -35,7 +88,9 @@ int main(int argc, char *argv[]) {
   // Set up a document store and intialize all the method handlers for JSONRPC
   // dispatching.
   DocumentStore Store;
-  ASTManager AST(Out, Store, RunSynchronously);
+  ASTManager AST(Out, Store, RunSynchronously, WorkerThreadsCount,
+                 std::chrono::milliseconds(DebounceMs),
+                 size_t(MemoryBudgetMB) * 1024 * 1024, PreambleCacheDir);
   Store.addListener(&AST);
   JSONRPCDispatcher Dispatcher(llvm::make_unique<Handler>(Out));
   Dispatcher.registerHandler("initialize",
@@ -65,6 +120,8 @@ int main(int argc, char *argv[]) {
                              llvm::make_unique<CodeActionHandler>(Out, AST));
   Dispatcher.registerHandler("textDocument/completion",
                              llvm::make_unique<CompletionHandler>(Out, AST));
+  Dispatcher.registerHandler("clangd/memoryUsage",
+                             llvm::make_unique<MemoryUsageHandler>(Out, AST));
 
   while (std::cin.good()) {
     // A Language Server Protocol message starts with a HTTP header, delimited
@@ -100,19 +157,18 @@ int main(int argc, char *argv[]) {
     if (std::memcmp(NewlineBuf, "\r\n", 2) != 0)
       continue;
 
-    // Now read the JSON. Insert a trailing null byte as required by the YAML
-    // parser.
-    std::vector<char> JSON(Len + 1, '\0');
+    // Now read the JSON.
+    std::vector<char> JSON(Len);
     std::cin.read(JSON.data(), Len);
 
     if (Len > 0) {
       llvm::StringRef JSONRef(JSON.data(), Len);
       // Log the message.
-      Out.log("<-- " + JSONRef + "\n");
+      Out.log("<-- " + JSONRef + "\n", LogLevel::Verbose);
 
       // Finally, execute the action for this JSON message.
       if (!Dispatcher.call(JSONRef))
-        Out.log("JSON dispatch failed!\n");
+        Out.log("JSON dispatch failed!\n", LogLevel::Error);
 
       // If we're done, exit the loop.
       if (ShutdownHandler->isDone())
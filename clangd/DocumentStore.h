@@ -10,8 +10,11 @@
 #ifndef LLVM_CLANG_TOOLS_EXTRA_CLANGD_DOCUMENTSTORE_H
 #define LLVM_CLANG_TOOLS_EXTRA_CLANGD_DOCUMENTSTORE_H
 
+#include "PieceTable.h"
+#include "Protocol.h"
 #include "clang/Basic/LLVM.h"
 #include "llvm/ADT/StringMap.h"
+#include <memory>
 #include <mutex>
 #include <string>
 #include <vector>
@@ -26,6 +29,35 @@ struct DocumentStoreListener {
   virtual void onDocumentRemove(StringRef File) {}
 };
 
+/// Contents of a document at some version. Immutable after creation, so it can
+/// be shared between threads and outlive the document in the store.
+struct DocumentContents {
+  DocumentContents(unsigned Version, std::string Text)
+      : Version(Version), Text(std::move(Text)) {}
+
+  /// Incremented every time the document is changed in the store.
+  const unsigned Version;
+  const std::string Text;
+};
+
+/// The contents of all documents in a DocumentStore at some point in time,
+/// meant to be overlaid on top of the real file system. Copying a snapshot
+/// never copies the document contents, they are shared with the store.
+class DocumentSnapshot {
+public:
+  typedef std::pair<std::string, std::shared_ptr<const DocumentContents>>
+      Entry;
+
+  DocumentSnapshot() = default;
+  explicit DocumentSnapshot(std::vector<Entry> Docs) : Docs(std::move(Docs)) {}
+
+  std::vector<Entry>::const_iterator begin() const { return Docs.begin(); }
+  std::vector<Entry>::const_iterator end() const { return Docs.end(); }
+
+private:
+  std::vector<Entry> Docs;
+};
+
 /// A container for files opened in a workspace, addressed by File. The contents
 /// are owned by the DocumentStore.
 class DocumentStore {
@@ -34,11 +66,47 @@ public:
   void addDocument(StringRef File, StringRef Text) {
     {
       std::lock_guard<std::mutex> Guard(DocsMutex);
-      Docs[File] = Text;
+      auto It = Docs.find(File);
+      if (It == Docs.end())
+        Docs.insert(std::make_pair(File, Document(0, Text.str())));
+      else
+        It->second = Document(It->second.Version + 1, Text.str());
     }
     for (const auto &Listener : Listeners)
       Listener->onDocumentAdd(File);
   }
+  /// Apply \p Changes to a document in order. Changes with a range replace
+  /// only that range, others replace the whole document. Listeners are
+  /// notified once, after all changes are applied. Returns false and does
+  /// nothing if the document is unknown.
+  bool changeDocument(StringRef File,
+                      ArrayRef<TextDocumentContentChangeEvent> Changes) {
+    {
+      std::lock_guard<std::mutex> Guard(DocsMutex);
+      auto It = Docs.find(File);
+      if (It == Docs.end())
+        return false;
+      Document &Doc = It->second;
+      for (const auto &Change : Changes) {
+        if (!Change.range) {
+          Doc.Text = PieceTable(Change.text);
+          continue;
+        }
+        size_t Begin = Doc.Text.getOffset(Change.range->start.line,
+                                          Change.range->start.character);
+        size_t End = Doc.Text.getOffset(Change.range->end.line,
+                                        Change.range->end.character);
+        if (End < Begin)
+          std::swap(Begin, End);
+        Doc.Text.replace(Begin, End - Begin, Change.text);
+      }
+      ++Doc.Version;
+      Doc.Contents.reset();
+    }
+    for (const auto &Listener : Listeners)
+      Listener->onDocumentAdd(File);
+    return true;
+  }
   /// Delete a document from the store.
   void removeDocument(StringRef File) {
     {
@@ -55,26 +123,49 @@ public:
   std::string getDocument(StringRef File) const {
     // FIXME: This could be a reader lock.
     std::lock_guard<std::mutex> Guard(DocsMutex);
-    return Docs.lookup(File);
+    auto It = Docs.find(File);
+    if (It == Docs.end())
+      return "";
+    return It->second.getContents()->Text;
   }
 
   /// Add a listener. Does not take ownership.
   void addListener(DocumentStoreListener *DSL) { Listeners.push_back(DSL); }
 
-  /// Get name and constents of all documents in this store.
+  /// Get name and contents of all documents in this store.
   ///
-  /// This function is thread-safe. It returns a copies to avoid handing out
-  /// references to unguarded data.
-  std::vector<std::pair<std::string, std::string>> getAllDocuments() const {
-    std::vector<std::pair<std::string, std::string>> AllDocs;
+  /// This function is thread-safe. The contents are immutable and shared with
+  /// the store, only documents that changed since the last snapshot are copied
+  /// out of their piece tables.
+  DocumentSnapshot getSnapshot() const {
+    std::vector<DocumentSnapshot::Entry> AllDocs;
     std::lock_guard<std::mutex> Guard(DocsMutex);
+    AllDocs.reserve(Docs.size());
     for (const auto &P : Docs)
-      AllDocs.emplace_back(P.first(), P.second);
-    return AllDocs;
+      AllDocs.emplace_back(P.first(), P.second.getContents());
+    return DocumentSnapshot(std::move(AllDocs));
   }
 
 private:
-  llvm::StringMap<std::string> Docs;
+  struct Document {
+    Document(unsigned Version, std::string Text)
+        : Text(std::move(Text)), Version(Version) {}
+
+    /// Returns the contents of the document, only copying them out of Text if
+    /// it changed since the last call.
+    std::shared_ptr<const DocumentContents> getContents() const {
+      if (!Contents)
+        Contents = std::make_shared<DocumentContents>(Version, Text.getText());
+      return Contents;
+    }
+
+    PieceTable Text;
+    unsigned Version;
+    /// Cached contents of the current version, reset on every change.
+    mutable std::shared_ptr<const DocumentContents> Contents;
+  };
+
+  llvm::StringMap<Document> Docs;
   std::vector<DocumentStoreListener *> Listeners;
 
   mutable std::mutex DocsMutex;
@@ -0,0 +1,332 @@
+//===--- JSONParser.cpp - JSON DOM for JSONRPC messages -------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "JSONParser.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Twine.h"
+#include "llvm/Support/ConvertUTF.h"
+#include <algorithm>
+#include <cstring>
+using namespace clang;
+using namespace clangd;
+using namespace clangd::json;
+
+bool NumberNode::getAsInteger(long long &Result) const {
+  return llvm::getAsSignedInteger(getRawValue(), 10, Result);
+}
+
+const Node *ObjectNode::get(StringRef Key) const {
+  for (const Member &M : Members)
+    if (M.Key == Key)
+      return M.Value;
+  return nullptr;
+}
+
+namespace {
+
+/// Recursive descent parser. The nesting depth is limited, so malformed input
+/// can't overflow the stack.
+class Parser {
+public:
+  Parser(StringRef Text, llvm::BumpPtrAllocator &Alloc)
+      : Text(Text), Pos(0), Alloc(Alloc) {}
+
+  const Node *parseDocument() {
+    const Node *Root = parseValue(/*Depth=*/0);
+    if (!Root)
+      return nullptr;
+    skipWhitespace();
+    if (Pos != Text.size())
+      return fail("trailing characters after JSON value");
+    return Root;
+  }
+
+  StringRef getError() const { return Error; }
+
+private:
+  static const unsigned MaxDepth = 512;
+
+  const Node *fail(const Twine &Message) {
+    if (Error.empty())
+      Error = ("offset " + Twine(Pos) + ": " + Message).str();
+    return nullptr;
+  }
+
+  void skipWhitespace() {
+    while (Pos < Text.size() && (Text[Pos] == ' ' || Text[Pos] == '\t' ||
+                                 Text[Pos] == '\n' || Text[Pos] == '\r'))
+      ++Pos;
+  }
+
+  bool consume(char C) {
+    skipWhitespace();
+    if (Pos < Text.size() && Text[Pos] == C) {
+      ++Pos;
+      return true;
+    }
+    return false;
+  }
+
+  template <typename T, typename... Args> T *create(Args &&... As) {
+    return new (Alloc.Allocate<T>()) T(std::forward<Args>(As)...);
+  }
+
+  template <typename T> ArrayRef<T> copyToArena(ArrayRef<T> Elements) {
+    if (Elements.empty())
+      return None;
+    T *Storage = Alloc.Allocate<T>(Elements.size());
+    std::uninitialized_copy(Elements.begin(), Elements.end(), Storage);
+    return ArrayRef<T>(Storage, Elements.size());
+  }
+
+  const Node *parseValue(unsigned Depth) {
+    if (Depth > MaxDepth)
+      return fail("nesting too deep");
+    skipWhitespace();
+    if (Pos == Text.size())
+      return fail("unexpected end of input");
+    switch (Text[Pos]) {
+    case '{':
+      return parseObject(Depth);
+    case '[':
+      return parseArray(Depth);
+    case '"':
+      return parseString();
+    case 't':
+      return parseLiteral("true", Node::NK_Boolean);
+    case 'f':
+      return parseLiteral("false", Node::NK_Boolean);
+    case 'n':
+      return parseLiteral("null", Node::NK_Null);
+    default:
+      return parseNumber();
+    }
+  }
+
+  const Node *parseLiteral(StringRef Literal, Node::NodeKind Kind) {
+    if (!Text.substr(Pos).startswith(Literal))
+      return fail("invalid literal");
+    StringRef Raw = Text.substr(Pos, Literal.size());
+    Pos += Literal.size();
+    return create<LiteralNode>(Kind, Raw);
+  }
+
+  const Node *parseNumber() {
+    size_t Start = Pos;
+    auto IsDigit = [this] {
+      return Pos < Text.size() && Text[Pos] >= '0' && Text[Pos] <= '9';
+    };
+    if (Pos < Text.size() && Text[Pos] == '-')
+      ++Pos;
+    if (!IsDigit())
+      return fail("invalid number");
+    if (Text[Pos] == '0') {
+      ++Pos;
+    } else {
+      while (IsDigit())
+        ++Pos;
+    }
+    if (Pos < Text.size() && Text[Pos] == '.') {
+      ++Pos;
+      if (!IsDigit())
+        return fail("invalid number");
+      while (IsDigit())
+        ++Pos;
+    }
+    if (Pos < Text.size() && (Text[Pos] == 'e' || Text[Pos] == 'E')) {
+      ++Pos;
+      if (Pos < Text.size() && (Text[Pos] == '+' || Text[Pos] == '-'))
+        ++Pos;
+      if (!IsDigit())
+        return fail("invalid number");
+      while (IsDigit())
+        ++Pos;
+    }
+    return create<NumberNode>(Text.slice(Start, Pos));
+  }
+
+  /// Parses the four hex digits of a \u escape.
+  bool parseHex4(unsigned &CodeUnit) {
+    if (Pos + 4 > Text.size())
+      return false;
+    unsigned long long Value;
+    if (llvm::getAsUnsignedInteger(Text.substr(Pos, 4), 16, Value))
+      return false;
+    CodeUnit = Value;
+    Pos += 4;
+    return true;
+  }
+
+  /// Parses a string starting at the opening quote into \p Value. Returns false
+  /// on error.
+  bool parseStringValue(StringRef &Value) {
+    assert(Text[Pos] == '"');
+    size_t Start = ++Pos;
+    // Fast path: strings without escapes reference the text directly.
+    size_t End = Text.find_first_of("\"\\", Pos);
+    if (End == StringRef::npos) {
+      fail("unterminated string");
+      return false;
+    }
+    if (Text[End] == '"') {
+      Pos = End + 1;
+      Value = Text.slice(Start, End);
+      return true;
+    }
+
+    std::string Unescaped = Text.slice(Start, End).str();
+    Pos = End;
+    while (true) {
+      if (Pos == Text.size()) {
+        fail("unterminated string");
+        return false;
+      }
+      char C = Text[Pos++];
+      if (C == '"')
+        break;
+      if (C != '\\') {
+        Unescaped += C;
+        continue;
+      }
+      if (Pos == Text.size()) {
+        fail("unterminated string");
+        return false;
+      }
+      switch (Text[Pos++]) {
+      case '"':
+        Unescaped += '"';
+        break;
+      case '\\':
+        Unescaped += '\\';
+        break;
+      case '/':
+        Unescaped += '/';
+        break;
+      case 'b':
+        Unescaped += '\b';
+        break;
+      case 'f':
+        Unescaped += '\f';
+        break;
+      case 'n':
+        Unescaped += '\n';
+        break;
+      case 'r':
+        Unescaped += '\r';
+        break;
+      case 't':
+        Unescaped += '\t';
+        break;
+      case 'u': {
+        unsigned CodePoint;
+        if (!parseHex4(CodePoint)) {
+          fail("invalid \\u escape");
+          return false;
+        }
+        // Combine UTF-16 surrogate pairs.
+        if (CodePoint >= 0xD800 && CodePoint < 0xDC00 &&
+            Text.substr(Pos).startswith("\\u")) {
+          size_t HighPos = Pos;
+          Pos += 2;
+          unsigned Low;
+          if (parseHex4(Low) && Low >= 0xDC00 && Low < 0xE000)
+            CodePoint =
+                0x10000 + ((CodePoint - 0xD800) << 10) + (Low - 0xDC00);
+          else
+            Pos = HighPos;
+        }
+        char Buf[UNI_MAX_UTF8_BYTES_PER_CODE_POINT];
+        char *Out = Buf;
+        if (!llvm::ConvertCodePointToUTF8(CodePoint, Out)) {
+          fail("invalid \\u escape");
+          return false;
+        }
+        Unescaped.append(Buf, Out);
+        break;
+      }
+      default:
+        fail("invalid escape sequence");
+        return false;
+      }
+    }
+
+    char *Storage = Alloc.Allocate<char>(Unescaped.size());
+    std::memcpy(Storage, Unescaped.data(), Unescaped.size());
+    Value = StringRef(Storage, Unescaped.size());
+    return true;
+  }
+
+  const Node *parseString() {
+    size_t Start = Pos;
+    StringRef Value;
+    if (!parseStringValue(Value))
+      return nullptr;
+    return create<StringNode>(Text.slice(Start, Pos), Value);
+  }
+
+  const Node *parseArray(unsigned Depth) {
+    size_t Start = Pos++;
+    SmallVector<const Node *, 8> Elements;
+    if (!consume(']')) {
+      do {
+        const Node *Element = parseValue(Depth + 1);
+        if (!Element)
+          return nullptr;
+        Elements.push_back(Element);
+      } while (consume(','));
+      if (!consume(']'))
+        return fail("expected ',' or ']'");
+    }
+    return create<ArrayNode>(Text.slice(Start, Pos),
+                             copyToArena<const Node *>(Elements));
+  }
+
+  const Node *parseObject(unsigned Depth) {
+    size_t Start = Pos++;
+    SmallVector<ObjectNode::Member, 8> Members;
+    if (!consume('}')) {
+      do {
+        skipWhitespace();
+        if (Pos == Text.size() || Text[Pos] != '"')
+          return fail("expected object key");
+        StringRef Key;
+        if (!parseStringValue(Key))
+          return nullptr;
+        if (!consume(':'))
+          return fail("expected ':'");
+        const Node *Value = parseValue(Depth + 1);
+        if (!Value)
+          return nullptr;
+        Members.push_back({Key, Value});
+      } while (consume(','));
+      if (!consume('}'))
+        return fail("expected ',' or '}'");
+    }
+    return create<ObjectNode>(Text.slice(Start, Pos),
+                              copyToArena<ObjectNode::Member>(Members));
+  }
+
+  StringRef Text;
+  size_t Pos;
+  llvm::BumpPtrAllocator &Alloc;
+  std::string Error;
+};
+
+} // namespace
+
+const Node *Document::parse(StringRef Text) {
+  // Free the nodes of the previous text, but keep the memory around.
+  Alloc.Reset();
+  Error.clear();
+  Parser P(Text, Alloc);
+  const Node *Root = P.parseDocument();
+  if (!Root)
+    Error = P.getError().str();
+  return Root;
+}
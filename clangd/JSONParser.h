@@ -0,0 +1,150 @@
+//===--- JSONParser.h - JSON DOM for JSONRPC messages -----------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// A small JSON parser that builds a read-only DOM for a complete message before
+// it is dispatched. All nodes are allocated in an arena owned by a
+// json::Document and reference the parsed text wherever possible: only strings
+// containing escape sequences are copied (unescaped) into the arena.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_TOOLS_EXTRA_CLANGD_JSONPARSER_H
+#define LLVM_CLANG_TOOLS_EXTRA_CLANGD_JSONPARSER_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Allocator.h"
+#include <string>
+
+namespace clang {
+namespace clangd {
+namespace json {
+
+/// Base class of all JSON values.
+class Node {
+public:
+  enum NodeKind { NK_Null, NK_Boolean, NK_Number, NK_String, NK_Array,
+                  NK_Object };
+
+  NodeKind getKind() const { return Kind; }
+
+  /// The text this node was parsed from, e.g. including the quotes for
+  /// strings.
+  StringRef getRawValue() const { return RawValue; }
+
+protected:
+  Node(NodeKind Kind, StringRef RawValue) : Kind(Kind), RawValue(RawValue) {}
+
+private:
+  NodeKind Kind;
+  StringRef RawValue;
+};
+
+/// A null, true or false literal.
+class LiteralNode : public Node {
+public:
+  LiteralNode(NodeKind Kind, StringRef RawValue) : Node(Kind, RawValue) {}
+
+  bool isNull() const { return getKind() == NK_Null; }
+  /// Only valid for boolean literals.
+  bool getValue() const { return getRawValue() == "true"; }
+
+  static bool classof(const Node *N) {
+    return N->getKind() == NK_Null || N->getKind() == NK_Boolean;
+  }
+};
+
+class NumberNode : public Node {
+public:
+  explicit NumberNode(StringRef RawValue) : Node(NK_Number, RawValue) {}
+
+  /// Returns true on error, e.g. if the number is not an integer. This
+  /// mirrors llvm::getAsSignedInteger.
+  bool getAsInteger(long long &Result) const;
+
+  static bool classof(const Node *N) { return N->getKind() == NK_Number; }
+};
+
+class StringNode : public Node {
+public:
+  StringNode(StringRef RawValue, StringRef Value)
+      : Node(NK_String, RawValue), Value(Value) {}
+
+  /// The unescaped value of the string, without the quotes.
+  StringRef getValue() const { return Value; }
+
+  static bool classof(const Node *N) { return N->getKind() == NK_String; }
+
+private:
+  StringRef Value;
+};
+
+class ArrayNode : public Node {
+public:
+  ArrayNode(StringRef RawValue, ArrayRef<const Node *> Elements)
+      : Node(NK_Array, RawValue), Elements(Elements) {}
+
+  ArrayRef<const Node *>::iterator begin() const { return Elements.begin(); }
+  ArrayRef<const Node *>::iterator end() const { return Elements.end(); }
+  size_t size() const { return Elements.size(); }
+
+  static bool classof(const Node *N) { return N->getKind() == NK_Array; }
+
+private:
+  ArrayRef<const Node *> Elements;
+};
+
+class ObjectNode : public Node {
+public:
+  struct Member {
+    StringRef Key;
+    const Node *Value;
+  };
+
+  ObjectNode(StringRef RawValue, ArrayRef<Member> Members)
+      : Node(NK_Object, RawValue), Members(Members) {}
+
+  /// Members in the order they appear in the text.
+  ArrayRef<Member>::iterator begin() const { return Members.begin(); }
+  ArrayRef<Member>::iterator end() const { return Members.end(); }
+  size_t size() const { return Members.size(); }
+
+  /// Returns the value of the first member named \p Key, or nullptr if there
+  /// is none. Objects in LSP messages are small, so this is a linear search.
+  const Node *get(StringRef Key) const;
+
+  static bool classof(const Node *N) { return N->getKind() == NK_Object; }
+
+private:
+  ArrayRef<Member> Members;
+};
+
+/// Owns the nodes of a parsed JSON text. The nodes reference the text, so it
+/// must outlive them. A Document can be reused for parsing multiple texts; the
+/// nodes of the previous text are freed, but the arena's memory is kept.
+class Document {
+public:
+  /// Parses \p Text. Returns nullptr and sets an error message if \p Text is
+  /// not valid JSON.
+  const Node *parse(StringRef Text);
+
+  /// Returns the error message of the last failed parse.
+  StringRef getError() const { return Error; }
+
+private:
+  llvm::BumpPtrAllocator Alloc;
+  std::string Error;
+};
+
+} // namespace json
+} // namespace clangd
+} // namespace clang
+
+#endif
@@ -9,33 +9,104 @@
 
 #include "JSONRPCDispatcher.h"
 #include "ProtocolHandlers.h"
-#include "llvm/ADT/SmallString.h"
-#include "llvm/Support/SourceMgr.h"
-#include "llvm/Support/YAMLParser.h"
+#include "llvm/ADT/Twine.h"
+#include "llvm/Support/raw_ostream.h"
 using namespace clang;
 using namespace clangd;
 
-void JSONOutput::writeMessage(const Twine &Message) {
-  llvm::SmallString<128> Storage;
-  StringRef M = Message.toStringRef(Storage);
+JSONOutput::JSONOutput(llvm::raw_ostream &Outs, llvm::raw_ostream &Logs,
+                       LogLevel Verbosity)
+    : Outs(Outs), Logs(Logs), Verbosity(Verbosity), Head(nullptr),
+      Done(false) {
+  Writer = std::thread([this] { runWriter(); });
+}
 
-  std::lock_guard<std::mutex> Guard(StreamMutex);
+JSONOutput::~JSONOutput() {
+  {
+    std::lock_guard<std::mutex> Lock(WakeupMutex);
+    Done = true;
+  }
+  Wakeup.notify_one();
+  Writer.join();
+}
+
+void JSONOutput::writeMessage(const Twine &Message) {
+  std::string M = Message.str();
   // Log without headers.
-  Logs << "--> " << M << '\n';
-  Logs.flush();
+  log(Twine("--> ") + M + "\n", LogLevel::Verbose);
+  enqueue(/*IsLog=*/false, std::move(M));
+}
 
-  // Emit message with header.
-  Outs << "Content-Length: " << M.size() << "\r\n\r\n" << M;
-  Outs.flush();
+void JSONOutput::log(const Twine &Message, LogLevel Level) {
+  if (Level > Verbosity)
+    return;
+  enqueue(/*IsLog=*/true, Message.str());
 }
 
-void JSONOutput::log(const Twine &Message) {
-  std::lock_guard<std::mutex> Guard(StreamMutex);
-  Logs << Message;
-  Logs.flush();
+void JSONOutput::enqueue(bool IsLog, std::string Text) {
+  auto *M = new QueuedMessage{nullptr, IsLog, std::move(Text)};
+  QueuedMessage *OldHead = Head.load(std::memory_order_relaxed);
+  do
+    M->Next = OldHead;
+  while (!Head.compare_exchange_weak(OldHead, M, std::memory_order_release,
+                                     std::memory_order_relaxed));
+  // The writer only sleeps if it found the queue empty, so there is nobody to
+  // wake up otherwise. Taking the mutex makes sure the writer is either
+  // already waiting or will see the new message before it waits.
+  if (!OldHead) {
+    { std::lock_guard<std::mutex> Lock(WakeupMutex); }
+    Wakeup.notify_one();
+  }
 }
 
-void Handler::handleMethod(llvm::yaml::MappingNode *Params, StringRef ID) {
+void JSONOutput::runWriter() {
+  while (true) {
+    bool Stopping;
+    {
+      std::unique_lock<std::mutex> Lock(WakeupMutex);
+      Wakeup.wait(Lock, [this] {
+        return Done || Head.load(std::memory_order_relaxed) != nullptr;
+      });
+      Stopping = Done;
+    }
+
+    QueuedMessage *Batch = Head.exchange(nullptr, std::memory_order_acquire);
+    if (!Batch) {
+      if (Stopping)
+        return;
+      continue;
+    }
+
+    // The queue is linked from newest to oldest, restore the original order.
+    QueuedMessage *Oldest = nullptr;
+    while (Batch) {
+      QueuedMessage *Next = Batch->Next;
+      Batch->Next = Oldest;
+      Oldest = Batch;
+      Batch = Next;
+    }
+
+    bool WroteOuts = false, WroteLogs = false;
+    while (Oldest) {
+      std::unique_ptr<QueuedMessage> M(Oldest);
+      Oldest = M->Next;
+      if (M->IsLog) {
+        Logs << M->Text;
+        WroteLogs = true;
+      } else {
+        // Emit message with header.
+        Outs << "Content-Length: " << M->Text.size() << "\r\n\r\n" << M->Text;
+        WroteOuts = true;
+      }
+    }
+    if (WroteLogs)
+      Logs.flush();
+    if (WroteOuts)
+      Outs.flush();
+  }
+}
+
+void Handler::handleMethod(const json::ObjectNode *Params, StringRef ID) {
   Output.log("Method ignored.\n");
   // Return that this method is unsupported.
   writeMessage(
@@ -43,7 +114,7 @@ void Handler::handleMethod(llvm::yaml::MappingNode *Params, StringRef ID) {
       R"(,"error":{"code":-32601}})");
 }
 
-void Handler::handleNotification(llvm::yaml::MappingNode *Params) {
+void Handler::handleNotification(const json::ObjectNode *Params) {
   Output.log("Notification ignored.\n");
 }
 
@@ -55,10 +126,9 @@ void JSONRPCDispatcher::registerHandler(StringRef Method,
 
 static void
 callHandler(const llvm::StringMap<std::unique_ptr<Handler>> &Handlers,
-            llvm::yaml::ScalarNode *Method, llvm::yaml::ScalarNode *Id,
-            llvm::yaml::MappingNode *Params, Handler *UnknownHandler) {
-  llvm::SmallString<10> MethodStorage;
-  auto I = Handlers.find(Method->getValue(MethodStorage));
+            const json::StringNode *Method, const json::Node *Id,
+            const json::ObjectNode *Params, Handler *UnknownHandler) {
+  auto I = Handlers.find(Method->getValue());
   auto *Handler = I != Handlers.end() ? I->second.get() : UnknownHandler;
   if (Id)
     Handler->handleMethod(Params, Id->getRawValue());
@@ -66,66 +136,37 @@ callHandler(const llvm::StringMap<std::unique_ptr<Handler>> &Handlers,
     Handler->handleNotification(Params);
 }
 
-bool JSONRPCDispatcher::call(StringRef Content) const {
-  llvm::SourceMgr SM;
-  llvm::yaml::Stream YAMLStream(Content, SM);
-
-  auto Doc = YAMLStream.begin();
-  if (Doc == YAMLStream.end())
-    return false;
-
-  auto *Root = Doc->getRoot();
-  if (!Root)
-    return false;
-
-  auto *Object = dyn_cast<llvm::yaml::MappingNode>(Root);
+bool JSONRPCDispatcher::call(StringRef Content) {
+  auto *Object = dyn_cast_or_null<json::ObjectNode>(Doc.parse(Content));
   if (!Object)
     return false;
 
-  llvm::yaml::ScalarNode *Version = nullptr;
-  llvm::yaml::ScalarNode *Method = nullptr;
-  llvm::yaml::MappingNode *Params = nullptr;
-  llvm::yaml::ScalarNode *Id = nullptr;
-  for (auto &NextKeyValue : *Object) {
-    auto *KeyString = dyn_cast<llvm::yaml::ScalarNode>(NextKeyValue.getKey());
-    if (!KeyString)
-      return false;
-
-    llvm::SmallString<10> KeyStorage;
-    StringRef KeyValue = KeyString->getValue(KeyStorage);
-    llvm::yaml::Node *Value = NextKeyValue.getValue();
-    if (!Value)
-      return false;
+  const json::StringNode *Method = nullptr;
+  const json::ObjectNode *Params = nullptr;
+  const json::Node *Id = nullptr;
+  for (const auto &NextKeyValue : *Object) {
+    StringRef KeyValue = NextKeyValue.Key;
+    const json::Node *Value = NextKeyValue.Value;
 
     if (KeyValue == "jsonrpc") {
       // This should be "2.0". Always.
-      Version = dyn_cast<llvm::yaml::ScalarNode>(Value);
-      if (!Version || Version->getRawValue() != "\"2.0\"")
+      auto *Version = dyn_cast<json::StringNode>(Value);
+      if (!Version || Version->getValue() != "2.0")
         return false;
     } else if (KeyValue == "method") {
-      Method = dyn_cast<llvm::yaml::ScalarNode>(Value);
+      Method = dyn_cast<json::StringNode>(Value);
     } else if (KeyValue == "id") {
-      Id = dyn_cast<llvm::yaml::ScalarNode>(Value);
+      Id = Value;
     } else if (KeyValue == "params") {
-      if (!Method)
-        return false;
-      // We have to interleave the call of the function here, otherwise the
-      // YAMLParser will die because it can't go backwards. This is unfortunate
-      // because it will break clients that put the id after params. A possible
-      // fix would be to split the parsing and execution phases.
-      Params = dyn_cast<llvm::yaml::MappingNode>(Value);
-      callHandler(Handlers, Method, Id, Params, UnknownHandler.get());
-      return true;
+      Params = dyn_cast<json::ObjectNode>(Value);
     } else {
       return false;
     }
   }
 
-  // In case there was a request with no params, call the handler on the
-  // leftovers.
   if (!Method)
     return false;
-  callHandler(Handlers, Method, Id, nullptr, UnknownHandler.get());
+  callHandler(Handlers, Method, Id, Params, UnknownHandler.get());
 
   return true;
 }
@@ -10,32 +10,72 @@
 #ifndef LLVM_CLANG_TOOLS_EXTRA_CLANGD_JSONRPCDISPATCHER_H
 #define LLVM_CLANG_TOOLS_EXTRA_CLANGD_JSONRPCDISPATCHER_H
 
+#include "JSONParser.h"
 #include "clang/Basic/LLVM.h"
 #include "llvm/ADT/StringMap.h"
-#include "llvm/Support/YAMLParser.h"
+#include <atomic>
+#include <condition_variable>
 #include <mutex>
+#include <string>
+#include <thread>
 
 namespace clang {
 namespace clangd {
 
+/// Verbosity of the messages written to the logging stream.
+enum class LogLevel {
+  /// Only failures, e.g. messages that could not be decoded.
+  Error,
+  /// Also informational messages. This is the default.
+  Info,
+  /// Also echo every message received and sent.
+  Verbose
+};
+
 /// Encapsulates output and logs streams and provides thread-safe access to
 /// them.
+///
+/// Messages are written by a dedicated thread, so threads emitting a message
+/// never block on I/O. Emitting a message only pushes it onto a lock-free
+/// queue; the writer thread takes all queued messages at once, writes them in
+/// order and flushes the streams once per batch. The destructor writes all
+/// pending messages before returning.
 class JSONOutput {
 public:
-  JSONOutput(llvm::raw_ostream &Outs, llvm::raw_ostream &Logs)
-      : Outs(Outs), Logs(Logs) {}
+  JSONOutput(llvm::raw_ostream &Outs, llvm::raw_ostream &Logs,
+             LogLevel Verbosity = LogLevel::Info);
+  ~JSONOutput();
 
   /// Emit a JSONRPC message.
   void writeMessage(const Twine &Message);
 
-  /// Write to the logging stream.
-  void log(const Twine &Message);
+  /// Write to the logging stream, unless \p Level is more verbose than the
+  /// configured verbosity.
+  void log(const Twine &Message, LogLevel Level = LogLevel::Info);
 
 private:
+  struct QueuedMessage {
+    QueuedMessage *Next;
+    /// True if Text goes to Logs, false if it's a JSONRPC message.
+    bool IsLog;
+    std::string Text;
+  };
+
+  void enqueue(bool IsLog, std::string Text);
+  void runWriter();
+
   llvm::raw_ostream &Outs;
   llvm::raw_ostream &Logs;
-
-  std::mutex StreamMutex;
+  const LogLevel Verbosity;
+
+  /// The most recently queued message. Messages are linked from newest to
+  /// oldest, the writer reverses each batch it takes.
+  std::atomic<QueuedMessage *> Head;
+  /// Only used to let the writer thread sleep while the queue is empty.
+  std::mutex WakeupMutex;
+  std::condition_variable Wakeup;
+  bool Done;
+  std::thread Writer;
 };
 
 /// Callback for messages sent to the server, called by the JSONRPCDispatcher.
@@ -47,10 +87,10 @@ public:
   /// Called when the server receives a method call. This is supposed to return
   /// a result on Outs. The default implementation returns an "unknown method"
   /// error to the client and logs a warning.
-  virtual void handleMethod(llvm::yaml::MappingNode *Params, StringRef ID);
+  virtual void handleMethod(const json::ObjectNode *Params, StringRef ID);
   /// Called when the server receives a notification. No result should be
   /// written to Outs. The default implemetation logs a warning.
-  virtual void handleNotification(llvm::yaml::MappingNode *Params);
+  virtual void handleNotification(const json::ObjectNode *Params);
 
 protected:
   JSONOutput &Output;
@@ -71,12 +111,16 @@ public:
   /// Registers a Handler for the specified Method.
   void registerHandler(StringRef Method, std::unique_ptr<Handler> H);
 
-  /// Parses a JSONRPC message and calls the Handler for it.
-  bool call(StringRef Content) const;
+  /// Parses a JSONRPC message and calls the Handler for it. The whole message
+  /// is parsed before the Handler is called, so the order of the fields in the
+  /// message doesn't matter.
+  bool call(StringRef Content);
 
 private:
   llvm::StringMap<std::unique_ptr<Handler>> Handlers;
   std::unique_ptr<Handler> UnknownHandler;
+  /// Holds the parsed message. Reused between calls to avoid allocations.
+  json::Document Doc;
 };
 
 } // namespace clangd
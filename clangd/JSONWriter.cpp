@@ -0,0 +1,109 @@
+//===--- JSONWriter.cpp - Streaming JSON serialization --------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "JSONWriter.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/raw_ostream.h"
+#include <cassert>
+using namespace clang;
+using namespace clangd;
+using namespace clangd::json;
+
+void Writer::valueBegin() {
+  if (AfterKey) {
+    AfterKey = false;
+    return;
+  }
+  if (HasElements.empty())
+    return;
+  if (HasElements.back())
+    OS << ',';
+  HasElements.back() = true;
+}
+
+void Writer::objectBegin() {
+  valueBegin();
+  OS << '{';
+  HasElements.push_back(false);
+}
+
+void Writer::objectEnd() {
+  assert(!AfterKey && "Missing value for object member");
+  HasElements.pop_back();
+  OS << '}';
+}
+
+void Writer::arrayBegin() {
+  valueBegin();
+  OS << '[';
+  HasElements.push_back(false);
+}
+
+void Writer::arrayEnd() {
+  HasElements.pop_back();
+  OS << ']';
+}
+
+void Writer::key(StringRef Key) {
+  assert(!AfterKey && "Missing value for object member");
+  valueBegin();
+  writeString(Key);
+  OS << ':';
+  AfterKey = true;
+}
+
+void Writer::value(StringRef S) {
+  valueBegin();
+  writeString(S);
+}
+
+void Writer::value(long long N) {
+  valueBegin();
+  OS << N;
+}
+
+void Writer::writeString(StringRef S) {
+  OS << '"';
+  // Write runs of characters that don't need escaping in one go.
+  size_t RunStart = 0;
+  for (size_t I = 0, E = S.size(); I != E; ++I) {
+    unsigned char C = S[I];
+    if (C >= 0x20 && C != '"' && C != '\\')
+      continue;
+    OS << S.slice(RunStart, I);
+    RunStart = I + 1;
+    switch (C) {
+    case '"':
+      OS << "\\\"";
+      break;
+    case '\\':
+      OS << "\\\\";
+      break;
+    case '\b':
+      OS << "\\b";
+      break;
+    case '\f':
+      OS << "\\f";
+      break;
+    case '\n':
+      OS << "\\n";
+      break;
+    case '\r':
+      OS << "\\r";
+      break;
+    case '\t':
+      OS << "\\t";
+      break;
+    default:
+      OS << "\\u00" << llvm::hexdigit(C >> 4) << llvm::hexdigit(C & 0xF);
+      break;
+    }
+  }
+  OS << S.substr(RunStart) << '"';
+}
@@ -0,0 +1,69 @@
+//===--- JSONWriter.h - Streaming JSON serialization ------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// A JSON writer that streams values directly into a raw_ostream. It inserts
+// the separators between members and elements and escapes strings, so callers
+// don't have to build messages out of preformatted fragments.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_TOOLS_EXTRA_CLANGD_JSONWRITER_H
+#define LLVM_CLANG_TOOLS_EXTRA_CLANGD_JSONWRITER_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+
+namespace clang {
+namespace clangd {
+namespace json {
+
+/// Writes a single JSON value to a stream. Members of an object are written by
+/// calling key() followed by the calls writing their value, e.g.
+///
+///   W.objectBegin();
+///   W.key("line");
+///   W.value(42);
+///   W.objectEnd();
+///
+/// The output contains no whitespace.
+class Writer {
+public:
+  explicit Writer(llvm::raw_ostream &OS) : OS(OS), AfterKey(false) {}
+
+  void objectBegin();
+  void objectEnd();
+  void arrayBegin();
+  void arrayEnd();
+
+  /// Writes the key of the next member of the current object.
+  void key(StringRef Key);
+
+  /// Writes \p S as an escaped string.
+  void value(StringRef S);
+  void value(long long N);
+
+private:
+  /// Writes the separator needed before the next value, if any.
+  void valueBegin();
+  void writeString(StringRef S);
+
+  llvm::raw_ostream &OS;
+  /// For every open object and array, whether it already has a member or an
+  /// element.
+  SmallVector<bool, 8> HasElements;
+  /// True if a key was written, but not yet its value.
+  bool AfterKey;
+};
+
+} // namespace json
+} // namespace clangd
+} // namespace clang
+
+#endif
@@ -0,0 +1,144 @@
+//===--- PieceTable.cpp - Editable text buffer ----------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "PieceTable.h"
+#include <algorithm>
+#include <cassert>
+using namespace clang;
+using namespace clangd;
+
+/// Edits are cheap as long as the number of pieces is small. Once there are
+/// more pieces than this, the text is copied into a single piece again.
+static const size_t MaxPieces = 2048;
+
+PieceTable::PieceTable(std::string Text)
+    : Original(std::move(Text)), Size(Original.size()) {
+  if (!Original.empty())
+    Pieces.push_back({/*IsAdded=*/false, 0, Original.size(),
+                      static_cast<size_t>(StringRef(Original).count('\n'))});
+}
+
+StringRef PieceTable::getPieceText(const Piece &P) const {
+  return StringRef(P.IsAdded ? Added : Original).substr(P.Start, P.Length);
+}
+
+size_t PieceTable::getOffset(unsigned Line, unsigned Column) const {
+  // Find the piece the line starts in, and the start of the line in it.
+  size_t I = 0, E = Pieces.size();
+  size_t PieceStart = 0;
+  size_t PosInPiece = 0;
+  size_t LinesLeft = Line;
+  for (; I != E; ++I) {
+    const Piece &P = Pieces[I];
+    if (LinesLeft > P.Newlines) {
+      LinesLeft -= P.Newlines;
+      PieceStart += P.Length;
+      continue;
+    }
+    // The line starts after the LinesLeft-th newline of this piece.
+    StringRef Text = getPieceText(P);
+    // Starts at npos, so that the first search starts at position 0.
+    size_t NewlinePos = StringRef::npos;
+    for (; LinesLeft != 0; --LinesLeft)
+      NewlinePos = Text.find('\n', NewlinePos + 1);
+    PosInPiece = NewlinePos + 1;
+    break;
+  }
+  if (I == E)
+    return Size;
+
+  // Columns past the end of the line map to its newline. Only the first
+  // Column bytes of the line are searched for it.
+  size_t Offset = PieceStart + PosInPiece;
+  size_t ColumnsLeft = Column;
+  for (; I != E; ++I) {
+    StringRef Text = getPieceText(Pieces[I]).substr(PosInPiece);
+    size_t LineEnd = Text.substr(0, ColumnsLeft).find('\n');
+    if (LineEnd != StringRef::npos)
+      return Offset + LineEnd;
+    if (ColumnsLeft <= Text.size())
+      return Offset + ColumnsLeft;
+    Offset += Text.size();
+    ColumnsLeft -= Text.size();
+    PosInPiece = 0;
+  }
+  return Size;
+}
+
+size_t PieceTable::splitAt(size_t Offset) {
+  size_t PieceStart = 0;
+  for (size_t I = 0, E = Pieces.size(); I != E; ++I) {
+    Piece &P = Pieces[I];
+    if (Offset == PieceStart)
+      return I;
+    if (Offset < PieceStart + P.Length) {
+      // Only count the newlines of the shorter half.
+      size_t SplitPos = Offset - PieceStart;
+      StringRef Text = getPieceText(P);
+      size_t HeadNewlines;
+      if (SplitPos < P.Length - SplitPos)
+        HeadNewlines = Text.substr(0, SplitPos).count('\n');
+      else
+        HeadNewlines = P.Newlines - Text.substr(SplitPos).count('\n');
+
+      Piece Tail = {P.IsAdded, P.Start + SplitPos, P.Length - SplitPos,
+                    P.Newlines - HeadNewlines};
+      P.Length = SplitPos;
+      P.Newlines = HeadNewlines;
+      Pieces.insert(Pieces.begin() + I + 1, Tail);
+      return I + 1;
+    }
+    PieceStart += P.Length;
+  }
+  assert(Offset == Size && "Offset is out of range");
+  return Pieces.size();
+}
+
+void PieceTable::replace(size_t Offset, size_t Length, StringRef Text) {
+  Offset = std::min(Offset, Size);
+  Length = std::min(Length, Size - Offset);
+
+  size_t First = splitAt(Offset);
+  size_t Last = splitAt(Offset + Length);
+  Pieces.erase(Pieces.begin() + First, Pieces.begin() + Last);
+  if (!Text.empty()) {
+    size_t Newlines = Text.count('\n');
+    Piece *Prev = First != 0 ? &Pieces[First - 1] : nullptr;
+    if (Prev && Prev->IsAdded && Prev->Start + Prev->Length == Added.size()) {
+      // Typing appends to the text inserted by the previous edit, extend its
+      // piece instead of adding a new one.
+      Prev->Length += Text.size();
+      Prev->Newlines += Newlines;
+    } else {
+      Pieces.insert(Pieces.begin() + First,
+                    {/*IsAdded=*/true, Added.size(), Text.size(), Newlines});
+    }
+    Added.append(Text.begin(), Text.end());
+  }
+  Size = Size - Length + Text.size();
+
+  // Also compact if most of the buffers are no longer referenced.
+  if (Pieces.size() > MaxPieces ||
+      Original.size() + Added.size() > 4 * Size + MaxPieces)
+    compact();
+}
+
+std::string PieceTable::getText() const {
+  std::string Result;
+  Result.reserve(Size);
+  for (const Piece &P : Pieces) {
+    StringRef Text = getPieceText(P);
+    Result.append(Text.begin(), Text.end());
+  }
+  return Result;
+}
+
+void PieceTable::compact() {
+  *this = PieceTable(getText());
+}
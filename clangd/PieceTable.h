@@ -0,0 +1,78 @@
+//===--- PieceTable.h - Editable text buffer --------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// A piece table stores a text as a sequence of pieces, each referencing a
+// range of either the original text or an append-only buffer of inserted text.
+// Replacing a range of the text only splits the pieces around it and appends
+// the new text, so the cost of an edit does not depend on the size of the
+// text.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_TOOLS_EXTRA_CLANGD_PIECETABLE_H
+#define LLVM_CLANG_TOOLS_EXTRA_CLANGD_PIECETABLE_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/StringRef.h"
+#include <string>
+#include <vector>
+
+namespace clang {
+namespace clangd {
+
+class PieceTable {
+public:
+  explicit PieceTable(std::string Text = "");
+
+  /// The size of the text in bytes.
+  size_t size() const { return Size; }
+
+  /// Returns the offset of the zero-based \p Line and \p Column in the text.
+  /// Columns past the end of a line map to the end of the line, lines past the
+  /// end of the text map to the end of the text.
+  // FIXME: \r\n
+  // FIXME: UTF-8
+  size_t getOffset(unsigned Line, unsigned Column) const;
+
+  /// Replaces \p Length bytes starting at \p Offset with \p Text. The range is
+  /// clamped to the end of the text.
+  void replace(size_t Offset, size_t Length, StringRef Text);
+
+  /// Returns a copy of the whole text.
+  std::string getText() const;
+
+private:
+  struct Piece {
+    /// True if the piece references Added, false if it references Original.
+    bool IsAdded;
+    size_t Start;
+    size_t Length;
+    /// The number of newlines in the piece.
+    size_t Newlines;
+  };
+
+  StringRef getPieceText(const Piece &P) const;
+  /// Splits the piece containing \p Offset, so that a piece starts at
+  /// \p Offset. Returns the index of that piece, or Pieces.size() if \p Offset
+  /// is the end of the text.
+  size_t splitAt(size_t Offset);
+  /// Replaces all pieces by a single piece referencing a copy of the text.
+  void compact();
+
+  std::string Original;
+  /// Text inserted by replace(). Only ever appended to.
+  std::string Added;
+  std::vector<Piece> Pieces;
+  size_t Size;
+};
+
+} // namespace clangd
+} // namespace clang
+
+#endif
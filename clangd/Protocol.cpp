@@ -46,9 +46,8 @@ URI URI::fromFile(llvm::StringRef file) {
   return Result;
 }
 
-URI URI::parse(llvm::yaml::ScalarNode *Param) {
-  llvm::SmallString<10> Storage;
-  return URI::fromUri(Param->getValue(Storage));
+URI URI::parse(const json::StringNode *Param) {
+  return URI::fromUri(Param->getValue());
 }
 
 std::string URI::unparse(const URI &U) {
@@ -56,21 +55,15 @@ std::string URI::unparse(const URI &U) {
 }
 
 llvm::Optional<TextDocumentIdentifier>
-TextDocumentIdentifier::parse(llvm::yaml::MappingNode *Params) {
+TextDocumentIdentifier::parse(const json::ObjectNode *Params) {
   TextDocumentIdentifier Result;
-  for (auto &NextKeyValue : *Params) {
-    auto *KeyString = dyn_cast<llvm::yaml::ScalarNode>(NextKeyValue.getKey());
-    if (!KeyString)
-      return llvm::None;
-
-    llvm::SmallString<10> KeyStorage;
-    StringRef KeyValue = KeyString->getValue(KeyStorage);
-    auto *Value =
-        dyn_cast_or_null<llvm::yaml::ScalarNode>(NextKeyValue.getValue());
-    if (!Value)
-      return llvm::None;
+  for (const auto &NextKeyValue : *Params) {
+    StringRef KeyValue = NextKeyValue.Key;
 
     if (KeyValue == "uri") {
+      auto *Value = dyn_cast<json::StringNode>(NextKeyValue.Value);
+      if (!Value)
+        return llvm::None;
       Result.uri = URI::parse(Value);
     } else if (KeyValue == "version") {
       // FIXME: parse version, but only for VersionedTextDocumentIdentifiers.
@@ -81,29 +74,22 @@ TextDocumentIdentifier::parse(llvm::yaml::MappingNode *Params) {
   return Result;
 }
 
-llvm::Optional<Position> Position::parse(llvm::yaml::MappingNode *Params) {
+llvm::Optional<Position> Position::parse(const json::ObjectNode *Params) {
   Position Result;
-  for (auto &NextKeyValue : *Params) {
-    auto *KeyString = dyn_cast<llvm::yaml::ScalarNode>(NextKeyValue.getKey());
-    if (!KeyString)
-      return llvm::None;
-
-    llvm::SmallString<10> KeyStorage;
-    StringRef KeyValue = KeyString->getValue(KeyStorage);
-    auto *Value =
-        dyn_cast_or_null<llvm::yaml::ScalarNode>(NextKeyValue.getValue());
+  for (const auto &NextKeyValue : *Params) {
+    StringRef KeyValue = NextKeyValue.Key;
+    auto *Value = dyn_cast<json::NumberNode>(NextKeyValue.Value);
     if (!Value)
       return llvm::None;
 
-    llvm::SmallString<10> Storage;
     if (KeyValue == "line") {
       long long Val;
-      if (llvm::getAsSignedInteger(Value->getValue(Storage), 0, Val))
+      if (Value->getAsInteger(Val))
         return llvm::None;
       Result.line = Val;
     } else if (KeyValue == "character") {
       long long Val;
-      if (llvm::getAsSignedInteger(Value->getValue(Storage), 0, Val))
+      if (Value->getAsInteger(Val))
         return llvm::None;
       Result.character = Val;
     } else {
@@ -120,21 +106,23 @@ std::string Position::unparse(const Position &P) {
   return Result;
 }
 
-llvm::Optional<Range> Range::parse(llvm::yaml::MappingNode *Params) {
-  Range Result;
-  for (auto &NextKeyValue : *Params) {
-    auto *KeyString = dyn_cast<llvm::yaml::ScalarNode>(NextKeyValue.getKey());
-    if (!KeyString)
-      return llvm::None;
+void Position::unparse(json::Writer &W, const Position &P) {
+  W.objectBegin();
+  W.key("line");
+  W.value(P.line);
+  W.key("character");
+  W.value(P.character);
+  W.objectEnd();
+}
 
-    llvm::SmallString<10> KeyStorage;
-    StringRef KeyValue = KeyString->getValue(KeyStorage);
-    auto *Value =
-        dyn_cast_or_null<llvm::yaml::MappingNode>(NextKeyValue.getValue());
+llvm::Optional<Range> Range::parse(const json::ObjectNode *Params) {
+  Range Result;
+  for (const auto &NextKeyValue : *Params) {
+    StringRef KeyValue = NextKeyValue.Key;
+    auto *Value = dyn_cast<json::ObjectNode>(NextKeyValue.Value);
     if (!Value)
       return llvm::None;
 
-    llvm::SmallString<10> Storage;
     if (KeyValue == "start") {
       auto Parsed = Position::parse(Value);
       if (!Parsed)
@@ -160,33 +148,39 @@ std::string Range::unparse(const Range &P) {
   return Result;
 }
 
+void Range::unparse(json::Writer &W, const Range &P) {
+  W.objectBegin();
+  W.key("start");
+  Position::unparse(W, P.start);
+  W.key("end");
+  Position::unparse(W, P.end);
+  W.objectEnd();
+}
+
 llvm::Optional<TextDocumentItem>
-TextDocumentItem::parse(llvm::yaml::MappingNode *Params) {
+TextDocumentItem::parse(const json::ObjectNode *Params) {
   TextDocumentItem Result;
-  for (auto &NextKeyValue : *Params) {
-    auto *KeyString = dyn_cast<llvm::yaml::ScalarNode>(NextKeyValue.getKey());
-    if (!KeyString)
-      return llvm::None;
+  for (const auto &NextKeyValue : *Params) {
+    StringRef KeyValue = NextKeyValue.Key;
 
-    llvm::SmallString<10> KeyStorage;
-    StringRef KeyValue = KeyString->getValue(KeyStorage);
-    auto *Value =
-        dyn_cast_or_null<llvm::yaml::ScalarNode>(NextKeyValue.getValue());
+    if (KeyValue == "version") {
+      auto *Value = dyn_cast<json::NumberNode>(NextKeyValue.Value);
+      long long Val;
+      if (!Value || Value->getAsInteger(Val))
+        return llvm::None;
+      Result.version = Val;
+      continue;
+    }
+
+    auto *Value = dyn_cast<json::StringNode>(NextKeyValue.Value);
     if (!Value)
       return llvm::None;
-
-    llvm::SmallString<10> Storage;
     if (KeyValue == "uri") {
       Result.uri = URI::parse(Value);
     } else if (KeyValue == "languageId") {
-      Result.languageId = Value->getValue(Storage);
-    } else if (KeyValue == "version") {
-      long long Val;
-      if (llvm::getAsSignedInteger(Value->getValue(Storage), 0, Val))
-        return llvm::None;
-      Result.version = Val;
+      Result.languageId = Value->getValue();
     } else if (KeyValue == "text") {
-      Result.text = Value->getValue(Storage);
+      Result.text = Value->getValue();
     } else {
       return llvm::None;
     }
@@ -194,20 +188,14 @@ TextDocumentItem::parse(llvm::yaml::MappingNode *Params) {
   return Result;
 }
 
-llvm::Optional<TextEdit> TextEdit::parse(llvm::yaml::MappingNode *Params) {
+llvm::Optional<TextEdit> TextEdit::parse(const json::ObjectNode *Params) {
   TextEdit Result;
-  for (auto &NextKeyValue : *Params) {
-    auto *KeyString = dyn_cast<llvm::yaml::ScalarNode>(NextKeyValue.getKey());
-    if (!KeyString)
-      return llvm::None;
+  for (const auto &NextKeyValue : *Params) {
+    StringRef KeyValue = NextKeyValue.Key;
+    const json::Node *Value = NextKeyValue.Value;
 
-    llvm::SmallString<10> KeyStorage;
-    StringRef KeyValue = KeyString->getValue(KeyStorage);
-    auto *Value = NextKeyValue.getValue();
-
-    llvm::SmallString<10> Storage;
     if (KeyValue == "range") {
-      auto *Map = dyn_cast<llvm::yaml::MappingNode>(Value);
+      auto *Map = dyn_cast<json::ObjectNode>(Value);
       if (!Map)
         return llvm::None;
       auto Parsed = Range::parse(Map);
@@ -215,10 +203,10 @@ llvm::Optional<TextEdit> TextEdit::parse(llvm::yaml::MappingNode *Params) {
         return llvm::None;
       Result.range = std::move(*Parsed);
     } else if (KeyValue == "newText") {
-      auto *Node = dyn_cast<llvm::yaml::ScalarNode>(Value);
+      auto *Node = dyn_cast<json::StringNode>(Value);
       if (!Node)
         return llvm::None;
-      Result.newText = Node->getValue(Storage);
+      Result.newText = Node->getValue();
     } else {
       return llvm::None;
     }
@@ -235,21 +223,14 @@ std::string TextEdit::unparse(const TextEdit &P) {
 }
 
 llvm::Optional<DidOpenTextDocumentParams>
-DidOpenTextDocumentParams::parse(llvm::yaml::MappingNode *Params) {
+DidOpenTextDocumentParams::parse(const json::ObjectNode *Params) {
   DidOpenTextDocumentParams Result;
-  for (auto &NextKeyValue : *Params) {
-    auto *KeyString = dyn_cast<llvm::yaml::ScalarNode>(NextKeyValue.getKey());
-    if (!KeyString)
-      return llvm::None;
-
-    llvm::SmallString<10> KeyStorage;
-    StringRef KeyValue = KeyString->getValue(KeyStorage);
-    auto *Value =
-        dyn_cast_or_null<llvm::yaml::MappingNode>(NextKeyValue.getValue());
+  for (const auto &NextKeyValue : *Params) {
+    StringRef KeyValue = NextKeyValue.Key;
+    auto *Value = dyn_cast<json::ObjectNode>(NextKeyValue.Value);
     if (!Value)
       return llvm::None;
 
-    llvm::SmallString<10> Storage;
     if (KeyValue == "textDocument") {
       auto Parsed = TextDocumentItem::parse(Value);
       if (!Parsed)
@@ -263,19 +244,14 @@ DidOpenTextDocumentParams::parse(llvm::yaml::MappingNode *Params) {
 }
 
 llvm::Optional<DidCloseTextDocumentParams>
-DidCloseTextDocumentParams::parse(llvm::yaml::MappingNode *Params) {
+DidCloseTextDocumentParams::parse(const json::ObjectNode *Params) {
   DidCloseTextDocumentParams Result;
-  for (auto &NextKeyValue : *Params) {
-    auto *KeyString = dyn_cast<llvm::yaml::ScalarNode>(NextKeyValue.getKey());
-    if (!KeyString)
-      return llvm::None;
-
-    llvm::SmallString<10> KeyStorage;
-    StringRef KeyValue = KeyString->getValue(KeyStorage);
-    auto *Value = NextKeyValue.getValue();
+  for (const auto &NextKeyValue : *Params) {
+    StringRef KeyValue = NextKeyValue.Key;
+    const json::Node *Value = NextKeyValue.Value;
 
     if (KeyValue == "textDocument") {
-      auto *Map = dyn_cast<llvm::yaml::MappingNode>(Value);
+      auto *Map = dyn_cast<json::ObjectNode>(Value);
       if (!Map)
         return llvm::None;
       auto Parsed = TextDocumentIdentifier::parse(Map);
@@ -290,20 +266,14 @@ DidCloseTextDocumentParams::parse(llvm::yaml::MappingNode *Params) {
 }
 
 llvm::Optional<DidChangeTextDocumentParams>
-DidChangeTextDocumentParams::parse(llvm::yaml::MappingNode *Params) {
+DidChangeTextDocumentParams::parse(const json::ObjectNode *Params) {
   DidChangeTextDocumentParams Result;
-  for (auto &NextKeyValue : *Params) {
-    auto *KeyString = dyn_cast<llvm::yaml::ScalarNode>(NextKeyValue.getKey());
-    if (!KeyString)
-      return llvm::None;
+  for (const auto &NextKeyValue : *Params) {
+    StringRef KeyValue = NextKeyValue.Key;
+    const json::Node *Value = NextKeyValue.Value;
 
-    llvm::SmallString<10> KeyStorage;
-    StringRef KeyValue = KeyString->getValue(KeyStorage);
-    auto *Value = NextKeyValue.getValue();
-
-    llvm::SmallString<10> Storage;
     if (KeyValue == "textDocument") {
-      auto *Map = dyn_cast<llvm::yaml::MappingNode>(Value);
+      auto *Map = dyn_cast<json::ObjectNode>(Value);
       if (!Map)
         return llvm::None;
       auto Parsed = TextDocumentIdentifier::parse(Map);
@@ -311,11 +281,11 @@ DidChangeTextDocumentParams::parse(llvm::yaml::MappingNode *Params) {
         return llvm::None;
       Result.textDocument = std::move(*Parsed);
     } else if (KeyValue == "contentChanges") {
-      auto *Seq = dyn_cast<llvm::yaml::SequenceNode>(Value);
+      auto *Seq = dyn_cast<json::ArrayNode>(Value);
       if (!Seq)
         return llvm::None;
-      for (auto &Item : *Seq) {
-        auto *I = dyn_cast<llvm::yaml::MappingNode>(&Item);
+      for (const json::Node *Item : *Seq) {
+        auto *I = dyn_cast<json::ObjectNode>(Item);
         if (!I)
           return llvm::None;
         auto Parsed = TextDocumentContentChangeEvent::parse(I);
@@ -331,23 +301,31 @@ DidChangeTextDocumentParams::parse(llvm::yaml::MappingNode *Params) {
 }
 
 llvm::Optional<TextDocumentContentChangeEvent>
-TextDocumentContentChangeEvent::parse(llvm::yaml::MappingNode *Params) {
+TextDocumentContentChangeEvent::parse(const json::ObjectNode *Params) {
   TextDocumentContentChangeEvent Result;
-  for (auto &NextKeyValue : *Params) {
-    auto *KeyString = dyn_cast<llvm::yaml::ScalarNode>(NextKeyValue.getKey());
-    if (!KeyString)
-      return llvm::None;
+  for (const auto &NextKeyValue : *Params) {
+    StringRef KeyValue = NextKeyValue.Key;
+    const json::Node *Value = NextKeyValue.Value;
 
-    llvm::SmallString<10> KeyStorage;
-    StringRef KeyValue = KeyString->getValue(KeyStorage);
-    auto *Value =
-        dyn_cast_or_null<llvm::yaml::ScalarNode>(NextKeyValue.getValue());
-    if (!Value)
-      return llvm::None;
-
-    llvm::SmallString<10> Storage;
-    if (KeyValue == "text") {
-      Result.text = Value->getValue(Storage);
+    if (KeyValue == "range") {
+      auto *Map = dyn_cast<json::ObjectNode>(Value);
+      if (!Map)
+        return llvm::None;
+      auto Parsed = Range::parse(Map);
+      if (!Parsed)
+        return llvm::None;
+      Result.range = std::move(*Parsed);
+    } else if (KeyValue == "rangeLength") {
+      auto *Number = dyn_cast<json::NumberNode>(Value);
+      long long Val;
+      if (!Number || Number->getAsInteger(Val))
+        return llvm::None;
+      Result.rangeLength = Val;
+    } else if (KeyValue == "text") {
+      auto *String = dyn_cast<json::StringNode>(Value);
+      if (!String)
+        return llvm::None;
+      Result.text = String->getValue();
     } else {
       return llvm::None;
     }
@@ -356,35 +334,28 @@ TextDocumentContentChangeEvent::parse(llvm::yaml::MappingNode *Params) {
 }
 
 llvm::Optional<FormattingOptions>
-FormattingOptions::parse(llvm::yaml::MappingNode *Params) {
+FormattingOptions::parse(const json::ObjectNode *Params) {
   FormattingOptions Result;
-  for (auto &NextKeyValue : *Params) {
-    auto *KeyString = dyn_cast<llvm::yaml::ScalarNode>(NextKeyValue.getKey());
-    if (!KeyString)
-      return llvm::None;
-
-    llvm::SmallString<10> KeyStorage;
-    StringRef KeyValue = KeyString->getValue(KeyStorage);
-    auto *Value =
-        dyn_cast_or_null<llvm::yaml::ScalarNode>(NextKeyValue.getValue());
-    if (!Value)
-      return llvm::None;
+  for (const auto &NextKeyValue : *Params) {
+    StringRef KeyValue = NextKeyValue.Key;
+    const json::Node *Value = NextKeyValue.Value;
 
-    llvm::SmallString<10> Storage;
     if (KeyValue == "tabSize") {
+      auto *Number = dyn_cast<json::NumberNode>(Value);
       long long Val;
-      if (llvm::getAsSignedInteger(Value->getValue(Storage), 0, Val))
+      if (!Number || Number->getAsInteger(Val))
         return llvm::None;
       Result.tabSize = Val;
     } else if (KeyValue == "insertSpaces") {
+      // Accept both booleans and integers.
       long long Val;
-      StringRef Str = Value->getValue(Storage);
-      if (llvm::getAsSignedInteger(Str, 0, Val)) {
-        if (Str == "true")
-          Val = 1;
-        else if (Str == "false")
-          Val = 0;
-        else
+      if (auto *Literal = dyn_cast<json::LiteralNode>(Value)) {
+        if (Literal->isNull())
+          return llvm::None;
+        Val = Literal->getValue();
+      } else {
+        auto *Number = dyn_cast<json::NumberNode>(Value);
+        if (!Number || Number->getAsInteger(Val))
           return llvm::None;
       }
       Result.insertSpaces = Val;
@@ -403,21 +374,14 @@ std::string FormattingOptions::unparse(const FormattingOptions &P) {
 }
 
 llvm::Optional<DocumentRangeFormattingParams>
-DocumentRangeFormattingParams::parse(llvm::yaml::MappingNode *Params) {
+DocumentRangeFormattingParams::parse(const json::ObjectNode *Params) {
   DocumentRangeFormattingParams Result;
-  for (auto &NextKeyValue : *Params) {
-    auto *KeyString = dyn_cast<llvm::yaml::ScalarNode>(NextKeyValue.getKey());
-    if (!KeyString)
-      return llvm::None;
-
-    llvm::SmallString<10> KeyStorage;
-    StringRef KeyValue = KeyString->getValue(KeyStorage);
-    auto *Value =
-        dyn_cast_or_null<llvm::yaml::MappingNode>(NextKeyValue.getValue());
+  for (const auto &NextKeyValue : *Params) {
+    StringRef KeyValue = NextKeyValue.Key;
+    auto *Value = dyn_cast<json::ObjectNode>(NextKeyValue.Value);
     if (!Value)
       return llvm::None;
 
-    llvm::SmallString<10> Storage;
     if (KeyValue == "textDocument") {
       auto Parsed = TextDocumentIdentifier::parse(Value);
       if (!Parsed)
@@ -441,28 +405,20 @@ DocumentRangeFormattingParams::parse(llvm::yaml::MappingNode *Params) {
 }
 
 llvm::Optional<DocumentOnTypeFormattingParams>
-DocumentOnTypeFormattingParams::parse(llvm::yaml::MappingNode *Params) {
+DocumentOnTypeFormattingParams::parse(const json::ObjectNode *Params) {
   DocumentOnTypeFormattingParams Result;
-  for (auto &NextKeyValue : *Params) {
-    auto *KeyString = dyn_cast<llvm::yaml::ScalarNode>(NextKeyValue.getKey());
-    if (!KeyString)
-      return llvm::None;
-
-    llvm::SmallString<10> KeyStorage;
-    StringRef KeyValue = KeyString->getValue(KeyStorage);
+  for (const auto &NextKeyValue : *Params) {
+    StringRef KeyValue = NextKeyValue.Key;
 
     if (KeyValue == "ch") {
-      auto *ScalarValue =
-          dyn_cast_or_null<llvm::yaml::ScalarNode>(NextKeyValue.getValue());
-      if (!ScalarValue)
+      auto *StringValue = dyn_cast<json::StringNode>(NextKeyValue.Value);
+      if (!StringValue)
         return llvm::None;
-      llvm::SmallString<10> Storage;
-      Result.ch = ScalarValue->getValue(Storage);
+      Result.ch = StringValue->getValue();
       continue;
     }
 
-    auto *Value =
-        dyn_cast_or_null<llvm::yaml::MappingNode>(NextKeyValue.getValue());
+    auto *Value = dyn_cast<json::ObjectNode>(NextKeyValue.Value);
     if (!Value)
       return llvm::None;
     if (KeyValue == "textDocument") {
@@ -488,21 +444,14 @@ DocumentOnTypeFormattingParams::parse(llvm::yaml::MappingNode *Params) {
 }
 
 llvm::Optional<DocumentFormattingParams>
-DocumentFormattingParams::parse(llvm::yaml::MappingNode *Params) {
+DocumentFormattingParams::parse(const json::ObjectNode *Params) {
   DocumentFormattingParams Result;
-  for (auto &NextKeyValue : *Params) {
-    auto *KeyString = dyn_cast<llvm::yaml::ScalarNode>(NextKeyValue.getKey());
-    if (!KeyString)
-      return llvm::None;
-
-    llvm::SmallString<10> KeyStorage;
-    StringRef KeyValue = KeyString->getValue(KeyStorage);
-    auto *Value =
-        dyn_cast_or_null<llvm::yaml::MappingNode>(NextKeyValue.getValue());
+  for (const auto &NextKeyValue : *Params) {
+    StringRef KeyValue = NextKeyValue.Key;
+    auto *Value = dyn_cast<json::ObjectNode>(NextKeyValue.Value);
     if (!Value)
       return llvm::None;
 
-    llvm::SmallString<10> Storage;
     if (KeyValue == "textDocument") {
       auto Parsed = TextDocumentIdentifier::parse(Value);
       if (!Parsed)
@@ -520,20 +469,13 @@ DocumentFormattingParams::parse(llvm::yaml::MappingNode *Params) {
   return Result;
 }
 
-llvm::Optional<Diagnostic> Diagnostic::parse(llvm::yaml::MappingNode *Params) {
+llvm::Optional<Diagnostic> Diagnostic::parse(const json::ObjectNode *Params) {
   Diagnostic Result;
-  for (auto &NextKeyValue : *Params) {
-    auto *KeyString = dyn_cast<llvm::yaml::ScalarNode>(NextKeyValue.getKey());
-    if (!KeyString)
-      return llvm::None;
-
-    llvm::SmallString<10> KeyStorage;
-    StringRef KeyValue = KeyString->getValue(KeyStorage);
+  for (const auto &NextKeyValue : *Params) {
+    StringRef KeyValue = NextKeyValue.Key;
 
-    llvm::SmallString<10> Storage;
     if (KeyValue == "range") {
-      auto *Value =
-          dyn_cast_or_null<llvm::yaml::MappingNode>(NextKeyValue.getValue());
+      auto *Value = dyn_cast<json::ObjectNode>(NextKeyValue.Value);
       if (!Value)
         return llvm::None;
       auto Parsed = Range::parse(Value);
@@ -541,20 +483,16 @@ llvm::Optional<Diagnostic> Diagnostic::parse(llvm::yaml::MappingNode *Params) {
         return llvm::None;
       Result.range = std::move(*Parsed);
     } else if (KeyValue == "severity") {
-      auto *Value =
-          dyn_cast_or_null<llvm::yaml::ScalarNode>(NextKeyValue.getValue());
-      if (!Value)
-        return llvm::None;
+      auto *Value = dyn_cast<json::NumberNode>(NextKeyValue.Value);
       long long Val;
-      if (llvm::getAsSignedInteger(Value->getValue(Storage), 0, Val))
+      if (!Value || Value->getAsInteger(Val))
         return llvm::None;
       Result.severity = Val;
     } else if (KeyValue == "message") {
-      auto *Value =
-          dyn_cast_or_null<llvm::yaml::ScalarNode>(NextKeyValue.getValue());
+      auto *Value = dyn_cast<json::StringNode>(NextKeyValue.Value);
       if (!Value)
         return llvm::None;
-      Result.message = Value->getValue(Storage);
+      Result.message = Value->getValue();
     } else {
       return llvm::None;
     }
@@ -563,24 +501,18 @@ llvm::Optional<Diagnostic> Diagnostic::parse(llvm::yaml::MappingNode *Params) {
 }
 
 llvm::Optional<CodeActionContext>
-CodeActionContext::parse(llvm::yaml::MappingNode *Params) {
+CodeActionContext::parse(const json::ObjectNode *Params) {
   CodeActionContext Result;
-  for (auto &NextKeyValue : *Params) {
-    auto *KeyString = dyn_cast<llvm::yaml::ScalarNode>(NextKeyValue.getKey());
-    if (!KeyString)
-      return llvm::None;
-
-    llvm::SmallString<10> KeyStorage;
-    StringRef KeyValue = KeyString->getValue(KeyStorage);
-    auto *Value = NextKeyValue.getValue();
+  for (const auto &NextKeyValue : *Params) {
+    StringRef KeyValue = NextKeyValue.Key;
+    const json::Node *Value = NextKeyValue.Value;
 
-    llvm::SmallString<10> Storage;
     if (KeyValue == "diagnostics") {
-      auto *Seq = dyn_cast<llvm::yaml::SequenceNode>(Value);
+      auto *Seq = dyn_cast<json::ArrayNode>(Value);
       if (!Seq)
         return llvm::None;
-      for (auto &Item : *Seq) {
-        auto *I = dyn_cast<llvm::yaml::MappingNode>(&Item);
+      for (const json::Node *Item : *Seq) {
+        auto *I = dyn_cast<json::ObjectNode>(Item);
         if (!I)
           return llvm::None;
         auto Parsed = Diagnostic::parse(I);
@@ -596,21 +528,14 @@ CodeActionContext::parse(llvm::yaml::MappingNode *Params) {
 }
 
 llvm::Optional<CodeActionParams>
-CodeActionParams::parse(llvm::yaml::MappingNode *Params) {
+CodeActionParams::parse(const json::ObjectNode *Params) {
   CodeActionParams Result;
-  for (auto &NextKeyValue : *Params) {
-    auto *KeyString = dyn_cast<llvm::yaml::ScalarNode>(NextKeyValue.getKey());
-    if (!KeyString)
-      return llvm::None;
-
-    llvm::SmallString<10> KeyStorage;
-    StringRef KeyValue = KeyString->getValue(KeyStorage);
-    auto *Value =
-        dyn_cast_or_null<llvm::yaml::MappingNode>(NextKeyValue.getValue());
+  for (const auto &NextKeyValue : *Params) {
+    StringRef KeyValue = NextKeyValue.Key;
+    auto *Value = dyn_cast<json::ObjectNode>(NextKeyValue.Value);
     if (!Value)
       return llvm::None;
 
-    llvm::SmallString<10> Storage;
     if (KeyValue == "textDocument") {
       auto Parsed = TextDocumentIdentifier::parse(Value);
       if (!Parsed)
@@ -634,21 +559,14 @@ CodeActionParams::parse(llvm::yaml::MappingNode *Params) {
 }
 
 llvm::Optional<TextDocumentPositionParams>
-TextDocumentPositionParams::parse(llvm::yaml::MappingNode *Params) {
+TextDocumentPositionParams::parse(const json::ObjectNode *Params) {
   TextDocumentPositionParams Result;
-  for (auto &NextKeyValue : *Params) {
-    auto *KeyString = dyn_cast<llvm::yaml::ScalarNode>(NextKeyValue.getKey());
-    if (!KeyString)
-      return llvm::None;
-
-    llvm::SmallString<10> KeyStorage;
-    StringRef KeyValue = KeyString->getValue(KeyStorage);
-    auto *Value =
-        dyn_cast_or_null<llvm::yaml::MappingNode>(NextKeyValue.getValue());
+  for (const auto &NextKeyValue : *Params) {
+    StringRef KeyValue = NextKeyValue.Key;
+    auto *Value = dyn_cast<json::ObjectNode>(NextKeyValue.Value);
     if (!Value)
       return llvm::None;
 
-    llvm::SmallString<10> Storage;
     if (KeyValue == "textDocument") {
       auto Parsed = TextDocumentIdentifier::parse(Value);
       if (!Parsed)
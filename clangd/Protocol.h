@@ -21,6 +21,8 @@
 #ifndef LLVM_CLANG_TOOLS_EXTRA_CLANGD_PROTOCOL_H
 #define LLVM_CLANG_TOOLS_EXTRA_CLANGD_PROTOCOL_H
 
+#include "JSONParser.h"
+#include "JSONWriter.h"
 #include "llvm/ADT/Optional.h"
 #include "llvm/Support/YAMLParser.h"
 #include <string>
@@ -36,7 +38,7 @@ struct URI {
   static URI fromUri(llvm::StringRef uri);
   static URI fromFile(llvm::StringRef file);
 
-  static URI parse(llvm::yaml::ScalarNode *Param);
+  static URI parse(const json::StringNode *Param);
   static std::string unparse(const URI &U);
 };
 
@@ -45,7 +47,7 @@ struct TextDocumentIdentifier {
   URI uri;
 
   static llvm::Optional<TextDocumentIdentifier>
-  parse(llvm::yaml::MappingNode *Params);
+  parse(const json::ObjectNode *Params);
 };
 
 struct Position {
@@ -64,8 +66,9 @@ struct Position {
            std::tie(RHS.line, RHS.character);
   }
 
-  static llvm::Optional<Position> parse(llvm::yaml::MappingNode *Params);
+  static llvm::Optional<Position> parse(const json::ObjectNode *Params);
   static std::string unparse(const Position &P);
+  static void unparse(json::Writer &W, const Position &P);
 };
 
 struct Range {
@@ -82,8 +85,9 @@ struct Range {
     return std::tie(LHS.start, LHS.end) < std::tie(RHS.start, RHS.end);
   }
 
-  static llvm::Optional<Range> parse(llvm::yaml::MappingNode *Params);
+  static llvm::Optional<Range> parse(const json::ObjectNode *Params);
   static std::string unparse(const Range &P);
+  static void unparse(json::Writer &W, const Range &P);
 };
 
 struct TextEdit {
@@ -95,7 +99,7 @@ struct TextEdit {
   /// empty string.
   std::string newText;
 
-  static llvm::Optional<TextEdit> parse(llvm::yaml::MappingNode *Params);
+  static llvm::Optional<TextEdit> parse(const json::ObjectNode *Params);
   static std::string unparse(const TextEdit &P);
 };
 
@@ -113,7 +117,7 @@ struct TextDocumentItem {
   std::string text;
 
   static llvm::Optional<TextDocumentItem>
-  parse(llvm::yaml::MappingNode *Params);
+  parse(const json::ObjectNode *Params);
 };
 
 struct DidOpenTextDocumentParams {
@@ -121,7 +125,7 @@ struct DidOpenTextDocumentParams {
   TextDocumentItem textDocument;
 
   static llvm::Optional<DidOpenTextDocumentParams>
-  parse(llvm::yaml::MappingNode *Params);
+  parse(const json::ObjectNode *Params);
 };
 
 struct DidCloseTextDocumentParams {
@@ -129,15 +133,23 @@ struct DidCloseTextDocumentParams {
   TextDocumentIdentifier textDocument;
 
   static llvm::Optional<DidCloseTextDocumentParams>
-  parse(llvm::yaml::MappingNode *Params);
+  parse(const json::ObjectNode *Params);
 };
 
 struct TextDocumentContentChangeEvent {
-  /// The new text of the document.
+  /// The range of the document that changed. If omitted, the whole document
+  /// is replaced by text.
+  llvm::Optional<Range> range;
+
+  /// The length of the range that got replaced. Only informational, range is
+  /// used to apply the change.
+  llvm::Optional<int> rangeLength;
+
+  /// The new text of the range, or of the whole document if range is omitted.
   std::string text;
 
   static llvm::Optional<TextDocumentContentChangeEvent>
-  parse(llvm::yaml::MappingNode *Params);
+  parse(const json::ObjectNode *Params);
 };
 
 struct DidChangeTextDocumentParams {
@@ -150,7 +162,7 @@ struct DidChangeTextDocumentParams {
   std::vector<TextDocumentContentChangeEvent> contentChanges;
 
   static llvm::Optional<DidChangeTextDocumentParams>
-  parse(llvm::yaml::MappingNode *Params);
+  parse(const json::ObjectNode *Params);
 };
 
 struct FormattingOptions {
@@ -161,7 +173,7 @@ struct FormattingOptions {
   bool insertSpaces;
 
   static llvm::Optional<FormattingOptions>
-  parse(llvm::yaml::MappingNode *Params);
+  parse(const json::ObjectNode *Params);
   static std::string unparse(const FormattingOptions &P);
 };
 
@@ -176,7 +188,7 @@ struct DocumentRangeFormattingParams {
   FormattingOptions options;
 
   static llvm::Optional<DocumentRangeFormattingParams>
-  parse(llvm::yaml::MappingNode *Params);
+  parse(const json::ObjectNode *Params);
 };
 
 struct DocumentOnTypeFormattingParams {
@@ -193,7 +205,7 @@ struct DocumentOnTypeFormattingParams {
   FormattingOptions options;
 
   static llvm::Optional<DocumentOnTypeFormattingParams>
-  parse(llvm::yaml::MappingNode *Params);
+  parse(const json::ObjectNode *Params);
 };
 
 struct DocumentFormattingParams {
@@ -204,7 +216,7 @@ struct DocumentFormattingParams {
   FormattingOptions options;
 
   static llvm::Optional<DocumentFormattingParams>
-  parse(llvm::yaml::MappingNode *Params);
+  parse(const json::ObjectNode *Params);
 };
 
 struct Diagnostic {
@@ -227,7 +239,7 @@ struct Diagnostic {
            std::tie(RHS.range, RHS.severity, RHS.message);
   }
 
-  static llvm::Optional<Diagnostic> parse(llvm::yaml::MappingNode *Params);
+  static llvm::Optional<Diagnostic> parse(const json::ObjectNode *Params);
 };
 
 struct CodeActionContext {
@@ -235,7 +247,7 @@ struct CodeActionContext {
   std::vector<Diagnostic> diagnostics;
 
   static llvm::Optional<CodeActionContext>
-  parse(llvm::yaml::MappingNode *Params);
+  parse(const json::ObjectNode *Params);
 };
 
 struct CodeActionParams {
@@ -249,7 +261,7 @@ struct CodeActionParams {
   CodeActionContext context;
 
   static llvm::Optional<CodeActionParams>
-  parse(llvm::yaml::MappingNode *Params);
+  parse(const json::ObjectNode *Params);
 };
 
 struct TextDocumentPositionParams {
@@ -260,7 +272,7 @@ struct TextDocumentPositionParams {
   Position position;
 
   static llvm::Optional<TextDocumentPositionParams>
-  parse(llvm::yaml::MappingNode *Params);
+  parse(const json::ObjectNode *Params);
 };
 
 /// The kind of a completion entry.
@@ -11,24 +11,27 @@
 #include "ASTManager.h"
 #include "DocumentStore.h"
 #include "clang/Format/Format.h"
+#include "llvm/ADT/SmallString.h"
 using namespace clang;
 using namespace clangd;
 
 void TextDocumentDidOpenHandler::handleNotification(
-    llvm::yaml::MappingNode *Params) {
+    const json::ObjectNode *Params) {
   auto DOTDP = DidOpenTextDocumentParams::parse(Params);
   if (!DOTDP) {
-    Output.log("Failed to decode DidOpenTextDocumentParams!\n");
+    Output.log("Failed to decode DidOpenTextDocumentParams!\n",
+               LogLevel::Error);
     return;
   }
   Store.addDocument(DOTDP->textDocument.uri.file, DOTDP->textDocument.text);
 }
 
 void TextDocumentDidCloseHandler::handleNotification(
-    llvm::yaml::MappingNode *Params) {
+    const json::ObjectNode *Params) {
   auto DCTDP = DidCloseTextDocumentParams::parse(Params);
   if (!DCTDP) {
-    Output.log("Failed to decode DidCloseTextDocumentParams!\n");
+    Output.log("Failed to decode DidCloseTextDocumentParams!\n",
+               LogLevel::Error);
     return;
   }
 
@@ -36,14 +39,16 @@ void TextDocumentDidCloseHandler::handleNotification(
 }
 
 void TextDocumentDidChangeHandler::handleNotification(
-    llvm::yaml::MappingNode *Params) {
+    const json::ObjectNode *Params) {
   auto DCTDP = DidChangeTextDocumentParams::parse(Params);
-  if (!DCTDP || DCTDP->contentChanges.size() != 1) {
-    Output.log("Failed to decode DidChangeTextDocumentParams!\n");
+  if (!DCTDP || DCTDP->contentChanges.empty()) {
+    Output.log("Failed to decode DidChangeTextDocumentParams!\n",
+               LogLevel::Error);
     return;
   }
-  // We only support full syncing right now.
-  Store.addDocument(DCTDP->textDocument.uri.file, DCTDP->contentChanges[0].text);
+  if (!Store.changeDocument(DCTDP->textDocument.uri.file,
+                            DCTDP->contentChanges))
+    Output.log("Received didChange for a document that is not open!\n");
 }
 
 /// Turn a [line, column] pair into an offset in Code.
@@ -103,10 +108,11 @@ static std::string formatCode(StringRef Code, StringRef Filename,
 }
 
 void TextDocumentRangeFormattingHandler::handleMethod(
-    llvm::yaml::MappingNode *Params, StringRef ID) {
+    const json::ObjectNode *Params, StringRef ID) {
   auto DRFP = DocumentRangeFormattingParams::parse(Params);
   if (!DRFP) {
-    Output.log("Failed to decode DocumentRangeFormattingParams!\n");
+    Output.log("Failed to decode DocumentRangeFormattingParams!\n",
+               LogLevel::Error);
     return;
   }
 
@@ -120,10 +126,11 @@ void TextDocumentRangeFormattingHandler::handleMethod(
 }
 
 void TextDocumentOnTypeFormattingHandler::handleMethod(
-    llvm::yaml::MappingNode *Params, StringRef ID) {
+    const json::ObjectNode *Params, StringRef ID) {
   auto DOTFP = DocumentOnTypeFormattingParams::parse(Params);
   if (!DOTFP) {
-    Output.log("Failed to decode DocumentOnTypeFormattingParams!\n");
+    Output.log("Failed to decode DocumentOnTypeFormattingParams!\n",
+               LogLevel::Error);
     return;
   }
 
@@ -141,10 +148,10 @@ void TextDocumentOnTypeFormattingHandler::handleMethod(
 }
 
 void TextDocumentFormattingHandler::handleMethod(
-    llvm::yaml::MappingNode *Params, StringRef ID) {
+    const json::ObjectNode *Params, StringRef ID) {
   auto DFP = DocumentFormattingParams::parse(Params);
   if (!DFP) {
-    Output.log("Failed to decode DocumentFormattingParams!\n");
+    Output.log("Failed to decode DocumentFormattingParams!\n", LogLevel::Error);
     return;
   }
 
@@ -154,11 +161,11 @@ void TextDocumentFormattingHandler::handleMethod(
                           {clang::tooling::Range(0, Code.size())}, ID));
 }
 
-void CodeActionHandler::handleMethod(llvm::yaml::MappingNode *Params,
+void CodeActionHandler::handleMethod(const json::ObjectNode *Params,
                                      StringRef ID) {
   auto CAP = CodeActionParams::parse(Params);
   if (!CAP) {
-    Output.log("Failed to decode CodeActionParams!\n");
+    Output.log("Failed to decode CodeActionParams!\n", LogLevel::Error);
     return;
   }
 
@@ -187,11 +194,12 @@ void CodeActionHandler::handleMethod(llvm::yaml::MappingNode *Params,
       R"(]})");
 }
 
-void CompletionHandler::handleMethod(llvm::yaml::MappingNode *Params,
+void CompletionHandler::handleMethod(const json::ObjectNode *Params,
                                      StringRef ID) {
   auto TDPP = TextDocumentPositionParams::parse(Params);
   if (!TDPP) {
-    Output.log("Failed to decode TextDocumentPositionParams!\n");
+    Output.log("Failed to decode TextDocumentPositionParams!\n",
+               LogLevel::Error);
     return;
   }
 
@@ -208,3 +216,30 @@ void CompletionHandler::handleMethod(llvm::yaml::MappingNode *Params,
       R"({"jsonrpc":"2.0","id":)" + ID.str() +
       R"(,"result":[)" + Completions + R"(]})");
 }
+
+void MemoryUsageHandler::handleMethod(const json::ObjectNode *Params,
+                                      StringRef ID) {
+  ASTMemoryUsage Usage = AST.getMemoryUsage();
+  SmallString<256> Result;
+  llvm::raw_svector_ostream OS(Result);
+  json::Writer W(OS);
+  W.objectBegin();
+  W.key("budget");
+  W.value(Usage.Budget);
+  W.key("total");
+  W.value(Usage.Total);
+  W.key("files");
+  W.arrayBegin();
+  for (const auto &File : Usage.Files) {
+    W.objectBegin();
+    W.key("uri");
+    W.value(URI::fromFile(File.first).uri);
+    W.key("bytes");
+    W.value(File.second);
+    W.objectEnd();
+  }
+  W.arrayEnd();
+  W.objectEnd();
+  writeMessage(R"({"jsonrpc":"2.0","id":)" + ID + R"(,"result":)" +
+               Result.str() + "}");
+}
@@ -28,11 +28,11 @@ class DocumentStore;
 struct InitializeHandler : Handler {
   InitializeHandler(JSONOutput &Output) : Handler(Output) {}
 
-  void handleMethod(llvm::yaml::MappingNode *Params, StringRef ID) override {
+  void handleMethod(const json::ObjectNode *Params, StringRef ID) override {
     writeMessage(
         R"({"jsonrpc":"2.0","id":)" + ID +
         R"(,"result":{"capabilities":{
-          "textDocumentSync": 1,
+          "textDocumentSync": 2,
           "documentFormattingProvider": true,
           "documentRangeFormattingProvider": true,
           "documentOnTypeFormattingProvider": {"firstTriggerCharacter":"}","moreTriggerCharacter":[]},
@@ -45,7 +45,7 @@ struct InitializeHandler : Handler {
 struct ShutdownHandler : Handler {
   ShutdownHandler(JSONOutput &Output) : Handler(Output) {}
 
-  void handleMethod(llvm::yaml::MappingNode *Params, StringRef ID) override {
+  void handleMethod(const json::ObjectNode *Params, StringRef ID) override {
     IsDone = true;
   }
 
@@ -59,7 +59,7 @@ struct TextDocumentDidOpenHandler : Handler {
   TextDocumentDidOpenHandler(JSONOutput &Output, DocumentStore &Store)
       : Handler(Output), Store(Store) {}
 
-  void handleNotification(llvm::yaml::MappingNode *Params) override;
+  void handleNotification(const json::ObjectNode *Params) override;
 
 private:
   DocumentStore &Store;
@@ -69,7 +69,7 @@ struct TextDocumentDidChangeHandler : Handler {
   TextDocumentDidChangeHandler(JSONOutput &Output, DocumentStore &Store)
       : Handler(Output), Store(Store) {}
 
-  void handleNotification(llvm::yaml::MappingNode *Params) override;
+  void handleNotification(const json::ObjectNode *Params) override;
 
 private:
   DocumentStore &Store;
@@ -79,7 +79,7 @@ struct TextDocumentDidCloseHandler : Handler {
   TextDocumentDidCloseHandler(JSONOutput &Output, DocumentStore &Store)
       : Handler(Output), Store(Store) {}
 
-  void handleNotification(llvm::yaml::MappingNode *Params) override;
+  void handleNotification(const json::ObjectNode *Params) override;
 
 private:
   DocumentStore &Store;
@@ -89,7 +89,7 @@ struct TextDocumentOnTypeFormattingHandler : Handler {
   TextDocumentOnTypeFormattingHandler(JSONOutput &Output, DocumentStore &Store)
       : Handler(Output), Store(Store) {}
 
-  void handleMethod(llvm::yaml::MappingNode *Params, StringRef ID) override;
+  void handleMethod(const json::ObjectNode *Params, StringRef ID) override;
 
 private:
   DocumentStore &Store;
@@ -99,7 +99,7 @@ struct TextDocumentRangeFormattingHandler : Handler {
   TextDocumentRangeFormattingHandler(JSONOutput &Output, DocumentStore &Store)
       : Handler(Output), Store(Store) {}
 
-  void handleMethod(llvm::yaml::MappingNode *Params, StringRef ID) override;
+  void handleMethod(const json::ObjectNode *Params, StringRef ID) override;
 
 private:
   DocumentStore &Store;
@@ -109,7 +109,7 @@ struct TextDocumentFormattingHandler : Handler {
   TextDocumentFormattingHandler(JSONOutput &Output, DocumentStore &Store)
       : Handler(Output), Store(Store) {}
 
-  void handleMethod(llvm::yaml::MappingNode *Params, StringRef ID) override;
+  void handleMethod(const json::ObjectNode *Params, StringRef ID) override;
 
 private:
   DocumentStore &Store;
@@ -119,7 +119,7 @@ struct CodeActionHandler : Handler {
   CodeActionHandler(JSONOutput &Output, ASTManager &AST)
       : Handler(Output), AST(AST) {}
 
-  void handleMethod(llvm::yaml::MappingNode *Params, StringRef ID) override;
+  void handleMethod(const json::ObjectNode *Params, StringRef ID) override;
 
 private:
   ASTManager &AST;
@@ -129,12 +129,24 @@ struct CompletionHandler : Handler {
   CompletionHandler(JSONOutput &Output, ASTManager &AST)
       : Handler(Output), AST(AST) {}
 
-  void handleMethod(llvm::yaml::MappingNode *Params, StringRef ID) override;
+  void handleMethod(const json::ObjectNode *Params, StringRef ID) override;
 
  private:
   ASTManager &AST;
 };
 
+/// Handles the clangd/memoryUsage extension, which returns the estimated memory
+/// used by the ASTs of the open documents.
+struct MemoryUsageHandler : Handler {
+  MemoryUsageHandler(JSONOutput &Output, ASTManager &AST)
+      : Handler(Output), AST(AST) {}
+
+  void handleMethod(const json::ObjectNode *Params, StringRef ID) override;
+
+private:
+  ASTManager &AST;
+};
+
 } // namespace clangd
 } // namespace clang
 
@@ -0,0 +1,152 @@
+//===--- JSONParserBenchmark.cpp - JSON vs. YAML message parsing ----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Measures the cost of parsing recorded JSONRPC traffic with json::Document
+// compared to llvm::yaml::Stream, which clangd used before. The input files
+// contain Content-Length framed messages, e.g. the test/clangd/*.test files:
+//
+//   clangd-json-benchmark -iterations=1000 test/clangd/*.test
+//
+//===----------------------------------------------------------------------===//
+
+#include "JSONParser.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/YAMLParser.h"
+#include "llvm/Support/raw_ostream.h"
+#include <chrono>
+#include <string>
+#include <vector>
+
+using namespace llvm;
+using namespace clang::clangd;
+
+static cl::list<std::string> InputFiles(cl::Positional, cl::OneOrMore,
+                                        cl::desc("<recorded traffic files>"));
+
+static cl::opt<unsigned> Iterations("iterations",
+                                    cl::desc("Number of times each message is "
+                                             "parsed"),
+                                    cl::init(1000));
+
+/// Extracts the message bodies from Content-Length framed \p Text. Headers
+/// must start a line, so that e.g. CHECK lines in tests are skipped.
+static void splitMessages(StringRef Text, std::vector<std::string> &Messages) {
+  const StringRef Header = "Content-Length: ";
+  while (!Text.empty()) {
+    if (!Text.startswith(Header)) {
+      Text = Text.drop_until([](char C) { return C == '\n'; }).drop_front();
+      continue;
+    }
+    Text = Text.substr(Header.size());
+    unsigned long long Len;
+    if (consumeUnsignedInteger(Text, 10, Len))
+      continue;
+    size_t BodyPos = Text.find("\r\n\r\n");
+    if (BodyPos == StringRef::npos)
+      return;
+    Text = Text.substr(BodyPos + 4);
+    Messages.push_back(Text.substr(0, Len).str());
+    Text = Text.substr(Len);
+  }
+}
+
+/// Visits every node, as the YAML parser only parses lazily.
+static unsigned walkYAML(yaml::Node *N) {
+  unsigned Count = 1;
+  if (auto *Mapping = dyn_cast<yaml::MappingNode>(N)) {
+    for (auto &KV : *Mapping) {
+      if (auto *Key = KV.getKey())
+        Count += walkYAML(Key);
+      if (auto *Value = KV.getValue())
+        Count += walkYAML(Value);
+    }
+  } else if (auto *Sequence = dyn_cast<yaml::SequenceNode>(N)) {
+    for (auto &Element : *Sequence)
+      Count += walkYAML(&Element);
+  } else if (auto *Scalar = dyn_cast<yaml::ScalarNode>(N)) {
+    SmallString<64> Storage;
+    Scalar->getValue(Storage);
+  }
+  return Count;
+}
+
+static unsigned walkJSON(const json::Node *N) {
+  unsigned Count = 1;
+  if (auto *Object = dyn_cast<json::ObjectNode>(N)) {
+    for (const auto &M : *Object)
+      Count += walkJSON(M.Value);
+  } else if (auto *Array = dyn_cast<json::ArrayNode>(N)) {
+    for (const json::Node *Element : *Array)
+      Count += walkJSON(Element);
+  }
+  return Count;
+}
+
+template <typename Fn> static double timeMicroseconds(Fn F) {
+  auto Start = std::chrono::steady_clock::now();
+  for (unsigned I = 0; I != Iterations; ++I)
+    F();
+  std::chrono::duration<double, std::micro> Elapsed =
+      std::chrono::steady_clock::now() - Start;
+  return Elapsed.count() / Iterations;
+}
+
+int main(int argc, char *argv[]) {
+  cl::ParseCommandLineOptions(argc, argv, "clangd JSON parser benchmark\n");
+
+  std::vector<std::string> Messages;
+  for (const std::string &File : InputFiles) {
+    auto Buffer = MemoryBuffer::getFile(File);
+    if (!Buffer) {
+      errs() << "Cannot read " << File << ": "
+             << Buffer.getError().message() << '\n';
+      return 1;
+    }
+    splitMessages((*Buffer)->getBuffer(), Messages);
+  }
+  if (Messages.empty()) {
+    errs() << "No messages found.\n";
+    return 1;
+  }
+
+  double TotalYAML = 0, TotalJSON = 0;
+  size_t TotalBytes = 0;
+  json::Document Doc;
+  for (const std::string &Message : Messages) {
+    unsigned JSONNodes = 0;
+    double YAML = timeMicroseconds([&] {
+      SourceMgr SM;
+      yaml::Stream YAMLStream(Message, SM);
+      auto Begin = YAMLStream.begin();
+      if (Begin != YAMLStream.end())
+        if (yaml::Node *Root = Begin->getRoot())
+          walkYAML(Root);
+    });
+    double JSON = timeMicroseconds([&] {
+      if (const json::Node *Root = Doc.parse(Message))
+        JSONNodes = walkJSON(Root);
+    });
+    if (!JSONNodes)
+      errs() << "JSON parse error: " << Doc.getError() << '\n';
+
+    outs() << format("%8zu bytes %6u nodes  yaml %9.2fus  json %9.2fus\n",
+                     Message.size(), JSONNodes, YAML, JSON);
+    TotalYAML += YAML;
+    TotalJSON += JSON;
+    TotalBytes += Message.size();
+  }
+  outs() << format("%zu messages, %zu bytes: yaml %.2fus  json %.2fus  "
+                   "(%.1fx)\n",
+                   Messages.size(), TotalBytes, TotalYAML, TotalJSON,
+                   TotalJSON ? TotalYAML / TotalJSON : 0.0);
+  return 0;
+}
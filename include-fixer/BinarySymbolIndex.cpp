@@ -0,0 +1,56 @@
+//===-- BinarySymbolIndex.cpp ---------------------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "BinarySymbolIndex.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/Errc.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+
+using clang::find_all_symbols::BinarySymbolDatabase;
+using clang::find_all_symbols::SymbolAndSignals;
+
+namespace clang {
+namespace include_fixer {
+
+llvm::Expected<std::unique_ptr<BinarySymbolIndex>>
+BinarySymbolIndex::createFromFile(llvm::StringRef FilePath) {
+  auto DB = BinarySymbolDatabase::createFromFile(FilePath);
+  if (!DB)
+    return DB.takeError();
+  return std::unique_ptr<BinarySymbolIndex>(
+      new BinarySymbolIndex(std::move(*DB)));
+}
+
+llvm::Expected<std::unique_ptr<BinarySymbolIndex>>
+BinarySymbolIndex::createFromDirectory(llvm::StringRef Directory,
+                                       llvm::StringRef Name) {
+  // Walk upwards from Directory, looking for files.
+  for (llvm::SmallString<128> PathStorage = Directory; !Directory.empty();
+       Directory = llvm::sys::path::parent_path(Directory)) {
+    assert(Directory.size() <= PathStorage.size());
+    PathStorage.resize(Directory.size()); // Shrink to parent.
+    llvm::sys::path::append(PathStorage, Name);
+    if (!llvm::sys::fs::exists(PathStorage))
+      continue;
+    // Report a database that exists but can't be read instead of looking
+    // further up.
+    return createFromFile(PathStorage);
+  }
+  return llvm::errorCodeToError(
+      llvm::make_error_code(llvm::errc::no_such_file_or_directory));
+}
+
+std::vector<SymbolAndSignals>
+BinarySymbolIndex::search(llvm::StringRef Identifier) {
+  return DB->lookup(Identifier);
+}
+
+} // namespace include_fixer
+} // namespace clang
@@ -0,0 +1,47 @@
+//===-- BinarySymbolIndex.h -------------------------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_TOOLS_EXTRA_INCLUDE_FIXER_BINARYSYMBOLINDEX_H
+#define LLVM_CLANG_TOOLS_EXTRA_INCLUDE_FIXER_BINARYSYMBOLINDEX_H
+
+#include "SymbolIndex.h"
+#include "find-all-symbols/BinarySymbolDatabase.h"
+#include "llvm/Support/Error.h"
+#include <memory>
+#include <vector>
+
+namespace clang {
+namespace include_fixer {
+
+/// Binary format database created by find-all-symbols. The file is mapped into
+/// memory and only the symbols that are found are read.
+class BinarySymbolIndex : public SymbolIndex {
+public:
+  /// Load a binary db from a file.
+  static llvm::Expected<std::unique_ptr<BinarySymbolIndex>>
+  createFromFile(llvm::StringRef FilePath);
+  /// Look for a file called \c Name in \c Directory and all parent directories.
+  static llvm::Expected<std::unique_ptr<BinarySymbolIndex>>
+  createFromDirectory(llvm::StringRef Directory, llvm::StringRef Name);
+
+  std::vector<find_all_symbols::SymbolAndSignals>
+  search(llvm::StringRef Identifier) override;
+
+private:
+  explicit BinarySymbolIndex(
+      std::unique_ptr<find_all_symbols::BinarySymbolDatabase> DB)
+      : DB(std::move(DB)) {}
+
+  std::unique_ptr<find_all_symbols::BinarySymbolDatabase> DB;
+};
+
+} // namespace include_fixer
+} // namespace clang
+
+#endif // LLVM_CLANG_TOOLS_EXTRA_INCLUDE_FIXER_BINARYSYMBOLINDEX_H
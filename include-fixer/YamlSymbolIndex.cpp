@@ -13,6 +13,7 @@
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
+#include <algorithm>
 #include <string>
 #include <vector>
 
@@ -22,6 +23,21 @@ using clang::find_all_symbols::SymbolAndSignals;
 namespace clang {
 namespace include_fixer {
 
+YamlSymbolIndex::YamlSymbolIndex(std::vector<SymbolAndSignals> Symbols)
+    : Symbols(std::move(Symbols)) {
+  std::stable_sort(this->Symbols.begin(), this->Symbols.end(),
+                   [](const SymbolAndSignals &A, const SymbolAndSignals &B) {
+                     return A.Symbol.getName() < B.Symbol.getName();
+                   });
+  for (unsigned I = 0, E = this->Symbols.size(); I != E;) {
+    llvm::StringRef Name = this->Symbols[I].Symbol.getName();
+    unsigned Begin = I;
+    while (I != E && this->Symbols[I].Symbol.getName() == Name)
+      ++I;
+    NameRanges[Name] = std::make_pair(Begin, I);
+  }
+}
+
 llvm::ErrorOr<std::unique_ptr<YamlSymbolIndex>>
 YamlSymbolIndex::createFromFile(llvm::StringRef FilePath) {
   auto Buffer = llvm::MemoryBuffer::getFile(FilePath);
@@ -49,12 +65,11 @@ YamlSymbolIndex::createFromDirectory(llvm::StringRef Directory,
 
 std::vector<SymbolAndSignals>
 YamlSymbolIndex::search(llvm::StringRef Identifier) {
-  std::vector<SymbolAndSignals> Results;
-  for (const auto &Symbol : Symbols) {
-    if (Symbol.Symbol.getName() == Identifier)
-      Results.push_back(Symbol);
-  }
-  return Results;
+  auto I = NameRanges.find(Identifier);
+  if (I == NameRanges.end())
+    return {};
+  return std::vector<SymbolAndSignals>(Symbols.begin() + I->second.first,
+                                       Symbols.begin() + I->second.second);
 }
 
 } // namespace include_fixer
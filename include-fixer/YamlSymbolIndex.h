@@ -12,14 +12,18 @@
 
 #include "SymbolIndex.h"
 #include "find-all-symbols/SymbolInfo.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/Support/ErrorOr.h"
-#include <map>
 #include <vector>
 
 namespace clang {
 namespace include_fixer {
 
 /// Yaml format database.
+///
+/// The symbols are grouped by name when the database is loaded, so that a
+/// search only hashes the identifier instead of comparing it with the name of
+/// every symbol.
 class YamlSymbolIndex : public SymbolIndex {
 public:
   /// Create a new Yaml db from a file.
@@ -34,10 +38,13 @@ public:
 
 private:
   explicit YamlSymbolIndex(
-      std::vector<find_all_symbols::SymbolAndSignals> Symbols)
-      : Symbols(std::move(Symbols)) {}
+      std::vector<find_all_symbols::SymbolAndSignals> Symbols);
 
+  /// The symbols, sorted by name. Symbols with the same name keep the order of
+  /// the database.
   std::vector<find_all_symbols::SymbolAndSignals> Symbols;
+  /// The range of \c Symbols with each name, as [begin, end) indexes.
+  llvm::StringMap<std::pair<unsigned, unsigned>> NameRanges;
 };
 
 } // namespace include_fixer
@@ -0,0 +1,119 @@
+//===--- SymbolIndexBenchmark.cpp - Time searches in a YAML database ------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Measures the time YamlSymbolIndex needs to look up identifiers in a symbol
+// database, compared to comparing the identifier with the name of every
+// symbol, as YamlSymbolIndex did before:
+//
+//   include-fixer-index-benchmark -queries=1000 find_all_symbols_db.yaml
+//
+// The queries are the names of symbols spread over the database, each followed
+// by an identifier that is not in the database.
+//
+//===----------------------------------------------------------------------===//
+
+#include "YamlSymbolIndex.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include <chrono>
+#include <string>
+#include <vector>
+
+using namespace llvm;
+using namespace clang::include_fixer;
+using clang::find_all_symbols::SymbolAndSignals;
+
+static cl::opt<std::string> Database(cl::Positional, cl::Required,
+                                     cl::desc("<symbol database>"));
+
+static cl::opt<unsigned> NumQueries("queries",
+                                    cl::desc("Number of names looked up"),
+                                    cl::init(1000));
+
+/// Returns the time \p Search needs to look up all \p Queries in ms, and adds
+/// the number of symbols found to \p NumResults.
+template <typename SearchT>
+static double timeSearches(ArrayRef<std::string> Queries, SearchT Search,
+                           size_t &NumResults) {
+  auto Start = std::chrono::steady_clock::now();
+  for (const std::string &Query : Queries)
+    NumResults += Search(Query).size();
+  std::chrono::duration<double, std::milli> Elapsed =
+      std::chrono::steady_clock::now() - Start;
+  return Elapsed.count();
+}
+
+int main(int argc, const char **argv) {
+  cl::ParseCommandLineOptions(argc, argv);
+
+  auto Buffer = MemoryBuffer::getFile(Database);
+  if (!Buffer) {
+    errs() << "Cannot read " << Database << ": " << Buffer.getError().message()
+           << "\n";
+    return 1;
+  }
+  std::vector<SymbolAndSignals> Symbols =
+      clang::find_all_symbols::ReadSymbolInfosFromYAML(
+          (*Buffer)->getBuffer());
+  if (Symbols.empty()) {
+    errs() << "No symbols in " << Database << "\n";
+    return 1;
+  }
+
+  auto Start = std::chrono::steady_clock::now();
+  auto Index = YamlSymbolIndex::createFromFile(Database);
+  std::chrono::duration<double, std::milli> LoadTime =
+      std::chrono::steady_clock::now() - Start;
+  if (!Index) {
+    errs() << "Cannot load " << Database << ": " << Index.getError().message()
+           << "\n";
+    return 1;
+  }
+
+  std::vector<std::string> Queries;
+  for (unsigned I = 0; I < NumQueries; ++I) {
+    Queries.push_back(
+        Symbols[size_t(I) * Symbols.size() / NumQueries].Symbol.getName());
+    Queries.push_back(Queries.back() + "_not_found");
+  }
+
+  size_t IndexResults = 0, ScanResults = 0;
+  double IndexTime = timeSearches(
+      Queries,
+      [&Index](StringRef Name) { return (*Index)->search(Name); },
+      IndexResults);
+  double ScanTime = timeSearches(
+      Queries,
+      [&Symbols](StringRef Name) {
+        std::vector<SymbolAndSignals> Results;
+        for (const auto &Symbol : Symbols) {
+          if (Symbol.Symbol.getName() == Name)
+            Results.push_back(Symbol);
+        }
+        return Results;
+      },
+      ScanResults);
+
+  outs() << "Symbols: " << Symbols.size() << "\n"
+         << "Queries: " << Queries.size() << "\n";
+  if (IndexResults != ScanResults) {
+    errs() << "Mismatch: the index found " << IndexResults
+           << " symbols, the scan found " << ScanResults << "\n";
+    return 1;
+  }
+  outs() << "Results: " << IndexResults << "\n";
+  outs() << format("Load: %.1fms\n", LoadTime.count());
+  outs() << format("Index: %.3fms, %.3fus per query\n", IndexTime,
+                   IndexTime * 1000 / Queries.size());
+  outs() << format("Scan: %.3fms, %.3fus per query\n", ScanTime,
+                   ScanTime * 1000 / Queries.size());
+  return 0;
+}
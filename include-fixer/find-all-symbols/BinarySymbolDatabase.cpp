@@ -0,0 +1,292 @@
+//===-- BinarySymbolDatabase.cpp - binary symbol database -------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "BinarySymbolDatabase.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <tuple>
+
+namespace clang {
+namespace find_all_symbols {
+
+namespace {
+const char Magic[8] = {'F', 'A', 'S', 'Y', 'M', 'D', 'B', '\0'};
+/// \brief Incremented whenever the layout of the records changes.
+const uint32_t Version = 1;
+/// \brief Marks empty hash buckets and the end of context chains.
+const uint32_t None = ~0u;
+
+typedef llvm::support::ulittle32_t Word;
+
+struct Header {
+  char Magic[8];
+  Word Version;
+  Word NumBuckets;
+  Word NumNames;
+  Word NumSymbols;
+  Word NumContexts;
+  Word StringsSize;
+};
+
+/// \brief FNV-1a, which is part of the format as it places names in buckets.
+uint32_t hashName(llvm::StringRef Name) {
+  uint32_t Hash = 2166136261u;
+  for (unsigned char C : Name)
+    Hash = (Hash ^ C) * 16777619u;
+  return Hash;
+}
+} // namespace
+
+struct BinarySymbolDatabase::StringRecord {
+  Word Offset;
+  Word Length;
+};
+
+struct BinarySymbolDatabase::NameRecord {
+  StringRecord Name;
+  Word FirstSymbol;
+  Word NumSymbols;
+};
+
+struct BinarySymbolDatabase::SymbolRecord {
+  StringRecord Name;
+  StringRecord FilePath;
+  Word Type;
+  Word FirstContext;
+  Word Seen;
+  Word Used;
+};
+
+struct BinarySymbolDatabase::ContextRecord {
+  StringRecord Name;
+  Word Type;
+  Word Next;
+};
+
+bool BinarySymbolDatabase::hasMagic(llvm::StringRef Contents) {
+  return Contents.startswith(llvm::StringRef(Magic, sizeof(Magic)));
+}
+
+llvm::Expected<std::unique_ptr<BinarySymbolDatabase>>
+BinarySymbolDatabase::create(std::unique_ptr<llvm::MemoryBuffer> Buffer) {
+  auto Error = [&Buffer](const llvm::Twine &Message) {
+    return llvm::make_error<llvm::StringError>(
+        Buffer->getBufferIdentifier() + ": " + Message,
+        llvm::inconvertibleErrorCode());
+  };
+  llvm::StringRef Contents = Buffer->getBuffer();
+  if (Contents.size() < sizeof(Header) || !hasMagic(Contents))
+    return Error("not a binary symbol database");
+  const auto *H = reinterpret_cast<const Header *>(Contents.data());
+  if (H->Version != Version)
+    return Error("unsupported version " + llvm::Twine(uint32_t(H->Version)) +
+                 ", expected " + llvm::Twine(Version));
+  // Compute the section sizes in 64 bits, so that they can't overflow.
+  uint64_t Size = sizeof(Header) + uint64_t(H->NumBuckets) * sizeof(Word) +
+                  uint64_t(H->NumNames) * sizeof(NameRecord) +
+                  uint64_t(H->NumSymbols) * sizeof(SymbolRecord) +
+                  uint64_t(H->NumContexts) * sizeof(ContextRecord) +
+                  H->StringsSize;
+  if (Size != Contents.size())
+    return Error("truncated database");
+  if (H->NumNames != 0 && !llvm::isPowerOf2_32(H->NumBuckets))
+    return Error("invalid hash table size");
+
+  std::unique_ptr<BinarySymbolDatabase> DB(
+      new BinarySymbolDatabase(std::move(Buffer)));
+  const char *Data = Contents.data() + sizeof(Header);
+  DB->NumBuckets = H->NumBuckets;
+  DB->Buckets = reinterpret_cast<const Word *>(Data);
+  Data += DB->NumBuckets * sizeof(Word);
+  DB->NumNames = H->NumNames;
+  DB->Names = reinterpret_cast<const NameRecord *>(Data);
+  Data += DB->NumNames * sizeof(NameRecord);
+  DB->NumSymbols = H->NumSymbols;
+  DB->Symbols = reinterpret_cast<const SymbolRecord *>(Data);
+  Data += DB->NumSymbols * sizeof(SymbolRecord);
+  DB->NumContexts = H->NumContexts;
+  DB->Contexts = reinterpret_cast<const ContextRecord *>(Data);
+  Data += DB->NumContexts * sizeof(ContextRecord);
+  DB->Strings = llvm::StringRef(Data, H->StringsSize);
+  return std::move(DB);
+}
+
+llvm::Expected<std::unique_ptr<BinarySymbolDatabase>>
+BinarySymbolDatabase::createFromFile(llvm::StringRef FilePath) {
+  // Large files are mapped instead of read, unless they need a terminator.
+  auto Buffer = llvm::MemoryBuffer::getFile(FilePath, /*FileSize=*/-1,
+                                            /*RequiresNullTerminator=*/false);
+  if (!Buffer)
+    return llvm::errorCodeToError(Buffer.getError());
+  return create(std::move(*Buffer));
+}
+
+llvm::StringRef
+BinarySymbolDatabase::getString(const StringRecord &String) const {
+  // A corrupted record yields an empty string instead of reading outside of
+  // the buffer.
+  if (String.Offset > Strings.size() ||
+      String.Length > Strings.size() - String.Offset)
+    return "";
+  return Strings.substr(String.Offset, String.Length);
+}
+
+SymbolAndSignals
+BinarySymbolDatabase::getSymbol(const SymbolRecord &Symbol) const {
+  std::vector<SymbolInfo::Context> SymbolContexts;
+  // Contexts are written outer first, so a valid chain only refers to earlier
+  // records, which also rules out cycles.
+  for (uint32_t I = Symbol.FirstContext, Limit = NumContexts; I < Limit;
+       Limit = I, I = Contexts[I].Next) {
+    const ContextRecord &Context = Contexts[I];
+    SymbolContexts.emplace_back(
+        static_cast<SymbolInfo::ContextType>(uint32_t(Context.Type)),
+        getString(Context.Name).str());
+  }
+  return {SymbolInfo(getString(Symbol.Name),
+                     static_cast<SymbolInfo::SymbolKind>(uint32_t(Symbol.Type)),
+                     getString(Symbol.FilePath), SymbolContexts),
+          SymbolInfo::Signals(Symbol.Seen, Symbol.Used)};
+}
+
+std::vector<SymbolAndSignals>
+BinarySymbolDatabase::lookup(llvm::StringRef Name) const {
+  std::vector<SymbolAndSignals> Results;
+  if (NumNames == 0)
+    return Results;
+  uint32_t Mask = NumBuckets - 1;
+  for (uint32_t Bucket = hashName(Name) & Mask, Probes = 0;
+       Probes != NumBuckets; Bucket = (Bucket + 1) & Mask, ++Probes) {
+    uint32_t NameIndex = Buckets[Bucket];
+    if (NameIndex == None || NameIndex >= NumNames)
+      break;
+    const NameRecord &Record = Names[NameIndex];
+    if (getString(Record.Name) != Name)
+      continue;
+    for (uint32_t I = Record.FirstSymbol,
+                  E = std::min<uint64_t>(uint64_t(I) + Record.NumSymbols,
+                                         NumSymbols);
+         I < E; ++I)
+      Results.push_back(getSymbol(Symbols[I]));
+    break;
+  }
+  return Results;
+}
+
+bool WriteSymbolInfosToBinary(llvm::raw_ostream &OS,
+                              const SymbolInfo::SignalMap &Symbols) {
+  typedef BinarySymbolDatabase::StringRecord StringRecord;
+  typedef BinarySymbolDatabase::NameRecord NameRecord;
+  typedef BinarySymbolDatabase::SymbolRecord SymbolRecord;
+  typedef BinarySymbolDatabase::ContextRecord ContextRecord;
+
+  llvm::StringMap<uint32_t> StringOffsets;
+  std::string StringTable;
+  auto AddString = [&](llvm::StringRef S) {
+    auto Inserted =
+        StringOffsets.insert(std::make_pair(S, uint32_t(StringTable.size())));
+    if (Inserted.second)
+      StringTable += S;
+    StringRecord Record;
+    Record.Offset = Inserted.first->second;
+    Record.Length = S.size();
+    return Record;
+  };
+
+  // Contexts are keyed by their type, name and outer context, so that every
+  // scope is written once.
+  std::map<std::tuple<uint32_t, std::string, uint32_t>, uint32_t> ContextIds;
+  std::vector<ContextRecord> Contexts;
+  std::vector<SymbolRecord> SymbolRecords;
+  std::vector<NameRecord> Names;
+  // SignalMap is ordered by name first, so symbols with the same name are
+  // adjacent.
+  for (const auto &SymbolAndSignals : Symbols) {
+    const SymbolInfo &Symbol = SymbolAndSignals.first;
+    uint32_t Next = None;
+    const auto &SymbolContexts = Symbol.getContexts();
+    for (auto I = SymbolContexts.rbegin(), E = SymbolContexts.rend(); I != E;
+         ++I) {
+      auto Inserted = ContextIds.insert(std::make_pair(
+          std::make_tuple(uint32_t(I->first), I->second, Next),
+          uint32_t(Contexts.size())));
+      if (Inserted.second) {
+        ContextRecord Record;
+        Record.Name = AddString(I->second);
+        Record.Type = uint32_t(I->first);
+        Record.Next = Next;
+        Contexts.push_back(Record);
+      }
+      Next = Inserted.first->second;
+    }
+
+    SymbolRecord Record;
+    Record.Name = AddString(Symbol.getName());
+    Record.FilePath = AddString(Symbol.getFilePath());
+    Record.Type = uint32_t(Symbol.getSymbolKind());
+    Record.FirstContext = Next;
+    Record.Seen = SymbolAndSignals.second.Seen;
+    Record.Used = SymbolAndSignals.second.Used;
+
+    if (Names.empty() ||
+        StringTable.compare(Names.back().Name.Offset, Names.back().Name.Length,
+                            Symbol.getName()) != 0) {
+      NameRecord Name;
+      Name.Name = Record.Name;
+      Name.FirstSymbol = SymbolRecords.size();
+      Name.NumSymbols = 0;
+      Names.push_back(Name);
+    }
+    Names.back().NumSymbols = Names.back().NumSymbols + 1;
+    SymbolRecords.push_back(Record);
+  }
+
+  // Keep the hash table at most half full.
+  uint32_t NumBuckets =
+      Names.empty() ? 0 : llvm::NextPowerOf2(Names.size() * 2 - 1);
+  std::vector<Word> Buckets(NumBuckets);
+  for (Word &Bucket : Buckets)
+    Bucket = None;
+  for (uint32_t I = 0; I < Names.size(); ++I) {
+    uint32_t Bucket =
+        hashName(llvm::StringRef(StringTable).substr(Names[I].Name.Offset,
+                                                     Names[I].Name.Length)) &
+        (NumBuckets - 1);
+    while (Buckets[Bucket] != None)
+      Bucket = (Bucket + 1) & (NumBuckets - 1);
+    Buckets[Bucket] = I;
+  }
+
+  Header H;
+  std::copy(std::begin(Magic), std::end(Magic), H.Magic);
+  H.Version = Version;
+  H.NumBuckets = NumBuckets;
+  H.NumNames = Names.size();
+  H.NumSymbols = SymbolRecords.size();
+  H.NumContexts = Contexts.size();
+  H.StringsSize = StringTable.size();
+
+  auto WriteArray = [&OS](const void *Data, size_t Size) {
+    OS.write(reinterpret_cast<const char *>(Data), Size);
+  };
+  WriteArray(&H, sizeof(H));
+  WriteArray(Buckets.data(), Buckets.size() * sizeof(Word));
+  WriteArray(Names.data(), Names.size() * sizeof(NameRecord));
+  WriteArray(SymbolRecords.data(), SymbolRecords.size() * sizeof(SymbolRecord));
+  WriteArray(Contexts.data(), Contexts.size() * sizeof(ContextRecord));
+  OS << StringTable;
+  return true;
+}
+
+} // namespace find_all_symbols
+} // namespace clang
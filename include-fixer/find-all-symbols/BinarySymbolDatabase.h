@@ -0,0 +1,92 @@
+//===-- BinarySymbolDatabase.h - binary symbol database ---------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_TOOLS_EXTRA_INCLUDE_FIXER_FIND_ALL_SYMBOLS_BINARYSYMBOLDATABASE_H
+#define LLVM_CLANG_TOOLS_EXTRA_INCLUDE_FIXER_FIND_ALL_SYMBOLS_BINARYSYMBOLDATABASE_H
+
+#include "SymbolInfo.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include <memory>
+#include <vector>
+
+namespace clang {
+namespace find_all_symbols {
+
+/// \brief A symbol database in a binary format that is used where it's
+/// mapped into memory, without parsing it first.
+///
+/// The file starts with a header, followed by these arrays:
+///   - A hash table of the symbol names, with open addressing. Each bucket is
+///     the index of a name record, or ~0 if it's empty.
+///   - The name records, in the order of the names. Each one refers to the
+///     range of symbol records with the name.
+///   - The symbol records, sorted by name.
+///   - The context records. Each one refers to the next outer context, so that
+///     symbols declared in the same scope share their chain of contexts.
+///   - The string table. Strings are referred to by offset and length.
+/// All integers are 32-bit little-endian.
+class BinarySymbolDatabase {
+public:
+  /// \brief Reads the database in \p Buffer. Only the header is checked, the
+  /// records are read on demand.
+  static llvm::Expected<std::unique_ptr<BinarySymbolDatabase>>
+  create(std::unique_ptr<llvm::MemoryBuffer> Buffer);
+
+  /// \brief Maps the database at \p FilePath into memory.
+  static llvm::Expected<std::unique_ptr<BinarySymbolDatabase>>
+  createFromFile(llvm::StringRef FilePath);
+
+  /// \brief Returns the symbols named \p Name, in the order they were written.
+  std::vector<SymbolAndSignals> lookup(llvm::StringRef Name) const;
+
+  /// \brief Returns the number of symbols in the database.
+  unsigned size() const { return NumSymbols; }
+
+  /// \brief Returns true if \p Contents starts like a binary symbol database
+  /// of any version.
+  static bool hasMagic(llvm::StringRef Contents);
+
+private:
+  friend bool WriteSymbolInfosToBinary(llvm::raw_ostream &OS,
+                                       const SymbolInfo::SignalMap &Symbols);
+
+  typedef llvm::support::ulittle32_t Word;
+  struct StringRecord;
+  struct NameRecord;
+  struct SymbolRecord;
+  struct ContextRecord;
+
+  explicit BinarySymbolDatabase(std::unique_ptr<llvm::MemoryBuffer> Buffer)
+      : Buffer(std::move(Buffer)) {}
+
+  llvm::StringRef getString(const StringRecord &String) const;
+  SymbolAndSignals getSymbol(const SymbolRecord &Symbol) const;
+
+  std::unique_ptr<llvm::MemoryBuffer> Buffer;
+  const Word *Buckets = nullptr;
+  const NameRecord *Names = nullptr;
+  const SymbolRecord *Symbols = nullptr;
+  const ContextRecord *Contexts = nullptr;
+  llvm::StringRef Strings;
+  unsigned NumBuckets = 0;
+  unsigned NumNames = 0;
+  unsigned NumSymbols = 0;
+  unsigned NumContexts = 0;
+};
+
+/// \brief Writes \p Symbols to \p OS as a \c BinarySymbolDatabase.
+bool WriteSymbolInfosToBinary(llvm::raw_ostream &OS,
+                              const SymbolInfo::SignalMap &Symbols);
+
+} // namespace find_all_symbols
+} // namespace clang
+
+#endif // LLVM_CLANG_TOOLS_EXTRA_INCLUDE_FIXER_FIND_ALL_SYMBOLS_BINARYSYMBOLDATABASE_H
@@ -9,6 +9,7 @@
 
 #include "FindAllMacros.h"
 #include "HeaderMapCollector.h"
+#include "IndexedHeaders.h"
 #include "PathConfig.h"
 #include "SymbolInfo.h"
 #include "clang/Basic/IdentifierTable.h"
@@ -33,7 +34,17 @@ FindAllMacros::CreateMacroSymbol(const Token &MacroNameTok,
 
 void FindAllMacros::MacroDefined(const Token &MacroNameTok,
                                  const MacroDirective *MD) {
-  if (auto Symbol = CreateMacroSymbol(MacroNameTok, MD->getMacroInfo()))
+  const MacroInfo *Info = MD->getMacroInfo();
+  SourceLocation Loc = SM->getExpansionLoc(Info->getDefinitionLoc());
+  if (Headers && !SM->isInMainFile(Loc)) {
+    auto HeaderId = Headers->getIndexedHeader(*SM, Loc);
+    if (!HeaderId)
+      return;
+    if (auto Symbol = CreateMacroSymbol(MacroNameTok, Info))
+      Headers->addSymbol(*HeaderId, *Symbol, SymbolInfo::Signals(1, 0));
+    return;
+  }
+  if (auto Symbol = CreateMacroSymbol(MacroNameTok, Info))
     ++FileSymbols[*Symbol].Seen;
 }
 
@@ -20,6 +20,7 @@ class MacroInfo;
 namespace find_all_symbols {
 
 class HeaderMapCollector;
+class TranslationUnitHeaders;
 
 /// \brief A preprocessor that collects all macro symbols.
 /// The contexts of a macro will be ignored since they are not available during
@@ -27,8 +28,9 @@ class HeaderMapCollector;
 class FindAllMacros : public clang::PPCallbacks {
 public:
   explicit FindAllMacros(SymbolReporter *Reporter, SourceManager *SM,
-                         HeaderMapCollector *Collector = nullptr)
-      : Reporter(Reporter), SM(SM), Collector(Collector) {}
+                         HeaderMapCollector *Collector = nullptr,
+                         TranslationUnitHeaders *Headers = nullptr)
+      : Reporter(Reporter), SM(SM), Collector(Collector), Headers(Headers) {}
 
   void MacroDefined(const Token &MacroNameTok,
                     const MacroDirective *MD) override;
@@ -57,6 +59,9 @@ private:
   // A remapping header file collector allowing clients to include a different
   // header.
   HeaderMapCollector *const Collector;
+  // If set, the macros defined in headers are collected here, and only for the
+  // headers that no other translation unit indexed before.
+  TranslationUnitHeaders *const Headers;
 };
 
 } // namespace find_all_symbols
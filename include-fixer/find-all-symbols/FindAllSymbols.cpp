@@ -9,6 +9,7 @@
 
 #include "FindAllSymbols.h"
 #include "HeaderMapCollector.h"
+#include "IndexedHeaders.h"
 #include "PathConfig.h"
 #include "SymbolInfo.h"
 #include "clang/AST/Decl.h"
@@ -250,9 +251,21 @@ void FindAllSymbols::run(const MatchFinder::MatchResult &Result) {
     assert(false && "Must match a NamedDecl!");
 
   const SourceManager *SM = Result.SourceManager;
+  llvm::Optional<unsigned> HeaderId;
+  SourceLocation Loc = SM->getExpansionLoc(ND->getLocation());
+  // Declarations in the main file are reported with the file, as without
+  // Headers.
+  if (Headers && Signals.Seen && !SM->isInMainFile(Loc)) {
+    HeaderId = Headers->getIndexedHeader(*SM, Loc);
+    if (!HeaderId)
+      return;
+  }
   if (auto Symbol = CreateSymbolInfo(ND, *SM, Collector)) {
     Filename = SM->getFileEntryForID(SM->getMainFileID())->getName();
-    FileSymbols[*Symbol] += Signals;
+    if (HeaderId)
+      Headers->addSymbol(*HeaderId, *Symbol, Signals);
+    else
+      FileSymbols[*Symbol] += Signals;
   }
 }
 
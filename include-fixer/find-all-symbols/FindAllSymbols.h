@@ -19,6 +19,7 @@ namespace clang {
 namespace find_all_symbols {
 
 class HeaderMapCollector;
+class TranslationUnitHeaders;
 
 /// \brief FindAllSymbols collects all classes, free standing functions and
 /// global variables with some extra information such as the path of the header
@@ -35,8 +36,9 @@ class HeaderMapCollector;
 class FindAllSymbols : public ast_matchers::MatchFinder::MatchCallback {
 public:
   explicit FindAllSymbols(SymbolReporter *Reporter,
-                          HeaderMapCollector *Collector = nullptr)
-      : Reporter(Reporter), Collector(Collector) {}
+                          HeaderMapCollector *Collector = nullptr,
+                          TranslationUnitHeaders *Headers = nullptr)
+      : Reporter(Reporter), Collector(Collector), Headers(Headers) {}
 
   void registerMatchers(ast_matchers::MatchFinder *MatchFinder);
 
@@ -55,6 +57,9 @@ private:
   // A remapping header file collector allowing clients include a different
   // header.
   HeaderMapCollector *const Collector;
+  // If set, the symbols declared in headers are collected here, and only for
+  // the headers that no other translation unit indexed before.
+  TranslationUnitHeaders *const Headers;
 };
 
 } // namespace find_all_symbols
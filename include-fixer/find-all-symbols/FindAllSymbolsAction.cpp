@@ -18,9 +18,13 @@ namespace find_all_symbols {
 
 FindAllSymbolsAction::FindAllSymbolsAction(
     SymbolReporter *Reporter,
-    const HeaderMapCollector::RegexHeaderMap *RegexHeaderMap)
+    const HeaderMapCollector::CompiledRegexHeaderMap *RegexHeaderMap,
+    IndexedHeaderSet *IndexedHeaders)
     : Reporter(Reporter), Collector(RegexHeaderMap), Handler(&Collector),
-      Matcher(Reporter, &Collector) {
+      Headers(IndexedHeaders
+                  ? llvm::make_unique<TranslationUnitHeaders>(*IndexedHeaders)
+                  : nullptr),
+      Matcher(Reporter, &Collector, Headers.get()) {
   Matcher.registerMatchers(&MatchFinder);
 }
 
@@ -29,9 +33,14 @@ FindAllSymbolsAction::CreateASTConsumer(CompilerInstance &Compiler,
                                         StringRef InFile) {
   Compiler.getPreprocessor().addCommentHandler(&Handler);
   Compiler.getPreprocessor().addPPCallbacks(llvm::make_unique<FindAllMacros>(
-      Reporter, &Compiler.getSourceManager(), &Collector));
+      Reporter, &Compiler.getSourceManager(), &Collector, Headers.get()));
   return MatchFinder.newASTConsumer();
 }
 
+void FindAllSymbolsAction::EndSourceFileAction() {
+  if (Headers)
+    Headers->reportSymbols(*Reporter, getCurrentFile());
+}
+
 } // namespace find_all_symbols
 } // namespace clang
@@ -12,11 +12,13 @@
 
 #include "FindAllSymbols.h"
 #include "HeaderMapCollector.h"
+#include "IndexedHeaders.h"
 #include "PragmaCommentHandler.h"
 #include "clang/ASTMatchers/ASTMatchFinder.h"
 #include "clang/Frontend/CompilerInstance.h"
 #include "clang/Frontend/FrontendAction.h"
 #include "clang/Tooling/Tooling.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/StringRef.h"
 #include <memory>
 
@@ -25,19 +27,27 @@ namespace find_all_symbols {
 
 class FindAllSymbolsAction : public clang::ASTFrontendAction {
 public:
+  /// If \p IndexedHeaders is set, the symbols of each header are only
+  /// reported by the first translation unit that includes it, see
+  /// \c SymbolReporter::reportHeaderSymbols.
   explicit FindAllSymbolsAction(
       SymbolReporter *Reporter,
-      const HeaderMapCollector::RegexHeaderMap *RegexHeaderMap = nullptr);
+      const HeaderMapCollector::CompiledRegexHeaderMap *RegexHeaderMap =
+          nullptr,
+      IndexedHeaderSet *IndexedHeaders = nullptr);
 
   std::unique_ptr<clang::ASTConsumer>
   CreateASTConsumer(clang::CompilerInstance &Compiler,
                     StringRef InFile) override;
 
+  void EndSourceFileAction() override;
+
 private:
   SymbolReporter *const Reporter;
   clang::ast_matchers::MatchFinder MatchFinder;
   HeaderMapCollector Collector;
   PragmaCommentHandler Handler;
+  std::unique_ptr<TranslationUnitHeaders> Headers;
   FindAllSymbols Matcher;
 };
 
@@ -45,16 +55,27 @@ class FindAllSymbolsActionFactory : public tooling::FrontendActionFactory {
 public:
   FindAllSymbolsActionFactory(
       SymbolReporter *Reporter,
-      const HeaderMapCollector::RegexHeaderMap *RegexHeaderMap = nullptr)
-      : Reporter(Reporter), RegexHeaderMap(RegexHeaderMap) {}
+      const HeaderMapCollector::RegexHeaderMap *RegexHeaderMap = nullptr,
+      IndexedHeaderSet *IndexedHeaders = nullptr)
+      : Reporter(Reporter),
+        RegexHeaderMap(
+            RegexHeaderMap
+                ? llvm::make_unique<HeaderMapCollector::CompiledRegexHeaderMap>(
+                      *RegexHeaderMap)
+                : nullptr),
+        IndexedHeaders(IndexedHeaders) {}
 
   clang::FrontendAction *create() override {
-    return new FindAllSymbolsAction(Reporter, RegexHeaderMap);
+    return new FindAllSymbolsAction(Reporter, RegexHeaderMap.get(),
+                                    IndexedHeaders);
   }
 
 private:
   SymbolReporter *const Reporter;
-  const HeaderMapCollector::RegexHeaderMap *const RegexHeaderMap;
+  /// Compiled once for all the actions.
+  const std::unique_ptr<HeaderMapCollector::CompiledRegexHeaderMap>
+      RegexHeaderMap;
+  IndexedHeaderSet *const IndexedHeaders;
 };
 
 } // namespace find_all_symbols
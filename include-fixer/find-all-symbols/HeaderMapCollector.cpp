@@ -8,11 +8,115 @@
 //===----------------------------------------------------------------------===//
 
 #include "HeaderMapCollector.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Twine.h"
 #include "llvm/Support/Regex.h"
+#include <algorithm>
 
 namespace clang {
 namespace find_all_symbols {
 
+namespace {
+/// \brief If \p Pattern only matches names ending with a literal string,
+/// stores the string in \p Suffix and returns true.
+bool getLiteralSuffix(llvm::StringRef Pattern, std::string &Suffix) {
+  if (!Pattern.endswith("$"))
+    return false;
+  Pattern = Pattern.drop_back();
+  for (size_t I = 0; I < Pattern.size(); ++I) {
+    char C = Pattern[I];
+    if (C == '\\') {
+      // An escaped '$' at the end isn't an anchor.
+      if (++I == Pattern.size())
+        return false;
+      Suffix += Pattern[I];
+    } else if (llvm::StringRef("^$*+?()[]{}|").find(C) !=
+               llvm::StringRef::npos) {
+      return false;
+    } else {
+      // '.' is taken literally, as in header names.
+      Suffix += C;
+    }
+  }
+  return true;
+}
+} // namespace
+
+HeaderMapCollector::CompiledRegexHeaderMap::CompiledRegexHeaderMap(
+    const RegexHeaderMap &Table)
+    : SuffixTrie(1) {
+  std::string AnyPattern;
+  for (unsigned I = 0; I < Table.size(); ++I) {
+    const std::string &Pattern = Table[I].first;
+    MappedHeaders.push_back(Table[I].second);
+
+    std::string Suffix;
+    if (!getLiteralSuffix(Pattern, Suffix)) {
+      llvm::Regex Regex(Pattern);
+      // Invalid patterns never matched.
+      if (!Regex.isValid())
+        continue;
+      Regexes.push_back({I, std::move(Regex)});
+      if (!AnyPattern.empty())
+        AnyPattern += "|";
+      AnyPattern += "(" + Pattern + ")";
+      continue;
+    }
+
+    unsigned Node = 0;
+    for (char C : llvm::make_range(Suffix.rbegin(), Suffix.rend())) {
+      auto &Children = SuffixTrie[Node].Children;
+      auto Child = std::find_if(
+          Children.begin(), Children.end(),
+          [C](const std::pair<char, unsigned> &P) { return P.first == C; });
+      if (Child != Children.end()) {
+        Node = Child->second;
+        continue;
+      }
+      Children.emplace_back(C, SuffixTrie.size());
+      Node = SuffixTrie.size();
+      SuffixTrie.emplace_back();
+    }
+    SuffixTrie[Node].Entry = std::min<unsigned>(SuffixTrie[Node].Entry, I);
+  }
+  if (Regexes.size() > 1)
+    AnyRegex = llvm::make_unique<llvm::Regex>(AnyPattern);
+}
+
+llvm::StringRef HeaderMapCollector::CompiledRegexHeaderMap::lookup(
+    llvm::StringRef Header) const {
+  unsigned Best = NoEntry;
+  unsigned Node = 0;
+  for (size_t I = Header.size();; --I) {
+    Best = std::min<unsigned>(Best, SuffixTrie[Node].Entry);
+    if (I == 0)
+      break;
+    const auto &Children = SuffixTrie[Node].Children;
+    char C = Header[I - 1];
+    auto Child = std::find_if(
+        Children.begin(), Children.end(),
+        [C](const std::pair<char, unsigned> &P) { return P.first == C; });
+    if (Child == Children.end())
+      break;
+    Node = Child->second;
+  }
+
+  // Only the regexes of entries before the best suffix can change the result.
+  if (!Regexes.empty() && Regexes.front().Entry < Best &&
+      (!AnyRegex || AnyRegex->match(Header))) {
+    for (const RegexEntry &Regex : Regexes) {
+      if (Regex.Entry >= Best)
+        break;
+      if (Regex.Regex.match(Header)) {
+        Best = Regex.Entry;
+        break;
+      }
+    }
+  }
+  return Best == NoEntry ? llvm::StringRef() : MappedHeaders[Best];
+}
+
 llvm::StringRef
 HeaderMapCollector::getMappedHeader(llvm::StringRef Header) const {
   auto Iter = HeaderMappingTable.find(Header);
@@ -21,13 +125,38 @@ HeaderMapCollector::getMappedHeader(llvm::StringRef Header) const {
   // If there is no complete header name mapping for this header, check the
   // regex header mapping.
   if (RegexHeaderMappingTable) {
-    for (const auto &Entry : *RegexHeaderMappingTable) {
-      if (llvm::Regex(Entry.first).match(Header))
-        return Entry.second;
-    }
+    auto Cached = RegexMappedHeaders.find(Header);
+    if (Cached == RegexMappedHeaders.end())
+      Cached = RegexMappedHeaders
+                   .insert(std::make_pair(
+                       Header, RegexHeaderMappingTable->lookup(Header)))
+                   .first;
+    if (!Cached->second.empty())
+      return Cached->second;
   }
   return Header;
 }
 
+llvm::Expected<HeaderMapCollector::RegexHeaderMap>
+readRegexHeaderMap(llvm::StringRef Contents) {
+  HeaderMapCollector::RegexHeaderMap Table;
+  llvm::SmallVector<llvm::StringRef, 16> Lines;
+  Contents.split(Lines, '\n');
+  for (unsigned I = 0; I < Lines.size(); ++I) {
+    llvm::StringRef Line = Lines[I].trim();
+    if (Line.empty() || Line.startswith("#"))
+      continue;
+    size_t Separator = Line.find_first_of(" \t");
+    llvm::StringRef Pattern = Line.substr(0, Separator);
+    llvm::StringRef Header = Line.substr(Pattern.size()).trim();
+    if (Header.empty())
+      return llvm::make_error<llvm::StringError>(
+          "line " + llvm::Twine(I + 1) + ": expected a pattern and a header",
+          llvm::inconvertibleErrorCode());
+    Table.emplace_back(Pattern.str(), Header.str());
+  }
+  return std::move(Table);
+}
+
 } // namespace find_all_symbols
 } // namespace clang
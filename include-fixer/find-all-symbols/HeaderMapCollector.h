@@ -11,7 +11,9 @@
 #define LLVM_CLANG_TOOLS_EXTRA_FIND_ALL_SYMBOLS_HEADER_MAP_COLLECTOR_H
 
 #include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Error.h"
 #include "llvm/Support/Regex.h"
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -23,11 +25,52 @@ namespace find_all_symbols {
 class HeaderMapCollector {
 public:
   typedef llvm::StringMap<std::string> HeaderMap;
-  typedef std::vector<std::pair<const char *, const char *>> RegexHeaderMap;
+  typedef std::vector<std::pair<std::string, std::string>> RegexHeaderMap;
+
+  /// \brief A \c RegexHeaderMap compiled for lookups.
+  ///
+  /// Patterns that are a literal suffix anchored with '$', like all patterns
+  /// of the STL header map, are stored reversed in a trie, so that a lookup
+  /// walks the header name backwards once instead of matching every pattern.
+  /// A '.' in such a pattern matches only a dot. The other patterns are
+  /// compiled once, and first matched together to skip them when none
+  /// matches. As with the table, the first matching entry wins.
+  class CompiledRegexHeaderMap {
+  public:
+    explicit CompiledRegexHeaderMap(const RegexHeaderMap &Table);
+
+    /// Returns the header name of the first entry of the table matching
+    /// \p Header, or an empty string if there is none.
+    llvm::StringRef lookup(llvm::StringRef Header) const;
+
+  private:
+    enum : unsigned { NoEntry = ~0u };
+
+    struct SuffixNode {
+      /// The next character of the reversed suffix and its node.
+      std::vector<std::pair<char, unsigned>> Children;
+      /// The first entry whose suffix ends at this node, or \c NoEntry.
+      unsigned Entry = NoEntry;
+    };
+
+    struct RegexEntry {
+      unsigned Entry;
+      // Regex::match isn't const.
+      mutable llvm::Regex Regex;
+    };
+
+    /// The trie of reversed suffixes, rooted at the first node.
+    std::vector<SuffixNode> SuffixTrie;
+    std::vector<RegexEntry> Regexes;
+    /// Matches if any of \c Regexes matches. Only set for several regexes.
+    std::unique_ptr<llvm::Regex> AnyRegex;
+    std::vector<std::string> MappedHeaders;
+  };
 
   HeaderMapCollector() : RegexHeaderMappingTable(nullptr) {}
 
-  explicit HeaderMapCollector(const RegexHeaderMap *RegexHeaderMappingTable)
+  explicit HeaderMapCollector(
+      const CompiledRegexHeaderMap *RegexHeaderMappingTable)
       : RegexHeaderMappingTable(RegexHeaderMappingTable) {}
 
   void addHeaderMapping(llvm::StringRef OrignalHeaderPath,
@@ -47,10 +90,22 @@ private:
   HeaderMap HeaderMappingTable;
 
   // A map from header patterns to header names.
-  // This is a reference to a hard-coded map.
-  const RegexHeaderMap *const RegexHeaderMappingTable;
+  // This is a reference to a map shared by all translation units.
+  const CompiledRegexHeaderMap *const RegexHeaderMappingTable;
+
+  /// The result of looking up headers in \c RegexHeaderMappingTable, as the
+  /// same headers are looked up for each of their symbols. Empty if the
+  /// header is not mapped.
+  mutable llvm::StringMap<llvm::StringRef> RegexMappedHeaders;
 };
 
+/// \brief Reads a \c RegexHeaderMap with one entry per line, a pattern and a
+/// header name separated by whitespace, e.g.
+///   bits/stl_vector.h$ <vector>
+/// Empty lines and lines starting with '#' are ignored.
+llvm::Expected<HeaderMapCollector::RegexHeaderMap>
+readRegexHeaderMap(llvm::StringRef Contents);
+
 } // namespace find_all_symbols
 } // namespace clang
 
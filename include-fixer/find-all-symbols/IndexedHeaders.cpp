@@ -0,0 +1,72 @@
+//===-- IndexedHeaders.cpp - headers indexed by a run -----------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "IndexedHeaders.h"
+#include "clang/Basic/SourceManager.h"
+#include "llvm/ADT/Hashing.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include <vector>
+
+namespace clang {
+namespace find_all_symbols {
+
+std::pair<unsigned, bool>
+IndexedHeaderSet::insert(const llvm::sys::fs::UniqueID &ID,
+                         uint64_t ContentHash) {
+  std::lock_guard<std::mutex> Lock(Mutex);
+  auto Inserted = Headers.insert(
+      std::make_pair(std::make_pair(ID, ContentHash), Headers.size()));
+  return std::make_pair(Inserted.first->second, Inserted.second);
+}
+
+llvm::Optional<unsigned>
+TranslationUnitHeaders::getIndexedHeader(const SourceManager &SM,
+                                         SourceLocation Loc) {
+  FileID FID = SM.getFileID(Loc);
+  auto Cached = FileHeaders.find(FID);
+  if (Cached != FileHeaders.end())
+    return Cached->second;
+
+  llvm::Optional<unsigned> &Result = FileHeaders[FID];
+  const FileEntry *File = SM.getFileEntryForID(FID);
+  // Symbols are only reported for headers.
+  if (!File || FID == SM.getMainFileID())
+    return Result;
+  bool Invalid = false;
+  const llvm::MemoryBuffer *Buffer = SM.getBuffer(FID, &Invalid);
+  if (Invalid)
+    return Result;
+
+  auto Header = Headers.insert(File->getUniqueID(),
+                               llvm::hash_value(Buffer->getBuffer()));
+  IncludedHeaders.insert(Header.first);
+  // Headers without include guards can be included several times.
+  if (Header.second)
+    IndexedHeaders.insert(Header.first);
+  if (IndexedHeaders.count(Header.first))
+    Result = Header.first;
+  return Result;
+}
+
+void TranslationUnitHeaders::reportSymbols(SymbolReporter &Reporter,
+                                           llvm::StringRef FileName) {
+  for (const auto &HeaderAndSymbols : HeaderSymbols)
+    Reporter.reportHeaderSymbols(HeaderAndSymbols.first,
+                                 HeaderAndSymbols.second);
+  Reporter.reportIncludedHeaders(
+      FileName, std::vector<unsigned>(IncludedHeaders.begin(),
+                                      IncludedHeaders.end()));
+  FileHeaders.clear();
+  IncludedHeaders.clear();
+  IndexedHeaders.clear();
+  HeaderSymbols.clear();
+}
+
+} // namespace find_all_symbols
+} // namespace clang
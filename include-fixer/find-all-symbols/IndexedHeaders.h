@@ -0,0 +1,87 @@
+//===-- IndexedHeaders.h - headers indexed by a run -------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_TOOLS_EXTRA_FIND_ALL_SYMBOLS_INDEXED_HEADERS_H
+#define LLVM_CLANG_TOOLS_EXTRA_FIND_ALL_SYMBOLS_INDEXED_HEADERS_H
+
+#include "SymbolInfo.h"
+#include "SymbolReporter.h"
+#include "clang/Basic/SourceLocation.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/Optional.h"
+#include "llvm/Support/FileSystem.h"
+#include <map>
+#include <mutex>
+#include <set>
+
+namespace clang {
+class SourceManager;
+
+namespace find_all_symbols {
+
+/// \brief The headers of all translation units indexed by one run, shared by
+/// the threads indexing them, so that the symbols of each header are reported
+/// only once.
+///
+/// Headers are identified by the unique ID of the file and a hash of its
+/// contents, so that a header that changes during the run is indexed again.
+/// The symbols of a header are taken from the first translation unit that
+/// includes it, even if other translation units include it with different
+/// macros defined.
+class IndexedHeaderSet {
+public:
+  /// \brief Returns the id of the header, and true if this is the first time
+  /// the header is seen.
+  std::pair<unsigned, bool> insert(const llvm::sys::fs::UniqueID &ID,
+                                   uint64_t ContentHash);
+
+private:
+  std::mutex Mutex;
+  std::map<std::pair<llvm::sys::fs::UniqueID, uint64_t>, unsigned> Headers;
+};
+
+/// \brief The headers of one translation unit. Collects the symbols of the
+/// headers the translation unit indexes first.
+class TranslationUnitHeaders {
+public:
+  explicit TranslationUnitHeaders(IndexedHeaderSet &Headers)
+      : Headers(Headers) {}
+
+  /// \brief Returns the id of the header containing the file location \p Loc
+  /// if this translation unit reports its symbols, and None if another one
+  /// does or if \p Loc is not in a header.
+  llvm::Optional<unsigned> getIndexedHeader(const SourceManager &SM,
+                                            SourceLocation Loc);
+
+  /// \brief Adds \p Signals to \p Symbol, declared in the header \p HeaderId.
+  void addSymbol(unsigned HeaderId, const SymbolInfo &Symbol,
+                 const SymbolInfo::Signals &Signals) {
+    HeaderSymbols[HeaderId][Symbol] += Signals;
+  }
+
+  /// \brief Reports the symbols of the headers indexed by the translation unit
+  /// \p FileName and all headers it includes to \p Reporter.
+  void reportSymbols(SymbolReporter &Reporter, llvm::StringRef FileName);
+
+private:
+  IndexedHeaderSet &Headers;
+  /// \brief The result of \c getIndexedHeader for each file.
+  llvm::DenseMap<FileID, llvm::Optional<unsigned>> FileHeaders;
+  /// \brief The ids of the headers with symbols included by the translation
+  /// unit, indexed by it or not.
+  std::set<unsigned> IncludedHeaders;
+  /// \brief The ids of the headers indexed by the translation unit.
+  std::set<unsigned> IndexedHeaders;
+  std::map<unsigned, SymbolInfo::SignalMap> HeaderSymbols;
+};
+
+} // namespace find_all_symbols
+} // namespace clang
+
+#endif // LLVM_CLANG_TOOLS_EXTRA_FIND_ALL_SYMBOLS_INDEXED_HEADERS_H
@@ -119,14 +119,18 @@ bool SymbolAndSignals::operator==(const SymbolAndSignals& RHS) const {
 
 bool WriteSymbolInfosToStream(llvm::raw_ostream &OS,
                               const SymbolInfo::SignalMap &Symbols) {
-  llvm::yaml::Output yout(OS);
-  for (const auto &Symbol : Symbols) {
-    SymbolAndSignals S{Symbol.first, Symbol.second};
-    yout << S;
-  }
+  SymbolInfoYAMLWriter Writer(OS);
+  for (const auto &Symbol : Symbols)
+    Writer.write(Symbol.first, Symbol.second);
   return true;
 }
 
+void SymbolInfoYAMLWriter::write(const SymbolInfo &Symbol,
+                                 const SymbolInfo::Signals &Signals) {
+  SymbolAndSignals S{Symbol, Signals};
+  Out << S;
+}
+
 std::vector<SymbolAndSignals> ReadSymbolInfosFromYAML(llvm::StringRef Yaml) {
   std::vector<SymbolAndSignals> Symbols;
   llvm::yaml::Input yin(Yaml);
@@ -134,6 +134,19 @@ struct SymbolAndSignals {
 bool WriteSymbolInfosToStream(llvm::raw_ostream &OS,
                               const SymbolInfo::SignalMap &Symbols);
 
+/// \brief Writes symbols to a YAML stream one at a time, in the format of
+/// \c WriteSymbolInfosToStream, so that they don't need to be collected in a
+/// \c SignalMap first.
+class SymbolInfoYAMLWriter {
+public:
+  explicit SymbolInfoYAMLWriter(llvm::raw_ostream &OS) : Out(OS) {}
+
+  void write(const SymbolInfo &Symbol, const SymbolInfo::Signals &Signals);
+
+private:
+  llvm::yaml::Output Out;
+};
+
 /// \brief Read SymbolInfos from a YAML document.
 std::vector<SymbolAndSignals> ReadSymbolInfosFromYAML(llvm::StringRef Yaml);
 
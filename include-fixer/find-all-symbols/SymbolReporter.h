@@ -11,6 +11,7 @@
 #define LLVM_CLANG_TOOLS_EXTRA_FIND_ALL_SYMBOLS_SYMBOL_REPORTER_H
 
 #include "SymbolInfo.h"
+#include "llvm/ADT/ArrayRef.h"
 
 namespace clang {
 namespace find_all_symbols {
@@ -22,6 +23,21 @@ public:
 
   virtual void reportSymbols(llvm::StringRef FileName,
                              const SymbolInfo::SignalMap &Symbols) = 0;
+
+  /// \brief Reports the symbols declared in the header \p HeaderId.
+  ///
+  /// Only used when indexing with an \c IndexedHeaderSet. The symbols of each
+  /// header are then reported once, by the first translation unit including
+  /// it, and \c reportSymbols only gets the symbols declared or used in the
+  /// main file.
+  virtual void reportHeaderSymbols(unsigned HeaderId,
+                                   const SymbolInfo::SignalMap &Symbols) {}
+
+  /// \brief Reports the ids of all headers with symbols that the translation
+  /// unit \p FileName includes. Only used when indexing with an
+  /// \c IndexedHeaderSet.
+  virtual void reportIncludedHeaders(llvm::StringRef FileName,
+                                     llvm::ArrayRef<unsigned> HeaderIds) {}
 };
 
 } // namespace find_all_symbols
@@ -7,18 +7,25 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "BinarySymbolDatabase.h"
 #include "FindAllSymbolsAction.h"
 #include "STLPostfixHeaderMap.h"
 #include "SymbolInfo.h"
 #include "SymbolReporter.h"
 #include "clang/ASTMatchers/ASTMatchFinder.h"
 #include "clang/ASTMatchers/ASTMatchers.h"
+#include "clang/Basic/FileManager.h"
+#include "clang/Basic/FileSystemOptions.h"
 #include "clang/Frontend/CompilerInstance.h"
 #include "clang/Frontend/FrontendActions.h"
+#include "clang/Frontend/PCHContainerOperations.h"
 #include "clang/Lex/Preprocessor.h"
+#include "clang/Tooling/ArgumentsAdjusters.h"
 #include "clang/Tooling/CommonOptionsParser.h"
 #include "clang/Tooling/Tooling.h"
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/Hashing.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/CommandLine.h"
@@ -27,11 +34,13 @@
 #include "llvm/Support/Path.h"
 #include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <atomic>
 #include <map>
-#include <mutex>
 #include <set>
 #include <string>
 #include <system_error>
+#include <thread>
 #include <vector>
 
 using namespace clang::tooling;
@@ -59,6 +68,41 @@ static cl::opt<std::string> MergeDir("merge-dir", cl::desc(R"(
 The directory for merging symbols.)"),
                                      cl::init(""),
                                      cl::cat(FindAllSymbolsCategory));
+
+static cl::opt<std::string> Convert("convert", cl::desc(R"(
+A YAML symbol database to write in the binary format.)"),
+                                    cl::init(""),
+                                    cl::cat(FindAllSymbolsCategory));
+
+static cl::opt<bool> Binary("binary", cl::desc(R"(
+Write the merged symbols in the binary format, which
+clang-include-fixer loads with -db=binary.)"),
+                            cl::init(false),
+                            cl::cat(FindAllSymbolsCategory));
+
+static cl::opt<std::string> MergedOutput("merged-output", cl::desc(R"(
+Index the source files in this process and write a single
+merged database to this file instead of one file per
+translation unit to -output-dir. The symbols of each header
+are only collected in the first translation unit that
+includes it.)"),
+                                         cl::init(""),
+                                         cl::cat(FindAllSymbolsCategory));
+
+static cl::opt<unsigned> Jobs("j", cl::desc(R"(
+The number of threads indexing files with -merged-output.
+0 uses all cores.)"),
+                              cl::init(0), cl::cat(FindAllSymbolsCategory));
+
+static cl::opt<std::string> HeaderMapFile("header-map", cl::desc(R"(
+A file mapping header paths to the headers that should be
+included instead, checked before the built-in STL header
+map. Each line has a regex, usually a path suffix ending
+with '$', and the header, e.g.
+  mylib/internal/vector_impl.h$ <mylib/vector.h>)"),
+                                          cl::init(""),
+                                          cl::cat(FindAllSymbolsCategory));
+
 namespace clang {
 namespace find_all_symbols {
 
@@ -76,55 +120,301 @@ public:
   }
 };
 
-bool Merge(llvm::StringRef MergeDir, llvm::StringRef OutputFile) {
+bool WriteSymbols(llvm::StringRef OutputFile,
+                  const SymbolInfo::SignalMap &Symbols, bool Binary) {
   std::error_code EC;
-  SymbolInfo::SignalMap Symbols;
-  std::mutex SymbolMutex;
-  auto AddSymbols = [&](ArrayRef<SymbolAndSignals> NewSymbols) {
-    // Synchronize set accesses.
-    std::unique_lock<std::mutex> LockGuard(SymbolMutex);
-    for (const auto &Symbol : NewSymbols) {
-      Symbols[Symbol.Symbol] += Symbol.Signals;
+  llvm::raw_fd_ostream OS(OutputFile, EC, llvm::sys::fs::F_None);
+  if (EC) {
+    llvm::errs() << "Can't open '" << OutputFile << "': " << EC.message()
+                 << '\n';
+    return false;
+  }
+  if (Binary)
+    return WriteSymbolInfosToBinary(OS, Symbols);
+  return WriteSymbolInfosToStream(OS, Symbols);
+}
+
+/// \brief Merges the symbols found by several workers without locks.
+///
+/// Each worker adds symbols to its own maps, one per shard. Symbols are
+/// assigned to shards by a hash of their name, so the maps of different shards
+/// never contain the same symbol and each shard can be reduced independently.
+class ShardedSymbolMerger {
+public:
+  ShardedSymbolMerger(unsigned NumWorkers, unsigned NumShards)
+      : Maps(NumWorkers, std::vector<SymbolInfo::SignalMap>(NumShards)) {}
+
+  /// \brief Adds \p Signals to \p Symbol. Only called from the worker
+  /// \p Worker.
+  void add(unsigned Worker, const SymbolInfo &Symbol,
+           const SymbolInfo::Signals &Signals) {
+    auto &Shards = Maps[Worker];
+    Shards[llvm::hash_value(Symbol.getName()) % Shards.size()][Symbol] +=
+        Signals;
+  }
+
+  /// \brief Merges the maps of all workers into the maps of the first one,
+  /// reducing the shards in parallel on \p Pool.
+  void reduce(llvm::ThreadPool &Pool) {
+    for (unsigned Shard = 0; Shard < Maps[0].size(); ++Shard) {
+      Pool.async([this, Shard]() {
+        SymbolInfo::SignalMap &Result = Maps[0][Shard];
+        for (unsigned Worker = 1; Worker < Maps.size(); ++Worker) {
+          SymbolInfo::SignalMap &Symbols = Maps[Worker][Shard];
+          // Merge the smaller map into the larger one.
+          if (Symbols.size() > Result.size())
+            Result.swap(Symbols);
+          for (const auto &Symbol : Symbols)
+            Result[Symbol.first] += Symbol.second;
+          SymbolInfo::SignalMap().swap(Symbols);
+        }
+      });
     }
-  };
+    Pool.wait();
+  }
 
-  // Load all symbol files in MergeDir.
-  {
-    llvm::ThreadPool Pool;
-    for (llvm::sys::fs::directory_iterator Dir(MergeDir, EC), DirEnd;
-         Dir != DirEnd && !EC; Dir.increment(EC)) {
-      // Parse YAML files in parallel.
-      Pool.async(
-          [&AddSymbols](std::string Path) {
-            auto Buffer = llvm::MemoryBuffer::getFile(Path);
-            if (!Buffer) {
-              llvm::errs() << "Can't open " << Path << "\n";
-              return;
-            }
-            std::vector<SymbolAndSignals> Symbols =
-                ReadSymbolInfosFromYAML(Buffer.get()->getBuffer());
-            for (auto &Symbol : Symbols) {
-              // Only count one occurrence per file, to avoid spam.
-              Symbol.Signals.Seen = std::min(Symbol.Signals.Seen, 1u);
-              Symbol.Signals.Used = std::min(Symbol.Signals.Used, 1u);
-            }
-            // FIXME: Merge without creating such a heavy contention point.
-            AddSymbols(Symbols);
-          },
-          Dir->path());
+  /// \brief Calls \p Callback for every symbol in order, merging the sorted
+  /// shards on the fly. Must be called after \c reduce.
+  void forEachSymbol(llvm::function_ref<void(const SymbolInfo &,
+                                             const SymbolInfo::Signals &)>
+                         Callback) const {
+    typedef std::pair<SymbolInfo::SignalMap::const_iterator,
+                      SymbolInfo::SignalMap::const_iterator>
+        Cursor;
+    std::vector<Cursor> Cursors;
+    for (const SymbolInfo::SignalMap &Shard : Maps[0]) {
+      if (!Shard.empty())
+        Cursors.emplace_back(Shard.begin(), Shard.end());
+    }
+    // A min-heap of the next symbol of each shard.
+    auto Greater = [](const Cursor &LHS, const Cursor &RHS) {
+      return RHS.first->first < LHS.first->first;
+    };
+    std::make_heap(Cursors.begin(), Cursors.end(), Greater);
+    while (!Cursors.empty()) {
+      std::pop_heap(Cursors.begin(), Cursors.end(), Greater);
+      Cursor &Next = Cursors.back();
+      Callback(Next.first->first, Next.first->second);
+      if (++Next.first == Next.second)
+        Cursors.pop_back();
+      else
+        std::push_heap(Cursors.begin(), Cursors.end(), Greater);
     }
   }
 
+private:
+  /// \brief The maps of each worker, by shard.
+  std::vector<std::vector<SymbolInfo::SignalMap>> Maps;
+};
+
+/// \brief Writes the symbols of \p Merger to \p OutputFile. YAML is written
+/// while the shards are merged, the binary format needs all symbols first.
+bool WriteSymbols(llvm::StringRef OutputFile,
+                  const ShardedSymbolMerger &Merger, bool Binary) {
+  if (Binary) {
+    SymbolInfo::SignalMap Symbols;
+    Merger.forEachSymbol(
+        [&Symbols](const SymbolInfo &Symbol,
+                   const SymbolInfo::Signals &Signals) {
+          Symbols.emplace_hint(Symbols.end(), Symbol, Signals);
+        });
+    return WriteSymbols(OutputFile, Symbols, Binary);
+  }
+  std::error_code EC;
   llvm::raw_fd_ostream OS(OutputFile, EC, llvm::sys::fs::F_None);
   if (EC) {
     llvm::errs() << "Can't open '" << OutputFile << "': " << EC.message()
                  << '\n';
     return false;
   }
-  WriteSymbolInfosToStream(OS, Symbols);
+  SymbolInfoYAMLWriter Writer(OS);
+  Merger.forEachSymbol(
+      [&Writer](const SymbolInfo &Symbol, const SymbolInfo::Signals &Signals) {
+        Writer.write(Symbol, Signals);
+      });
   return true;
 }
 
+bool Merge(llvm::StringRef MergeDir, llvm::StringRef OutputFile) {
+  std::error_code EC;
+  std::vector<std::string> Paths;
+  for (llvm::sys::fs::directory_iterator Dir(MergeDir, EC), DirEnd;
+       Dir != DirEnd && !EC; Dir.increment(EC))
+    Paths.push_back(Dir->path());
+
+  unsigned NumThreads = std::max(1u, std::thread::hardware_concurrency());
+  ShardedSymbolMerger Merger(NumThreads, NumThreads);
+  {
+    llvm::ThreadPool Pool(NumThreads);
+    // Parse YAML files in parallel. Each worker takes the next file until all
+    // files are parsed.
+    std::atomic<size_t> NextPath(0);
+    for (unsigned Worker = 0; Worker < NumThreads; ++Worker) {
+      Pool.async([&Paths, &NextPath, &Merger, Worker]() {
+        for (size_t I = NextPath++; I < Paths.size(); I = NextPath++) {
+          auto Buffer = llvm::MemoryBuffer::getFile(Paths[I]);
+          if (!Buffer) {
+            llvm::errs() << "Can't open " << Paths[I] << "\n";
+            continue;
+          }
+          for (const auto &Symbol :
+               ReadSymbolInfosFromYAML(Buffer.get()->getBuffer())) {
+            // Only count one occurrence per file, to avoid spam.
+            Merger.add(Worker, Symbol.Symbol,
+                       SymbolInfo::Signals(std::min(Symbol.Signals.Seen, 1u),
+                                           std::min(Symbol.Signals.Used, 1u)));
+          }
+        }
+      });
+    }
+    Pool.wait();
+    Merger.reduce(Pool);
+  }
+
+  return WriteSymbols(OutputFile, Merger, Binary);
+}
+
+bool ConvertToBinary(llvm::StringRef YamlFile, llvm::StringRef OutputFile) {
+  auto Buffer = llvm::MemoryBuffer::getFile(YamlFile);
+  if (!Buffer) {
+    llvm::errs() << "Can't open '" << YamlFile
+                 << "': " << Buffer.getError().message() << '\n';
+    return false;
+  }
+  SymbolInfo::SignalMap Symbols;
+  for (const auto &Symbol : ReadSymbolInfosFromYAML(Buffer.get()->getBuffer()))
+    Symbols[Symbol.Symbol] += Symbol.Signals;
+  return WriteSymbols(OutputFile, Symbols, /*Binary=*/true);
+}
+
+/// \brief Collects the symbols reported by the translation units a worker
+/// thread indexes with an \c IndexedHeaderSet.
+class MergingReporter : public SymbolReporter {
+public:
+  MergingReporter(ShardedSymbolMerger &Merger, unsigned Worker)
+      : Merger(Merger), Worker(Worker) {}
+
+  void reportSymbols(StringRef FileName,
+                     const SymbolInfo::SignalMap &Symbols) override {
+    for (const auto &Symbol : Symbols) {
+      // Only count one occurrence per file, as Merge does.
+      Merger.add(Worker, Symbol.first,
+                 SymbolInfo::Signals(std::min(Symbol.second.Seen, 1u),
+                                     std::min(Symbol.second.Used, 1u)));
+    }
+  }
+
+  void reportHeaderSymbols(unsigned HeaderId,
+                           const SymbolInfo::SignalMap &Symbols) override {
+    std::vector<SymbolInfo> &Declared = HeaderSymbols[HeaderId];
+    for (const auto &Symbol : Symbols)
+      Declared.push_back(Symbol.first);
+  }
+
+  void reportIncludedHeaders(StringRef FileName,
+                             ArrayRef<unsigned> HeaderIds) override {
+    for (unsigned HeaderId : HeaderIds)
+      ++IncludeCounts[HeaderId];
+  }
+
+  /// \brief Adds the symbols of the headers this worker indexed, seen once per
+  /// translation unit including their header. \p IncludeCounts are the
+  /// include counts of all workers.
+  void addHeaderSymbols(const std::map<unsigned, unsigned> &IncludeCounts) {
+    for (const auto &HeaderAndSymbols : HeaderSymbols) {
+      auto Count = IncludeCounts.find(HeaderAndSymbols.first);
+      unsigned Seen = Count == IncludeCounts.end() ? 1 : Count->second;
+      for (const SymbolInfo &Symbol : HeaderAndSymbols.second)
+        Merger.add(Worker, Symbol, SymbolInfo::Signals(Seen, 0));
+    }
+    HeaderSymbols.clear();
+  }
+
+  /// \brief The number of translation units including each header.
+  std::map<unsigned, unsigned> IncludeCounts;
+
+private:
+  ShardedSymbolMerger &Merger;
+  const unsigned Worker;
+  /// \brief The symbols declared in each header indexed by this worker.
+  std::map<unsigned, std::vector<SymbolInfo>> HeaderSymbols;
+};
+
+/// \brief Runs \p Factory on all compile commands of \p File.
+///
+/// Unlike \c ClangTool, this doesn't change the working directory of the
+/// process, so it can be used from several threads at the same time. The
+/// directory of the compile command is passed to the compiler instead.
+void IndexFile(StringRef File, const CompilationDatabase &Compilations,
+               FrontendActionFactory &Factory) {
+  static int StaticSymbol;
+  std::string MainExecutable =
+      llvm::sys::fs::getMainExecutable("find-all-symbols", &StaticSymbol);
+  ArgumentsAdjuster Adjuster = combineAdjusters(getClangStripOutputAdjuster(),
+                                                getClangSyntaxOnlyAdjuster());
+
+  std::string AbsolutePath = getAbsolutePath(File);
+  for (CompileCommand &Command :
+       Compilations.getCompileCommands(AbsolutePath)) {
+    CommandLineArguments CommandLine =
+        Adjuster(Command.CommandLine, Command.Filename);
+    CommandLine[0] = MainExecutable;
+    CommandLine.insert(CommandLine.begin() + 1,
+                       "-working-directory=" + Command.Directory);
+
+    FileSystemOptions FileSystemOpts;
+    FileSystemOpts.WorkingDir = Command.Directory;
+    IntrusiveRefCntPtr<FileManager> Files(new FileManager(FileSystemOpts));
+    ToolInvocation Invocation(std::move(CommandLine), &Factory, Files.get(),
+                              std::make_shared<PCHContainerOperations>());
+    if (!Invocation.run())
+      llvm::errs() << "Error while processing " << AbsolutePath << ".\n";
+  }
+}
+
+/// \brief Indexes \p Files on several threads and writes the merged symbols
+/// to \p OutputFile.
+bool IndexAndMerge(const CompilationDatabase &Compilations,
+                   ArrayRef<std::string> Files,
+                   const HeaderMapCollector::RegexHeaderMap &HeaderMap,
+                   llvm::StringRef OutputFile) {
+  unsigned NumThreads =
+      Jobs ? Jobs : std::max(1u, std::thread::hardware_concurrency());
+  ShardedSymbolMerger Merger(NumThreads, NumThreads);
+  std::vector<std::unique_ptr<MergingReporter>> Reporters;
+  for (unsigned Worker = 0; Worker < NumThreads; ++Worker)
+    Reporters.push_back(llvm::make_unique<MergingReporter>(Merger, Worker));
+  IndexedHeaderSet IndexedHeaders;
+
+  llvm::ThreadPool Pool(NumThreads);
+  std::atomic<size_t> NextFile(0);
+  for (unsigned Worker = 0; Worker < NumThreads; ++Worker) {
+    Pool.async([&, Worker]() {
+      FindAllSymbolsActionFactory Factory(Reporters[Worker].get(),
+                                          &HeaderMap, &IndexedHeaders);
+      for (size_t I = NextFile++; I < Files.size(); I = NextFile++)
+        IndexFile(Files[I], Compilations, Factory);
+    });
+  }
+  Pool.wait();
+
+  // A header is indexed by one worker, but included by translation units
+  // indexed by any worker.
+  std::map<unsigned, unsigned> IncludeCounts;
+  for (const auto &Reporter : Reporters) {
+    for (const auto &HeaderAndCount : Reporter->IncludeCounts)
+      IncludeCounts[HeaderAndCount.first] += HeaderAndCount.second;
+  }
+  for (const auto &Reporter : Reporters) {
+    MergingReporter *R = Reporter.get();
+    Pool.async([R, &IncludeCounts]() { R->addHeaderSymbols(IncludeCounts); });
+  }
+  Pool.wait();
+  Merger.reduce(Pool);
+
+  return WriteSymbols(OutputFile, Merger, Binary);
+}
+
 } // namespace clang
 } // namespace find_all_symbols
 
@@ -142,11 +432,42 @@ int main(int argc, const char **argv) {
     clang::find_all_symbols::Merge(MergeDir, sources[0]);
     return 0;
   }
+  if (!Convert.empty())
+    return clang::find_all_symbols::ConvertToBinary(Convert, sources[0]) ? 0
+                                                                         : 1;
+
+  clang::find_all_symbols::HeaderMapCollector::RegexHeaderMap HeaderMap;
+  if (!HeaderMapFile.empty()) {
+    auto Buffer = llvm::MemoryBuffer::getFile(HeaderMapFile);
+    if (!Buffer) {
+      llvm::errs() << "Can't open " << HeaderMapFile << ": "
+                   << Buffer.getError().message() << "\n";
+      return 1;
+    }
+    auto Table =
+        clang::find_all_symbols::readRegexHeaderMap((*Buffer)->getBuffer());
+    if (!Table) {
+      llvm::errs() << HeaderMapFile << ": "
+                   << llvm::toString(Table.takeError()) << "\n";
+      return 1;
+    }
+    HeaderMap = std::move(*Table);
+  }
+  const auto *STLHeaderMap = clang::find_all_symbols::getSTLPostfixHeaderMap();
+  HeaderMap.insert(HeaderMap.end(), STLHeaderMap->begin(),
+                   STLHeaderMap->end());
+
+  if (!MergedOutput.empty())
+    return clang::find_all_symbols::IndexAndMerge(
+               OptionsParser.getCompilations(), sources, HeaderMap,
+               MergedOutput)
+               ? 0
+               : 1;
 
   clang::find_all_symbols::YamlReporter Reporter;
 
   auto Factory =
       llvm::make_unique<clang::find_all_symbols::FindAllSymbolsActionFactory>(
-          &Reporter, clang::find_all_symbols::getSTLPostfixHeaderMap());
+          &Reporter, &HeaderMap);
   return Tool.run(Factory.get());
 }
@@ -7,6 +7,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "../BinarySymbolIndex.h"
 #include "../IncludeFixer.h"
 #include "../YamlSymbolIndex.h"
 #include "clang/Frontend/CompilerInstance.h"
@@ -62,6 +63,27 @@ public:
     }
 
     std::string InputFile = CI.getFrontendOpts().Inputs[0].getFile();
+    if (DB == "binary") {
+      auto CreateBinaryIdx =
+          [=]() -> std::unique_ptr<include_fixer::SymbolIndex> {
+        SmallString<128> AbsolutePath(tooling::getAbsolutePath(InputFile));
+        auto SymbolIdx =
+            !Input.empty()
+                ? include_fixer::BinarySymbolIndex::createFromFile(Input)
+                : include_fixer::BinarySymbolIndex::createFromDirectory(
+                      llvm::sys::path::parent_path(AbsolutePath),
+                      "find_all_symbols_db.bin");
+        if (!SymbolIdx) {
+          llvm::errs() << "Couldn't load binary db: "
+                       << llvm::toString(SymbolIdx.takeError()) << '\n';
+          return nullptr;
+        }
+        return std::move(*SymbolIdx);
+      };
+      SymbolIndexMgr->addSymbolIndex(std::move(CreateBinaryIdx));
+      return true;
+    }
+
     auto CreateYamlIdx = [=]() -> std::unique_ptr<include_fixer::SymbolIndex> {
       llvm::ErrorOr<std::unique_ptr<include_fixer::YamlSymbolIndex>> SymbolIdx(
           nullptr);
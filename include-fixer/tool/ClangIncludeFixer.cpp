@@ -7,6 +7,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "BinarySymbolIndex.h"
 #include "FuzzySymbolIndex.h"
 #include "InMemorySymbolIndex.h"
 #include "IncludeFixer.h"
@@ -87,13 +88,16 @@ enum DatabaseFormatTy {
   fixed,     ///< Hard-coded mapping.
   yaml,      ///< Yaml database created by find-all-symbols.
   fuzzyYaml, ///< Yaml database with fuzzy-matched identifiers.
+  binary,    ///< Binary database created by find-all-symbols.
 };
 
 cl::opt<DatabaseFormatTy> DatabaseFormat(
     "db", cl::desc("Specify input format"),
     cl::values(clEnumVal(fixed, "Hard-coded mapping"),
                clEnumVal(yaml, "Yaml database created by find-all-symbols"),
-               clEnumVal(fuzzyYaml, "Yaml database, with fuzzy-matched names")),
+               clEnumVal(fuzzyYaml, "Yaml database, with fuzzy-matched names"),
+               clEnumVal(binary,
+                         "Binary database created by find-all-symbols")),
     cl::init(yaml), cl::cat(IncludeFixerCategory));
 
 cl::opt<std::string> Input("input",
@@ -218,6 +222,28 @@ createSymbolIndexManager(StringRef FilePath) {
     SymbolIndexMgr->addSymbolIndex(std::move(CreateYamlIdx));
     break;
   }
+  case binary: {
+    auto CreateBinaryIdx =
+        [=]() -> std::unique_ptr<include_fixer::SymbolIndex> {
+      // If we don't have any input file, look in the directory of the first
+      // file and its parents.
+      SmallString<128> AbsolutePath(tooling::getAbsolutePath(FilePath));
+      auto DB = !Input.empty()
+                    ? include_fixer::BinarySymbolIndex::createFromFile(Input)
+                    : include_fixer::BinarySymbolIndex::createFromDirectory(
+                          llvm::sys::path::parent_path(AbsolutePath),
+                          "find_all_symbols_db.bin");
+      if (!DB) {
+        llvm::errs() << "Couldn't load binary db: "
+                     << llvm::toString(DB.takeError()) << '\n';
+        return nullptr;
+      }
+      return std::move(*DB);
+    };
+
+    SymbolIndexMgr->addSymbolIndex(std::move(CreateBinaryIdx));
+    break;
+  }
   case fuzzyYaml: {
     // This mode is not very useful, because we don't correct the identifier.
     // It's main purpose is to expose FuzzySymbolIndex to tests.
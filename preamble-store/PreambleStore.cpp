@@ -0,0 +1,277 @@
+//===--- PreambleStore.cpp - Shared precompiled preambles -----------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "PreambleStore.h"
+#include "clang/Basic/SourceManager.h"
+#include "clang/Driver/Options.h"
+#include "clang/Frontend/CompilerInstance.h"
+#include "clang/Frontend/CompilerInvocation.h"
+#include "clang/Frontend/FrontendActions.h"
+#include "clang/Frontend/Utils.h"
+#include "clang/Lex/Lexer.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Option/ArgList.h"
+#include "llvm/Option/OptTable.h"
+#include "llvm/Option/Option.h"
+#include "llvm/Support/Chrono.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+using namespace clang;
+using namespace preamble;
+
+PreambleStore::PreambleStore(std::string Directory,
+                             std::shared_ptr<PCHContainerOperations> PCHs)
+    : Directory(std::move(Directory)), PCHs(std::move(PCHs)) {}
+
+/// Returns \p Path made absolute against \p WorkingDir, without "." and ".."
+/// components.
+static SmallString<128> makeAbsolute(StringRef Path, StringRef WorkingDir) {
+  SmallString<128> Result;
+  if (!llvm::sys::path::is_absolute(Path))
+    Result = WorkingDir;
+  llvm::sys::path::append(Result, Path);
+  llvm::sys::path::remove_dots(Result, /*remove_dot_dot=*/true);
+  return Result;
+}
+
+/// Returns the key of the preamble \p PreambleText of \p MainFile, compiled
+/// with \p CommandLine.
+static std::string computeKey(ArrayRef<std::string> CommandLine,
+                              StringRef MainFile, StringRef PreambleText) {
+  llvm::MD5 Hash;
+  auto AddString = [&Hash](StringRef S) {
+    Hash.update(S);
+    // Keep the boundaries between strings.
+    Hash.update(StringRef("\0", 1));
+  };
+  AddString(CommandLine.front());
+
+  std::vector<const char *> ArgStrs;
+  for (const std::string &Arg : CommandLine.drop_front())
+    ArgStrs.push_back(Arg.c_str());
+  std::unique_ptr<llvm::opt::OptTable> Opts(driver::createDriverOptTable());
+  unsigned MissingArgIndex, MissingArgCount;
+  llvm::opt::InputArgList Args =
+      Opts->ParseArgs(ArgStrs, MissingArgIndex, MissingArgCount);
+
+  // Inputs are compared to the main file after making them absolute against
+  // the working directory of the command, like the driver does.
+  SmallString<128> WorkingDir(
+      Args.getLastArgValue(driver::options::OPT_working_directory));
+  if (WorkingDir.empty())
+    llvm::sys::fs::current_path(WorkingDir);
+  SmallString<128> AbsoluteMainFile = makeAbsolute(MainFile, WorkingDir);
+  // The name of the main file doesn't matter, but its directory does: quoted
+  // includes are looked up relative to it.
+  AddString(llvm::sys::path::parent_path(AbsoluteMainFile));
+
+  for (const llvm::opt::Arg *A : Args) {
+    const llvm::opt::Option &Opt = A->getOption();
+    if (Opt.getKind() == llvm::opt::Option::InputClass &&
+        makeAbsolute(A->getValue(), WorkingDir).str() == AbsoluteMainFile)
+      continue;
+    // Compilation databases use a different output and dependency file for
+    // every file. This covers both the separate and the joined spelling.
+    if (Opt.matches(driver::options::OPT_o) ||
+        Opt.matches(driver::options::OPT_MF) ||
+        Opt.matches(driver::options::OPT_MT) ||
+        Opt.matches(driver::options::OPT_MQ))
+      continue;
+    AddString(A->getAsString(Args));
+  }
+  AddString(PreambleText);
+
+  llvm::MD5::MD5Result Result;
+  Hash.final(Result);
+  SmallString<32> Key;
+  llvm::MD5::stringifyResult(Result, Key);
+  return Key.str();
+}
+
+llvm::Optional<StoredPreamble>
+PreambleStore::getPreamble(ArrayRef<std::string> CommandLine,
+                           StringRef MainFile, StringRef Contents) {
+  std::vector<const char *> Args;
+  for (const std::string &Arg : CommandLine)
+    Args.push_back(Arg.c_str());
+  IntrusiveRefCntPtr<DiagnosticsEngine> Diags =
+      CompilerInstance::createDiagnostics(new DiagnosticOptions,
+                                          new IgnoringDiagConsumer);
+  std::shared_ptr<CompilerInvocation> Invocation(
+      createInvocationFromCommandLine(Args, Diags));
+  if (!Invocation)
+    return llvm::None;
+
+  std::pair<unsigned, bool> Bounds =
+      Lexer::ComputePreamble(Contents, *Invocation->getLangOpts());
+  if (Bounds.first == 0)
+    return llvm::None;
+  StringRef PreambleText = Contents.substr(0, Bounds.first);
+
+  std::string Key = computeKey(CommandLine, MainFile, PreambleText);
+  SmallString<128> PCHPath(Directory);
+  llvm::sys::path::append(PCHPath, Key + ".pch");
+  SmallString<128> DepsPath(Directory);
+  llvm::sys::path::append(DepsPath, Key + ".deps");
+
+  std::shared_ptr<std::mutex> BuildLock;
+  {
+    std::lock_guard<std::mutex> Lock(BuildLocksLock);
+    auto &Entry = BuildLocks[Key];
+    if (!Entry)
+      Entry = std::make_shared<std::mutex>();
+    BuildLock = Entry;
+  } // unlock BuildLocksLock
+
+  bool Available;
+  {
+    std::lock_guard<std::mutex> Lock(*BuildLock);
+    Available = isUpToDate(PCHPath, DepsPath) ||
+                build(*Invocation, MainFile, PreambleText, PCHPath, DepsPath);
+  } // unlock *BuildLock
+
+  {
+    std::lock_guard<std::mutex> Lock(BuildLocksLock);
+    // The last request for this preamble removes its lock, so that the map
+    // only holds the preambles being requested. References to the lock are
+    // only taken and dropped with BuildLocksLock held.
+    if (BuildLock.use_count() == 2)
+      BuildLocks.erase(Key);
+    BuildLock.reset();
+  } // unlock BuildLocksLock
+
+  if (!Available)
+    return llvm::None;
+  return StoredPreamble{PCHPath.str(), Bounds.first, Bounds.second};
+}
+
+void PreambleStore::addPreambleArguments(
+    const StoredPreamble &Preamble, std::vector<std::string> &CommandLine) {
+  CommandLine.push_back("-include-pch");
+  CommandLine.push_back(Preamble.PCHPath);
+  // Skip the part of the main file that is in the PCH.
+  CommandLine.push_back("-Xclang");
+  CommandLine.push_back("-preamble-bytes=" + std::to_string(Preamble.Size) +
+                        "," + (Preamble.EndsAtStartOfLine ? "1" : "0"));
+  // The PCH may have been built for another file with the same preamble. The
+  // files it includes were already checked by getPreamble().
+  CommandLine.push_back("-Xclang");
+  CommandLine.push_back("-fno-validate-pch");
+}
+
+bool PreambleStore::isUpToDate(StringRef PCHPath, StringRef DepsPath) {
+  if (!llvm::sys::fs::exists(PCHPath))
+    return false;
+  auto Deps = llvm::MemoryBuffer::getFile(DepsPath);
+  if (!Deps)
+    return false;
+
+  // Every line has the size, the modification time and the path of a file.
+  SmallVector<StringRef, 64> Lines;
+  (*Deps)->getBuffer().split(Lines, '\n', /*MaxSplit=*/-1,
+                             /*KeepEmpty=*/false);
+  for (StringRef Line : Lines) {
+    unsigned long long Size, ModificationTime;
+    StringRef Rest = Line;
+    if (Rest.consumeInteger(10, Size) || !Rest.consume_front(" ") ||
+        Rest.consumeInteger(10, ModificationTime) || !Rest.consume_front(" "))
+      return false;
+    llvm::sys::fs::file_status Status;
+    if (llvm::sys::fs::status(Rest, Status) || Status.getSize() != Size ||
+        static_cast<unsigned long long>(llvm::sys::toTimeT(
+            Status.getLastModificationTime())) != ModificationTime)
+      return false;
+  }
+  return true;
+}
+
+/// Writes \p Contents to \p Path by renaming a temporary file.
+static bool writeAtomically(StringRef Path, StringRef Contents) {
+  SmallString<128> TempPath;
+  int FD;
+  if (llvm::sys::fs::createUniqueFile(Path + "-%%%%%%%%.tmp", FD, TempPath))
+    return false;
+  {
+    llvm::raw_fd_ostream OS(FD, /*shouldClose=*/true);
+    OS << Contents;
+    if (OS.has_error()) {
+      OS.clear_error();
+      llvm::sys::fs::remove(TempPath);
+      return false;
+    }
+  }
+  if (llvm::sys::fs::rename(TempPath, Path)) {
+    llvm::sys::fs::remove(TempPath);
+    return false;
+  }
+  return true;
+}
+
+bool PreambleStore::build(const CompilerInvocation &Invocation,
+                          StringRef MainFile, StringRef PreambleText,
+                          StringRef PCHPath, StringRef DepsPath) {
+  if (llvm::sys::fs::create_directories(Directory))
+    return false;
+  SmallString<128> TempPCHPath;
+  if (llvm::sys::fs::createUniqueFile(PCHPath + "-%%%%%%%%.tmp", TempPCHPath))
+    return false;
+
+  // Build the PCH the same way ASTUnit builds its preambles: the main file is
+  // remapped to only contain the preamble.
+  auto PreambleInvocation = std::make_shared<CompilerInvocation>(Invocation);
+  FrontendOptions &FrontendOpts = PreambleInvocation->getFrontendOpts();
+  FrontendOpts.ProgramAction = frontend::GeneratePCH;
+  FrontendOpts.OutputFile = TempPCHPath.str();
+  PreprocessorOptions &PPOpts = PreambleInvocation->getPreprocessorOpts();
+  PPOpts.PrecompiledPreambleBytes = std::make_pair(0u, false);
+  PPOpts.ImplicitPCHInclude.clear();
+  PPOpts.RetainRemappedFileBuffers = false;
+  // Like ASTUnit, make sure the last directive of the preamble is terminated.
+  PPOpts.addRemappedFile(MainFile, llvm::MemoryBuffer::getMemBufferCopy(
+                                       (PreambleText + "\n").str(), MainFile)
+                                       .release());
+
+  CompilerInstance Clang(PCHs);
+  Clang.setInvocation(std::move(PreambleInvocation));
+  Clang.createDiagnostics(new IgnoringDiagConsumer, /*ShouldOwnClient=*/true);
+  GeneratePCHAction Action;
+  // Preambles with errors are left to ASTUnit, which reports the errors.
+  if (!Clang.ExecuteAction(Action) ||
+      Clang.getDiagnostics().hasErrorOccurred()) {
+    llvm::sys::fs::remove(TempPCHPath);
+    return false;
+  }
+
+  std::string Deps;
+  llvm::raw_string_ostream DepsOS(Deps);
+  const SourceManager &SM = Clang.getSourceManager();
+  for (auto It = SM.fileinfo_begin(), End = SM.fileinfo_end(); It != End;
+       ++It) {
+    const FileEntry *File = It->first;
+    if (StringRef(File->getName()) == MainFile)
+      continue;
+    // Relative paths are relative to the working directory of the command.
+    SmallString<128> Name(File->getName());
+    Clang.getFileManager().makeAbsolutePath(Name);
+    DepsOS << File->getSize() << ' '
+           << static_cast<unsigned long long>(File->getModificationTime())
+           << ' ' << Name << '\n';
+  }
+  DepsOS.flush();
+
+  // Write the dependencies last, their presence marks the PCH as complete.
+  if (llvm::sys::fs::rename(TempPCHPath, PCHPath)) {
+    llvm::sys::fs::remove(TempPCHPath);
+    return false;
+  }
+  return writeAtomically(DepsPath, Deps);
+}
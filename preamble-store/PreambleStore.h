@@ -0,0 +1,88 @@
+//===--- PreambleStore.h - Shared precompiled preambles ---------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Stores precompiled preambles in a directory, addressed by a hash of the
+// preamble's text and the flags it is compiled with. Files that start with the
+// same includes and are compiled with the same flags share a single preamble,
+// and preambles survive restarts of the tools using them. clangd and the
+// clang-tidy server share this store, so it depends on neither of them.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_TOOLS_EXTRA_PREAMBLE_STORE_PREAMBLESTORE_H
+#define LLVM_CLANG_TOOLS_EXTRA_PREAMBLE_STORE_PREAMBLESTORE_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/StringMap.h"
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace clang {
+class CompilerInvocation;
+class PCHContainerOperations;
+
+namespace preamble {
+
+/// A precompiled preamble in a PreambleStore.
+struct StoredPreamble {
+  /// Path of the PCH file.
+  std::string PCHPath;
+  /// Size of the preamble in bytes, as computed by Lexer::ComputePreamble.
+  unsigned Size;
+  bool EndsAtStartOfLine;
+};
+
+class PreambleStore {
+public:
+  PreambleStore(std::string Directory,
+                std::shared_ptr<PCHContainerOperations> PCHs);
+
+  /// Returns the preamble of \p MainFile with contents \p Contents, compiled
+  /// with \p CommandLine. It is built if it's not in the store yet, or if any
+  /// of the files it includes changed since it was built. Returns None if
+  /// there is no preamble or it could not be built without errors.
+  ///
+  /// This function is thread-safe. Concurrent requests for the same preamble
+  /// wait for a single build.
+  llvm::Optional<StoredPreamble> getPreamble(ArrayRef<std::string> CommandLine,
+                                             StringRef MainFile,
+                                             StringRef Contents);
+
+  /// Appends the arguments that make the compiler use \p Preamble instead of
+  /// parsing the preamble of the main file.
+  static void addPreambleArguments(const StoredPreamble &Preamble,
+                                   std::vector<std::string> &CommandLine);
+
+private:
+  /// Returns true if the PCH at \p PCHPath and its dependency file at
+  /// \p DepsPath exist and none of the files it includes changed.
+  static bool isUpToDate(StringRef PCHPath, StringRef DepsPath);
+  /// Builds the PCH for \p PreambleText and writes it to \p PCHPath, and the
+  /// list of files it includes to \p DepsPath. Both are replaced atomically,
+  /// so that other processes never see partially written files.
+  bool build(const CompilerInvocation &Invocation, StringRef MainFile,
+             StringRef PreambleText, StringRef PCHPath, StringRef DepsPath);
+
+  std::string Directory;
+  std::shared_ptr<PCHContainerOperations> PCHs;
+
+  /// A lock for every preamble that is being requested, used to build each
+  /// preamble only once. Entries are removed when their last request
+  /// finishes. Guarded by BuildLocksLock.
+  llvm::StringMap<std::shared_ptr<std::mutex>> BuildLocks;
+  std::mutex BuildLocksLock;
+};
+
+} // namespace preamble
+} // namespace clang
+
+#endif
@@ -0,0 +1,2 @@
+class H1 { H1(int); };
+class H2 { H2(int); };
@@ -0,0 +1 @@
+void withNote(int A);
@@ -0,0 +1 @@
+class S { S(int); };
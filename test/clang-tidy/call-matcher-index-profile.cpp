@@ -0,0 +1,15 @@
+// RUN: clang-tidy -checks='-*,google-runtime-memset' -enable-check-profile %s -- 2>&1 | FileCheck -implicit-check-not=call-matcher-index %s
+
+// The checks run by the call matcher index are profiled under their own name.
+
+void *memset(void *, int, __SIZE_TYPE__);
+
+void f(char *P) {
+  memset(P, 1, 0);
+}
+// CHECK: :[[@LINE-2]]:3: warning: memset of size zero
+// CHECK: ---Wall Time---
+// CHECK: {{%\) +}}google-runtime-memset
+// CHECK: Total
+// CHECK: Matches  Diagnostics  Callbacks (wall)       Decls      Skipped  Name
+// CHECK-NEXT: {{^ +1 +1 +[0-9.]+s +[0-9]+ +0}}  google-runtime-memset
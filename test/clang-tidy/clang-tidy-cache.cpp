@@ -0,0 +1,28 @@
+// RUN: rm -rf %t.dir && mkdir -p %t.dir
+// RUN: echo 'int *A = 0;' > %t.dir/a.cpp
+// RUN: echo '#include "header.h"' > %t.dir/b.cpp
+// RUN: echo 'int *H = 0;' > %t.dir/header.h
+// RUN: clang-tidy -checks=-*,modernize-use-nullptr -header-filter=.* -cache-dir=%t.dir/cache %t.dir/a.cpp %t.dir/b.cpp -- 2>&1 | FileCheck %s -check-prefix=CHECK-MISS
+// RUN: clang-tidy -checks=-*,modernize-use-nullptr -header-filter=.* -cache-dir=%t.dir/cache %t.dir/a.cpp %t.dir/b.cpp -- 2>&1 | FileCheck %s -check-prefix=CHECK-HIT
+// RUN: echo 'int *HH = 0;' > %t.dir/header.h
+// RUN: clang-tidy -checks=-*,modernize-use-nullptr -header-filter=.* -cache-dir=%t.dir/cache %t.dir/a.cpp %t.dir/b.cpp -- 2>&1 | FileCheck %s -check-prefix=CHECK-CHANGED
+// RUN: clang-tidy -checks=-*,modernize-use-nullptr -cache-dir=%t.dir/cache %t.dir/a.cpp %t.dir/b.cpp -- 2>&1 | FileCheck %s -check-prefix=CHECK-OPTIONS
+
+// CHECK-MISS: a.cpp:1:10: warning: use nullptr
+// CHECK-MISS: header.h:1:10: warning: use nullptr
+// CHECK-MISS: Cache: 0 hits, 2 misses.
+
+// Cached results are reported the same way.
+// CHECK-HIT: a.cpp:1:10: warning: use nullptr
+// CHECK-HIT: header.h:1:10: warning: use nullptr
+// CHECK-HIT: Cache: 2 hits, 0 misses.
+
+// Changing an included file invalidates only the translation units using it.
+// CHECK-CHANGED: a.cpp:1:10: warning: use nullptr
+// CHECK-CHANGED: header.h:1:11: warning: use nullptr
+// CHECK-CHANGED: Cache: 1 hits, 1 misses.
+
+// Results depend on the options.
+// CHECK-OPTIONS: a.cpp:1:10: warning: use nullptr
+// CHECK-OPTIONS-NOT: header.h:1:11: warning
+// CHECK-OPTIONS: Cache: 0 hits, 2 misses.
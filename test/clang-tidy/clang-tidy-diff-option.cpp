@@ -0,0 +1,22 @@
+// REQUIRES: shell
+// RUN: sed 's/placeholder_for_f/f/' %s > %t.cpp
+// RUN: not diff -U0 %s %t.cpp | clang-tidy -diff=- -checks=-*,modernize-use-override %t.cpp -- -std=c++11 2>&1 | FileCheck %s
+// RUN: not diff -U3 %s %t.cpp > %t.diff
+// RUN: clang-tidy -diff=%t.diff -checks=-*,modernize-use-override %t.cpp -- -std=c++11 2>&1 | FileCheck %s
+// RUN: diff -U0 %s %s | clang-tidy -diff=- -checks=-*,modernize-use-override %t.cpp -- -std=c++11 2>&1 | FileCheck -check-prefix=CHECK-EMPTY %s
+// RUN: not clang-tidy -diff=%t.diff -line-filter='[]' -checks=-*,modernize-use-override %t.cpp -- -std=c++11 2>&1 | FileCheck -check-prefix=CHECK-CONFLICT %s
+struct A {
+  virtual void f() {}
+  virtual void g() {}
+};
+// CHECK-NOT: warning:
+struct B : public A {
+  void placeholder_for_f() {}
+// CHECK: [[@LINE-1]]:8: warning: annotate this
+  void g() {}
+};
+// Context lines of the diff are not considered changed.
+// CHECK-NOT: warning:
+
+// CHECK-EMPTY: No lines added by the diff.
+// CHECK-CONFLICT: Error: -diff and -line-filter can't be used together.
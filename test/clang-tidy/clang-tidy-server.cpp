@@ -0,0 +1,50 @@
+// RUN: rm -rf %t.dir && mkdir -p %t.dir
+// RUN: echo '#include "header.h"' > %t.dir/a.cpp
+// RUN: echo 'int *A = 0;' >> %t.dir/a.cpp
+// RUN: echo 'int *H = 0;' > %t.dir/header.h
+// RUN: echo '{"file": "%t.dir/a.cpp", "command": ["clang++", "-c", "%t.dir/a.cpp"]}' > %t.dir/requests
+// RUN: echo '{"file": "%t.dir/a.cpp", "command": ["clang++", "-c", "%t.dir/a.cpp"], "contents": "#include \"header.h\"\nint *B = 0;\nint *C = 0;\n"}' >> %t.dir/requests
+// RUN: echo '{"reload": true}' >> %t.dir/requests
+// RUN: echo 'not a request' >> %t.dir/requests
+// RUN: clang-tidy -server -checks=-*,modernize-use-nullptr -header-filter=.* < %t.dir/requests 2> %t.dir/errors | FileCheck %s
+// RUN: FileCheck -input-file=%t.dir/errors -check-prefix=CHECK-ERRORS %s
+// RUN: clang-tidy -server -server-preamble-dir=%t.dir/preambles -checks=-*,modernize-use-nullptr -header-filter=.* < %t.dir/requests 2> %t.dir/errors | FileCheck %s -check-prefix=CHECK-PREAMBLE
+
+// Every request is answered with a YAML document, in the order of requests.
+// CHECK: MainSourceFile: {{.*}}a.cpp
+// CHECK: DiagnosticName: modernize-use-nullptr
+// CHECK: FilePath: {{.*}}header.h
+// CHECK: DiagnosticName: modernize-use-nullptr
+// CHECK: FilePath: {{.*}}a.cpp
+// CHECK-NEXT: FileOffset: 29
+// CHECK: {{^\.\.\.$}}
+
+// The contents of the request are checked instead of the file.
+// CHECK: MainSourceFile: {{.*}}a.cpp
+// CHECK: FilePath: {{.*}}header.h
+// CHECK: FilePath: {{.*}}a.cpp
+// CHECK-NEXT: FileOffset: 29
+// CHECK: FilePath: {{.*}}a.cpp
+// CHECK-NEXT: FileOffset: 41
+// CHECK: {{^\.\.\.$}}
+
+// Reloads and invalid requests are answered without diagnostics.
+// CHECK: MainSourceFile: ''
+// CHECK: {{^\.\.\.$}}
+// CHECK: MainSourceFile: ''
+// CHECK: {{^\.\.\.$}}
+
+// CHECK-ERRORS: Invalid request: not a request
+
+// The declarations loaded from the precompiled preamble are still matched, so
+// the results are the same as without a preamble.
+// CHECK-PREAMBLE: MainSourceFile: {{.*}}a.cpp
+// CHECK-PREAMBLE: FilePath: {{.*}}header.h
+// CHECK-PREAMBLE: FilePath: {{.*}}a.cpp
+// CHECK-PREAMBLE-NEXT: FileOffset: 29
+// CHECK-PREAMBLE: MainSourceFile: {{.*}}a.cpp
+// CHECK-PREAMBLE: FilePath: {{.*}}header.h
+// CHECK-PREAMBLE: FilePath: {{.*}}a.cpp
+// CHECK-PREAMBLE-NEXT: FileOffset: 29
+// CHECK-PREAMBLE: FilePath: {{.*}}a.cpp
+// CHECK-PREAMBLE-NEXT: FileOffset: 41
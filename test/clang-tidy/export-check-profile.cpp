@@ -0,0 +1,25 @@
+// RUN: clang-tidy -checks='-*,google-explicit-constructor,llvm-include-order' -export-check-profile=%t.json %s -- 2>&1 | FileCheck -check-prefix=CHECK-OUTPUT %s
+// RUN: FileCheck -input-file=%t.json %s
+// RUN: clang-tidy -checks='-*,google-explicit-constructor' -enable-check-profile %s -- 2>&1 | FileCheck -check-prefix=CHECK-TEXT %s
+
+class A { A(int); };
+class B { B(int); };
+class C { C(int); explicit C(double); };
+// CHECK-OUTPUT: :[[@LINE-3]]:11: warning: single-argument constructors
+// CHECK-OUTPUT-NOT: Total
+
+// CHECK: "checks": [
+// CHECK-NEXT: {"name": "google-explicit-constructor", "matches": {{[0-9]+}}, "diagnostics": 3, "matcherWallTime": {{[0-9.]+}}, {{.*}}"callbackWallTime": {{[0-9.]+}}, {{.*}}"callbackMemory": {{-?[0-9]+}}},
+// CHECK-NEXT: {"name": "llvm-include-order", "matches": 0, "diagnostics": 0, "matcherWallTime": 0.000000, {{.*}}"callbackMemory": 0}
+// CHECK-NEXT: ],
+// CHECK-NEXT: "translationUnits": [
+// CHECK-NEXT: {"file": "{{.*}}export-check-profile.cpp", "thread": 0, "frontendWallTime": {{[0-9.]+}}, {{.*}}"frontendMemory": {{-?[0-9]+}}, "checksWallTime": {{.*}}"analyzerWallTime":
+// CHECK-NEXT: ],
+// CHECK-NEXT: "traceEvents": [
+// CHECK-NEXT: {"name": "Frontend", "cat": "clang-tidy", "ph": "X", "pid": 0, "tid": 0, "ts": 0, "dur": {{[0-9]+}}, "args": {"file": "{{.*}}export-check-profile.cpp"}}
+// CHECK-NEXT: {"name": "Checks",
+// CHECK-NEXT: {"name": "Analyzer",
+// CHECK-NEXT: ]
+
+// CHECK-TEXT: Matches  Diagnostics  Callbacks (wall)       Decls      Skipped  Name
+// CHECK-TEXT-NEXT: {{^ +[0-9]+ +3 +[0-9.]+s +[0-9]+ +0}}  google-explicit-constructor
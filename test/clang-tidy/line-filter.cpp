@@ -24,4 +24,5 @@ class C { C(int); };
 
 // CHECK-NOT: warning:
 
-// CHECK: Suppressed 3 warnings (1 in non-user code, 2 due to line filter)
+// CHECK: Suppressed 2 warnings (2 due to line filter)
+// CHECK: Skipped 1 declarations in non-user code.
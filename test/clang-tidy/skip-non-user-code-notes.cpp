@@ -0,0 +1,10 @@
+// RUN: clang-tidy -checks='-*,readability-inconsistent-declaration-parameter-name' %s -- -I %S/Inputs/skip-non-user-code | FileCheck %s
+
+// A warning in a header that doesn't pass the header filter is still reported
+// if one of its notes is in the main file, so checks with such notes are run on
+// the declarations of all headers.
+#include "notes.h"
+
+void withNote(int B);
+// CHECK: notes.h:1:6: warning: function 'withNote' has 1 other declaration with different parameter names
+// CHECK: :[[@LINE-2]]:6: note: the 1st inconsistent declaration seen here
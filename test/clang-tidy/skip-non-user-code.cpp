@@ -0,0 +1,31 @@
+// RUN: clang-tidy -checks='-*,google-explicit-constructor' -enable-check-profile %s -- -I %S/Inputs/skip-non-user-code -isystem %S/Inputs/skip-non-user-code/system 2>%t-default.prof | FileCheck %s
+// RUN: FileCheck -input-file=%t-default.prof -check-prefix=CHECK-PROFILE %s
+// RUN: clang-tidy -checks='-*,google-explicit-constructor' -enable-check-profile -header-filter='header\.h' %s -- -I %S/Inputs/skip-non-user-code -isystem %S/Inputs/skip-non-user-code/system 2>%t-header.prof | FileCheck --check-prefix=CHECK-HEADER %s
+// RUN: FileCheck -input-file=%t-header.prof -check-prefix=CHECK-HEADER-PROFILE %s
+// RUN: clang-tidy -checks='-*,google-explicit-constructor' -enable-check-profile -header-filter='.*' -system-headers %s -- -I %S/Inputs/skip-non-user-code -isystem %S/Inputs/skip-non-user-code/system 2>%t-all.prof | FileCheck --check-prefix=CHECK-ALL %s
+// RUN: FileCheck -input-file=%t-all.prof -check-prefix=CHECK-ALL-PROFILE %s
+// RUN: clang-tidy -checks='-*,google-explicit-constructor,misc-forward-declaration-namespace' -enable-check-profile %s -- -I %S/Inputs/skip-non-user-code -isystem %S/Inputs/skip-non-user-code/system 2>%t-mixed.prof | FileCheck %s
+// RUN: FileCheck -input-file=%t-mixed.prof -check-prefix=CHECK-MIXED-PROFILE %s
+
+#include "header.h"
+#include <system-header.h>
+// CHECK-NOT: warning:
+// CHECK-HEADER: header.h:1:12: warning: single-argument constructors
+// CHECK-HEADER: header.h:2:12: warning: single-argument constructors
+// CHECK-HEADER-NOT: system-header.h{{.*}} warning:
+// CHECK-ALL: header.h:1:12: warning: single-argument constructors
+// CHECK-ALL: header.h:2:12: warning: single-argument constructors
+// CHECK-ALL: system-header.h:1:11: warning: single-argument constructors
+
+class A { A(int); };
+// CHECK: :[[@LINE-1]]:11: warning: single-argument constructors
+// CHECK-HEADER: :[[@LINE-2]]:11: warning: single-argument constructors
+// CHECK-ALL: :[[@LINE-3]]:11: warning: single-argument constructors
+
+// The matchers are not run on the declarations of headers that don't pass the
+// filters, except for checks that need matches in all headers.
+// CHECK-PROFILE: {{ }}3  google-explicit-constructor
+// CHECK-HEADER-PROFILE: {{ }}1  google-explicit-constructor
+// CHECK-ALL-PROFILE: {{ }}0  google-explicit-constructor
+// CHECK-MIXED-PROFILE: {{ }}3  google-explicit-constructor
+// CHECK-MIXED-PROFILE: {{ }}0  misc-forward-declaration-namespace
@@ -0,0 +1,3 @@
+#include "header.h"
+
+Shared UseShared;
@@ -0,0 +1,3 @@
+#include "header.h"
+
+int OnlyInB;
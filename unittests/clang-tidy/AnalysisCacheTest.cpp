@@ -0,0 +1,65 @@
+#include "AnalysisCache.h"
+#include "llvm/ADT/STLExtras.h"
+#include "gtest/gtest.h"
+
+namespace clang {
+namespace tidy {
+namespace test {
+
+namespace {
+struct Counter : AnalysisCache::Result {
+  static char ID;
+  explicit Counter(int Value) : Value(Value) {}
+  int Value;
+};
+char Counter::ID;
+
+struct OtherCounter : AnalysisCache::Result {
+  static char ID;
+  explicit OtherCounter(int Value) : Value(Value) {}
+  int Value;
+};
+char OtherCounter::ID;
+} // namespace
+
+TEST(AnalysisCacheTest, ComputesOncePerNodeAndType) {
+  AnalysisCache Cache;
+  int Node1, Node2;
+  int Computed = 0;
+  auto Compute = [&] { return llvm::make_unique<Counter>(++Computed); };
+
+  EXPECT_EQ(1, Cache.get<Counter>(&Node1, Compute).Value);
+  EXPECT_EQ(1, Cache.get<Counter>(&Node1, Compute).Value);
+  EXPECT_EQ(2, Cache.get<Counter>(&Node2, Compute).Value);
+  EXPECT_EQ(2, Computed);
+
+  // Results of different types for the same node are separate.
+  EXPECT_EQ(3, Cache.get<OtherCounter>(&Node1, [&] {
+    return llvm::make_unique<OtherCounter>(++Computed);
+  }).Value);
+
+  Cache.clear();
+  EXPECT_EQ(4, Cache.get<Counter>(&Node1, Compute).Value);
+}
+
+TEST(AnalysisCacheTest, AllowsNestedComputations) {
+  AnalysisCache Cache;
+  int Node;
+  int Inner[100];
+  Counter &Outer = Cache.get<Counter>(&Node, [&] {
+    // Inserting results while computing another one must not invalidate it.
+    for (int I = 0; I < 100; ++I)
+      Cache.get<OtherCounter>(&Inner[I], [&] {
+        return llvm::make_unique<OtherCounter>(I);
+      });
+    return llvm::make_unique<Counter>(42);
+  });
+  EXPECT_EQ(42, Outer.Value);
+  EXPECT_EQ(42, Cache.get<Counter>(&Node, [] {
+    return llvm::make_unique<Counter>(0);
+  }).Value);
+}
+
+} // namespace test
+} // namespace tidy
+} // namespace clang
@@ -0,0 +1,64 @@
+#include "ClangTidy.h"
+#include "ClangTidyTest.h"
+#include "gtest/gtest.h"
+
+namespace clang {
+namespace tidy {
+namespace test {
+
+using namespace ast_matchers;
+
+class CallCheck : public ClangTidyCheck {
+public:
+  CallCheck(StringRef Name, ClangTidyContext *Context)
+      : ClangTidyCheck(Name, Context) {}
+  void registerCallMatchers(CallMatcherIndex *Index) override {
+    auto Matcher = callExpr().bind("call");
+    Index->addMatcher({"::f", "::g", "::n::h"}, Matcher, this);
+    // The same matcher for another callback, and a name registered twice.
+    Index->addMatcher({"::g", "::g"}, Matcher, &Second);
+  }
+  void check(const MatchFinder::MatchResult &Result) override {
+    const auto *Call = Result.Nodes.getNodeAs<CallExpr>("call");
+    diag(Call->getLocStart(), "call");
+  }
+
+private:
+  struct SecondCallback : MatchFinder::MatchCallback {
+    SecondCallback(CallCheck &Check) : Check(Check) {}
+    void run(const MatchFinder::MatchResult &Result) override {
+      const auto *Call = Result.Nodes.getNodeAs<CallExpr>("call");
+      Check.diag(Call->getLocStart(), "second");
+    }
+    CallCheck &Check;
+  } Second{*this};
+};
+
+TEST(CallMatcherIndex, RunsMatchersForNames) {
+  std::vector<ClangTidyError> Errors;
+  runCheckOnCode<CallCheck>("void f(); void g(); namespace n { void f(); }\n"
+                            "void h() { f(); g(); n::f(); (void)&f; }",
+                            &Errors);
+  ASSERT_EQ(3ul, Errors.size());
+  EXPECT_EQ("call", Errors[0].Message.Message);
+  EXPECT_EQ(57u, Errors[0].Message.FileOffset);
+  EXPECT_EQ("call", Errors[1].Message.Message);
+  EXPECT_EQ(62u, Errors[1].Message.FileOffset);
+  EXPECT_EQ("second", Errors[2].Message.Message);
+  EXPECT_EQ(62u, Errors[2].Message.FileOffset);
+}
+
+TEST(CallMatcherIndex, MatchesQualifiedNames) {
+  std::vector<ClangTidyError> Errors;
+  runCheckOnCode<CallCheck>("namespace n { inline namespace v { void h(); } }\n"
+                            "namespace m { void h(); }\n"
+                            "void k() { n::h(); m::h(); }",
+                            &Errors);
+  ASSERT_EQ(1ul, Errors.size());
+  EXPECT_EQ("call", Errors[0].Message.Message);
+  EXPECT_EQ(86u, Errors[0].Message.FileOffset);
+}
+
+} // namespace test
+} // namespace tidy
+} // namespace clang
@@ -29,6 +29,72 @@ TEST(ClangTidyDiagnosticConsumer, SortsErrors) {
   EXPECT_EQ("variable", Errors[1].Message.Message);
 }
 
+static ClangTidyError makeError(StringRef CheckName,
+                                ArrayRef<tooling::Replacement> Replacements) {
+  ClangTidyError Error(CheckName, ClangTidyError::Warning, "",
+                       /*IsWarningAsError=*/false);
+  for (const tooling::Replacement &R : Replacements) {
+    if (llvm::Error Err = Error.Fix[R.getFilePath()].add(R)) {
+      ADD_FAILURE() << llvm::toString(std::move(Err));
+    }
+  }
+  return Error;
+}
+
+TEST(RemoveIncompatibleErrors, KeepsContainingFix) {
+  SmallVector<ClangTidyError, 4> Errors;
+  Errors.push_back(makeError("outer", {{"a.cpp", 10, 20, "x"}}));
+  Errors.push_back(makeError("inner", {{"a.cpp", 15, 5, "y"}}));
+  Errors.push_back(makeError("other-file", {{"b.cpp", 15, 5, "y"}}));
+  removeIncompatibleErrors(Errors);
+  EXPECT_EQ(1u, Errors[0].Fix.size());
+  EXPECT_TRUE(Errors[1].Fix.empty());
+  ASSERT_EQ(1u, Errors[1].Notes.size());
+  EXPECT_EQ("this fix will not be applied because it overlaps with another fix "
+            "from 'outer', which is applied",
+            Errors[1].Notes[0].Message);
+  EXPECT_EQ(1u, Errors[2].Fix.size());
+}
+
+TEST(RemoveIncompatibleErrors, DropsPartiallyOverlappingFixes) {
+  SmallVector<ClangTidyError, 4> Errors;
+  Errors.push_back(makeError("first", {{"a.cpp", 10, 10, "x"}}));
+  Errors.push_back(makeError("second", {{"a.cpp", 15, 10, "y"}}));
+  Errors.push_back(makeError("adjacent", {{"a.cpp", 25, 5, "z"}}));
+  removeIncompatibleErrors(Errors);
+  EXPECT_TRUE(Errors[0].Fix.empty());
+  EXPECT_TRUE(Errors[1].Fix.empty());
+  ASSERT_EQ(1u, Errors[1].Notes.size());
+  EXPECT_EQ("this fix will not be applied because it overlaps with another fix "
+            "from 'first'",
+            Errors[1].Notes[0].Message);
+  EXPECT_EQ(1u, Errors[2].Fix.size());
+}
+
+TEST(RemoveIncompatibleErrors, Insertions) {
+  SmallVector<ClangTidyError, 4> Errors;
+  // Insertions at the bounds of a replacement don't overlap with it.
+  Errors.push_back(makeError("replace", {{"a.cpp", 10, 10, "x"}}));
+  Errors.push_back(makeError("insert-begin", {{"a.cpp", 10, 0, "y"}}));
+  Errors.push_back(makeError("insert-end", {{"a.cpp", 20, 0, "y"}}));
+  // Insertions inside a replacement do.
+  Errors.push_back(makeError("insert-inside", {{"a.cpp", 15, 0, "z"}}));
+  removeIncompatibleErrors(Errors);
+  EXPECT_EQ(1u, Errors[0].Fix.size());
+  EXPECT_EQ(1u, Errors[1].Fix.size());
+  EXPECT_EQ(1u, Errors[2].Fix.size());
+  EXPECT_TRUE(Errors[3].Fix.empty());
+
+  // Insertions of different fixes at the same offset don't overlap, e.g. the
+  // closing braces of nested statements.
+  Errors.clear();
+  Errors.push_back(makeError("insert-a", {{"a.cpp", 10, 0, "}"}}));
+  Errors.push_back(makeError("insert-b", {{"a.cpp", 10, 0, "}"}}));
+  removeIncompatibleErrors(Errors);
+  EXPECT_EQ(1u, Errors[0].Fix.size());
+  EXPECT_EQ(1u, Errors[1].Fix.size());
+}
+
 TEST(GlobList, Empty) {
   GlobList Filter("");
 
@@ -89,6 +155,28 @@ TEST(GlobList, Complex) {
   EXPECT_TRUE(Filter.contains("asdfqwEasdf"));
 }
 
+TEST(GlobList, SeveralStars) {
+  GlobList Filter("a*b*c");
+
+  EXPECT_TRUE(Filter.contains("abc"));
+  EXPECT_TRUE(Filter.contains("axbxc"));
+  EXPECT_TRUE(Filter.contains("abcbc"));
+  EXPECT_FALSE(Filter.contains("acb"));
+  EXPECT_FALSE(Filter.contains("abcb"));
+  EXPECT_FALSE(Filter.contains("ac"));
+}
+
+TEST(GlobList, RepeatedQueries) {
+  GlobList Filter("-*,a*,-ab*");
+
+  for (int I = 0; I < 2; ++I) {
+    EXPECT_TRUE(Filter.contains("a"));
+    EXPECT_TRUE(Filter.contains("ac"));
+    EXPECT_FALSE(Filter.contains("abc"));
+    EXPECT_FALSE(Filter.contains("b"));
+  }
+}
+
 } // namespace test
 } // namespace tidy
 } // namespace clang
@@ -54,6 +54,56 @@ TEST(ParseLineFilter, ValidFilter) {
   EXPECT_EQ(1000u, Options.LineFilter[2].LineRanges[0].second);
 }
 
+TEST(ParseLineFilterFromDiff, AddedLines) {
+  ClangTidyGlobalOptions Options;
+  std::error_code Error = parseLineFilterFromDiff(
+      "diff --git a/dir/file1.cpp b/dir/file1.cpp\n"
+      "--- a/dir/file1.cpp\n"
+      "+++ b/dir/file1.cpp\n"
+      "@@ -1,5 +1,6 @@\n"
+      " int a;\n"
+      "-int b;\n"
+      "+int b2;\n"
+      "+int b3;\n"
+      " int c;\n"
+      "--- int d;\n"
+      "+++ int d2;\n"
+      " int e;\n"
+      "@@ -10 +11 @@\n"
+      "-int f;\n"
+      "+int f2;\n"
+      "\\ No newline at end of file\n"
+      "--- a/file2.h\n"
+      "+++ b/file2.h\n"
+      "@@ -3,2 +2,0 @@\n"
+      "-int g;\n"
+      "-int h;\n"
+      "--- a/file3.h\n"
+      "+++ /dev/null\n"
+      "@@ -1 +0,0 @@\n"
+      "-int i;\n",
+      1, Options);
+  EXPECT_FALSE(Error);
+  ASSERT_EQ(1u, Options.LineFilter.size());
+  EXPECT_EQ("dir/file1.cpp", Options.LineFilter[0].Name);
+  ASSERT_EQ(3u, Options.LineFilter[0].LineRanges.size());
+  EXPECT_EQ(2u, Options.LineFilter[0].LineRanges[0].first);
+  EXPECT_EQ(3u, Options.LineFilter[0].LineRanges[0].second);
+  EXPECT_EQ(5u, Options.LineFilter[0].LineRanges[1].first);
+  EXPECT_EQ(5u, Options.LineFilter[0].LineRanges[1].second);
+  EXPECT_EQ(11u, Options.LineFilter[0].LineRanges[2].first);
+  EXPECT_EQ(11u, Options.LineFilter[0].LineRanges[2].second);
+}
+
+TEST(ParseLineFilterFromDiff, InvalidDiff) {
+  ClangTidyGlobalOptions Options;
+  EXPECT_FALSE(parseLineFilterFromDiff("", 0, Options));
+  EXPECT_TRUE(Options.LineFilter.empty());
+  EXPECT_TRUE(!!parseLineFilterFromDiff("+++ file.cpp\n", 1, Options));
+  EXPECT_TRUE(!!parseLineFilterFromDiff("+++ file.cpp\n@@ -a +1 @@\n", 0,
+                                        Options));
+}
+
 TEST(ParseConfiguration, ValidConfiguration) {
   llvm::ErrorOr<ClangTidyOptions> Options =
       parseConfiguration("Checks: \"-*,misc-*\"\n"
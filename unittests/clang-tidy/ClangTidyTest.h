@@ -30,7 +30,8 @@ public:
   TestClangTidyAction(SmallVectorImpl<std::unique_ptr<ClangTidyCheck>> &Checks,
                       ast_matchers::MatchFinder &Finder,
                       ClangTidyContext &Context)
-      : Checks(Checks), Finder(Finder), Context(Context) {}
+      : Checks(Checks), Finder(Finder), CallMatchers(Finder),
+        Context(Context) {}
 
 private:
   std::unique_ptr<ASTConsumer> CreateASTConsumer(CompilerInstance &Compiler,
@@ -41,6 +42,7 @@ private:
 
     for (auto &Check : Checks) {
       Check->registerMatchers(&Finder);
+      Check->registerCallMatchers(&CallMatchers);
       Check->registerPPCallbacks(Compiler);
     }
     return Finder.newASTConsumer();
@@ -48,6 +50,7 @@ private:
 
   SmallVectorImpl<std::unique_ptr<ClangTidyCheck>> &Checks;
   ast_matchers::MatchFinder &Finder;
+  CallMatcherIndex CallMatchers;
   ClangTidyContext &Context;
 };
 
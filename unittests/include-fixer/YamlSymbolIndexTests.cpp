@@ -0,0 +1,70 @@
+//===-- YamlSymbolIndexTests.cpp - YAML symbol index unit tests -----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "YamlSymbolIndex.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/FileUtilities.h"
+#include "llvm/Support/raw_ostream.h"
+#include "gtest/gtest.h"
+
+using clang::find_all_symbols::SymbolAndSignals;
+using clang::find_all_symbols::SymbolInfo;
+
+namespace clang {
+namespace include_fixer {
+namespace {
+
+SymbolAndSignals symbol(llvm::StringRef Name, llvm::StringRef FilePath,
+                        unsigned Seen) {
+  return {SymbolInfo(Name, SymbolInfo::SymbolKind::Class, FilePath, {}),
+          SymbolInfo::Signals(Seen, 0)};
+}
+
+TEST(YamlSymbolIndexTest, Search) {
+  // Symbols with the same name are interleaved with other symbols and are not
+  // in the order of their file paths or signals.
+  std::vector<SymbolAndSignals> Database = {
+      symbol("foo", "z.h", 1), symbol("bar", "bar.h", 2),
+      symbol("foo", "a.h", 3), symbol("baz", "baz.h", 1),
+      symbol("foo", "m.h", 2),
+  };
+
+  llvm::SmallString<128> Path;
+  int FD;
+  ASSERT_FALSE(
+      llvm::sys::fs::createTemporaryFile("symbols", "yaml", FD, Path));
+  llvm::FileRemover Remover(Path);
+  {
+    llvm::raw_fd_ostream OS(FD, /*shouldClose=*/true);
+    find_all_symbols::SymbolInfoYAMLWriter Writer(OS);
+    for (const SymbolAndSignals &Symbol : Database)
+      Writer.write(Symbol.Symbol, Symbol.Signals);
+  }
+
+  auto Index = YamlSymbolIndex::createFromFile(Path);
+  ASSERT_TRUE(bool(Index));
+
+  // All symbols with the name are returned, in the order of the database.
+  std::vector<SymbolAndSignals> Expected = {Database[0], Database[2],
+                                            Database[4]};
+  EXPECT_EQ(Expected, (*Index)->search("foo"));
+  Expected = {Database[1]};
+  EXPECT_EQ(Expected, (*Index)->search("bar"));
+
+  // Only exact names match.
+  EXPECT_TRUE((*Index)->search("qux").empty());
+  EXPECT_TRUE((*Index)->search("fo").empty());
+  EXPECT_TRUE((*Index)->search("foo_bar").empty());
+  EXPECT_TRUE((*Index)->search("").empty());
+}
+
+} // namespace
+} // namespace include_fixer
+} // namespace clang
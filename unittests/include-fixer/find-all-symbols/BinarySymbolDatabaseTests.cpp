@@ -0,0 +1,97 @@
+//===-- BinarySymbolDatabaseTests.cpp - binary database unit tests --------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "BinarySymbolDatabase.h"
+#include "SymbolInfo.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "gtest/gtest.h"
+#include <string>
+#include <vector>
+
+namespace clang {
+namespace find_all_symbols {
+
+static std::unique_ptr<BinarySymbolDatabase>
+writeAndRead(const SymbolInfo::SignalMap &Symbols) {
+  std::string Contents;
+  llvm::raw_string_ostream OS(Contents);
+  WriteSymbolInfosToBinary(OS, Symbols);
+  OS.flush();
+  auto DB = BinarySymbolDatabase::create(
+      llvm::MemoryBuffer::getMemBufferCopy(Contents, "db.bin"));
+  if (!DB) {
+    ADD_FAILURE() << llvm::toString(DB.takeError());
+    return nullptr;
+  }
+  return std::move(*DB);
+}
+
+TEST(BinarySymbolDatabaseTest, RoundTrip) {
+  typedef SymbolInfo::ContextType ContextType;
+  SymbolInfo Foo("foo", SymbolInfo::SymbolKind::Class, "foo.h",
+                 {{ContextType::Namespace, "a"},
+                  {ContextType::Namespace, "b"}});
+  SymbolInfo OtherFoo("foo", SymbolInfo::SymbolKind::Function, "other.h",
+                      {{ContextType::Record, "C"},
+                       {ContextType::Namespace, "a"},
+                       {ContextType::Namespace, "b"}});
+  SymbolInfo Bar("bar", SymbolInfo::SymbolKind::Variable, "bar.h", {});
+  SymbolInfo::SignalMap Symbols;
+  Symbols[Foo] = SymbolInfo::Signals(3, 1);
+  Symbols[OtherFoo] = SymbolInfo::Signals(2, 0);
+  Symbols[Bar] = SymbolInfo::Signals(1, 1);
+
+  auto DB = writeAndRead(Symbols);
+  ASSERT_TRUE(DB);
+  EXPECT_EQ(3u, DB->size());
+
+  std::vector<SymbolAndSignals> Results = DB->lookup("foo");
+  ASSERT_EQ(2u, Results.size());
+  EXPECT_EQ(Foo, Results[0].Symbol);
+  EXPECT_EQ(SymbolInfo::Signals(3, 1), Results[0].Signals);
+  EXPECT_EQ(OtherFoo, Results[1].Symbol);
+  EXPECT_EQ(SymbolInfo::Signals(2, 0), Results[1].Signals);
+
+  Results = DB->lookup("bar");
+  ASSERT_EQ(1u, Results.size());
+  EXPECT_EQ(Bar, Results[0].Symbol);
+
+  EXPECT_TRUE(DB->lookup("baz").empty());
+  EXPECT_TRUE(DB->lookup("").empty());
+}
+
+TEST(BinarySymbolDatabaseTest, Empty) {
+  auto DB = writeAndRead({});
+  ASSERT_TRUE(DB);
+  EXPECT_EQ(0u, DB->size());
+  EXPECT_TRUE(DB->lookup("foo").empty());
+}
+
+TEST(BinarySymbolDatabaseTest, RejectsInvalidFiles) {
+  auto NotADatabase = BinarySymbolDatabase::create(
+      llvm::MemoryBuffer::getMemBufferCopy("---\nName: foo\n", "db.yaml"));
+  EXPECT_FALSE(NotADatabase);
+  llvm::consumeError(NotADatabase.takeError());
+
+  std::string Contents;
+  llvm::raw_string_ostream OS(Contents);
+  WriteSymbolInfosToBinary(
+      OS, {{SymbolInfo("foo", SymbolInfo::SymbolKind::Class, "foo.h", {}),
+            SymbolInfo::Signals(1, 0)}});
+  OS.flush();
+  auto Truncated = BinarySymbolDatabase::create(
+      llvm::MemoryBuffer::getMemBufferCopy(
+          llvm::StringRef(Contents).drop_back(), "db.bin"));
+  EXPECT_FALSE(Truncated);
+  llvm::consumeError(Truncated.takeError());
+}
+
+} // namespace find_all_symbols
+} // namespace clang
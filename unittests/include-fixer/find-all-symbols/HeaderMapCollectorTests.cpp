@@ -0,0 +1,85 @@
+//===-- HeaderMapCollectorTests.cpp - header map unit tests ---------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "HeaderMapCollector.h"
+#include "STLPostfixHeaderMap.h"
+#include "gtest/gtest.h"
+
+namespace clang {
+namespace find_all_symbols {
+
+TEST(HeaderMapCollectorTest, SuffixPatterns) {
+  HeaderMapCollector::CompiledRegexHeaderMap Map(
+      {{"bits/stl_vector.h$", "<vector>"},
+       {"vector.h$", "<other>"},
+       {"bits/c\\+\\+config.h$", "<iosfwd>"}});
+  EXPECT_EQ("<vector>", Map.lookup("/usr/include/bits/stl_vector.h"));
+  EXPECT_EQ("<other>", Map.lookup("/usr/include/vector.h"));
+  EXPECT_EQ("<iosfwd>", Map.lookup("/usr/include/bits/c++config.h"));
+  // Patterns are anchored at the end only.
+  EXPECT_EQ("<other>", Map.lookup("myvector.h"));
+  EXPECT_EQ("", Map.lookup("bits/stl_vector.h.orig"));
+  // '.' only matches a dot.
+  EXPECT_EQ("", Map.lookup("bits/stl_vectorxh"));
+  EXPECT_EQ("", Map.lookup(""));
+}
+
+TEST(HeaderMapCollectorTest, FirstMatchWins) {
+  HeaderMapCollector::CompiledRegexHeaderMap Map(
+      {{"internal/.*\\.h$", "<first>"},
+       {"internal/a.h$", "<second>"},
+       {"b.h$", "<third>"},
+       {"internal/.*$", "<fourth>"}});
+  EXPECT_EQ("<first>", Map.lookup("internal/a.h"));
+  EXPECT_EQ("<first>", Map.lookup("internal/b.h"));
+  EXPECT_EQ("<third>", Map.lookup("b.h"));
+  EXPECT_EQ("<fourth>", Map.lookup("internal/c.inc"));
+  EXPECT_EQ("", Map.lookup("c.inc"));
+}
+
+TEST(HeaderMapCollectorTest, Collector) {
+  HeaderMapCollector::CompiledRegexHeaderMap Map(
+      {{"internal_.*\\.h$", "<top>"}, {"[invalid$", "<never>"}});
+  HeaderMapCollector Collector(&Map);
+  EXPECT_EQ("<top>", Collector.getMappedHeader("a/internal_b.h"));
+  EXPECT_EQ("<top>", Collector.getMappedHeader("a/internal_b.h"));
+  EXPECT_EQ("a/b.h", Collector.getMappedHeader("a/b.h"));
+  EXPECT_EQ("[invalid", Collector.getMappedHeader("[invalid"));
+  // Mappings added by pragmas take precedence.
+  Collector.addHeaderMapping("a/internal_b.h", "<pragma>");
+  EXPECT_EQ("<pragma>", Collector.getMappedHeader("a/internal_b.h"));
+}
+
+TEST(HeaderMapCollectorTest, STLHeaderMap) {
+  HeaderMapCollector::CompiledRegexHeaderMap Map(*getSTLPostfixHeaderMap());
+  EXPECT_EQ("<vector>", Map.lookup("/usr/include/c++/6/bits/stl_vector.h"));
+  EXPECT_EQ("<string>", Map.lookup("/usr/include/bits/c++allocator.h"));
+  EXPECT_EQ("", Map.lookup("/home/user/project/vector.h"));
+}
+
+TEST(HeaderMapCollectorTest, ReadRegexHeaderMap) {
+  auto Table = readRegexHeaderMap("# A comment.\n"
+                                  "\n"
+                                  "foo/bar.h$ <foo.h>\n"
+                                  "  baz/.*\\.h$\t\"baz.h\"  \r\n");
+  ASSERT_TRUE(static_cast<bool>(Table)) << llvm::toString(Table.takeError());
+  ASSERT_EQ(2u, Table->size());
+  EXPECT_EQ("foo/bar.h$", (*Table)[0].first);
+  EXPECT_EQ("<foo.h>", (*Table)[0].second);
+  EXPECT_EQ("baz/.*\\.h$", (*Table)[1].first);
+  EXPECT_EQ("\"baz.h\"", (*Table)[1].second);
+
+  auto Invalid = readRegexHeaderMap("foo/bar.h$ <foo.h>\nbaz.h$\n");
+  ASSERT_FALSE(static_cast<bool>(Invalid));
+  EXPECT_EQ("line 2: expected a pattern and a header",
+            llvm::toString(Invalid.takeError()));
+}
+
+} // namespace find_all_symbols
+} // namespace clang
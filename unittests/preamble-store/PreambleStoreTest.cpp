@@ -0,0 +1,100 @@
+#include "PreambleStore.h"
+#include "clang/Frontend/PCHContainerOperations.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include "gtest/gtest.h"
+
+namespace clang {
+namespace preamble {
+namespace {
+
+class PreambleStoreTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    ASSERT_FALSE(
+        llvm::sys::fs::createUniqueDirectory("preamble-store-test", Root));
+    StoreDir = path("preambles");
+    Store.reset(new PreambleStore(StoreDir.str(),
+                                  std::make_shared<PCHContainerOperations>()));
+  }
+
+  void TearDown() override { llvm::sys::fs::remove_directories(Root); }
+
+  std::string path(StringRef Name) {
+    SmallString<128> Path(Root);
+    llvm::sys::path::append(Path, Name);
+    return Path.str();
+  }
+
+  std::string writeFile(StringRef Name, StringRef Contents) {
+    std::string Path = path(Name);
+    std::error_code EC;
+    llvm::raw_fd_ostream OS(Path, EC, llvm::sys::fs::F_Text);
+    EXPECT_FALSE(EC);
+    OS << Contents;
+    return Path;
+  }
+
+  llvm::Optional<StoredPreamble> getPreamble(StringRef MainFile,
+                                             StringRef Contents) {
+    std::string Path = writeFile(MainFile, Contents);
+    std::vector<std::string> CommandLine = {"clang", "-fsyntax-only", Path};
+    return Store->getPreamble(CommandLine, Path, Contents);
+  }
+
+  static llvm::sys::fs::UniqueID getID(const StoredPreamble &Preamble) {
+    llvm::sys::fs::UniqueID ID;
+    EXPECT_FALSE(llvm::sys::fs::getUniqueID(Preamble.PCHPath, ID));
+    return ID;
+  }
+
+  SmallString<128> Root;
+  std::string StoreDir;
+  std::unique_ptr<PreambleStore> Store;
+};
+
+const char MainContents[] = "#include \"header.h\"\nint f() { return g(); }\n";
+
+TEST_F(PreambleStoreTest, BuildsReusesAndRebuilds) {
+  writeFile("header.h", "int g();\n");
+
+  auto Built = getPreamble("main.cpp", MainContents);
+  ASSERT_TRUE(Built.hasValue());
+  EXPECT_TRUE(StringRef(Built->PCHPath).startswith(StoreDir));
+  EXPECT_EQ(StringRef(MainContents).find("int f"), Built->Size);
+  llvm::sys::fs::UniqueID BuiltID = getID(*Built);
+
+  // Nothing changed, so the same PCH file is returned without a rebuild.
+  auto Reused = getPreamble("main.cpp", MainContents);
+  ASSERT_TRUE(Reused.hasValue());
+  EXPECT_EQ(Built->PCHPath, Reused->PCHPath);
+  EXPECT_EQ(BuiltID, getID(*Reused));
+
+  // Files with the same preamble and flags in the same directory share it.
+  auto Shared = getPreamble("other.cpp", MainContents);
+  ASSERT_TRUE(Shared.hasValue());
+  EXPECT_EQ(Built->PCHPath, Shared->PCHPath);
+  EXPECT_EQ(BuiltID, getID(*Shared));
+
+  // The header changed size, so the preamble is rebuilt in place.
+  writeFile("header.h", "int g();\nint h();\n");
+  auto Rebuilt = getPreamble("main.cpp", MainContents);
+  ASSERT_TRUE(Rebuilt.hasValue());
+  EXPECT_EQ(Built->PCHPath, Rebuilt->PCHPath);
+  EXPECT_NE(BuiltID, getID(*Rebuilt));
+}
+
+TEST_F(PreambleStoreTest, NoPreamble) {
+  EXPECT_FALSE(getPreamble("main.cpp", "int f() { return 0; }\n").hasValue());
+}
+
+TEST_F(PreambleStoreTest, PreambleWithErrors) {
+  // header.h doesn't exist.
+  EXPECT_FALSE(getPreamble("main.cpp", MainContents).hasValue());
+}
+
+} // namespace
+} // namespace preamble
+} // namespace clang